@@ -0,0 +1,66 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Kernel benchmark for the compositional model based on flash calculations
+ */
+#include "config.h"
+
+#include "kernelbenchmark.hh"
+
+#if HAVE_QUAD
+#include <opm/material/common/quad.hpp>
+#endif
+
+#include <ewoms/models/flash/flashmodel.hh>
+#include <ewoms/disc/ecfv/ecfvdiscretization.hh>
+#include "../tests/problems/co2injectionflash.hh"
+#include "../tests/problems/co2injectionproblem.hh"
+
+BEGIN_PROPERTIES
+
+NEW_TYPE_TAG(Co2InjectionFlashEcfvKernelBenchmark,
+             INHERITS_FROM(FlashModel, Co2InjectionBaseProblem, KernelBenchmark));
+SET_TAG_PROP(Co2InjectionFlashEcfvKernelBenchmark, SpatialDiscretizationSplice, EcfvDiscretization);
+SET_TAG_PROP(Co2InjectionFlashEcfvKernelBenchmark, LocalLinearizerSplice, AutoDiffLocalLinearizer);
+
+// use the flash solver adapted to the CO2 injection problem
+SET_TYPE_PROP(
+    Co2InjectionFlashEcfvKernelBenchmark, FlashSolver,
+    Ewoms::Co2InjectionFlash<typename GET_PROP_TYPE(TypeTag, Scalar),
+                             typename GET_PROP_TYPE(TypeTag, FluidSystem)>);
+
+// use the same scalar type as the co2injection_flash_ecfv test
+#if HAVE_QUAD
+SET_TYPE_PROP(Co2InjectionFlashEcfvKernelBenchmark, Scalar, quad);
+SET_TAG_PROP(Co2InjectionFlashEcfvKernelBenchmark, LinearSolverSplice, ParallelBiCGStabLinearSolver);
+#endif
+
+END_PROPERTIES
+
+int main(int argc, char **argv)
+{
+    typedef TTAG(Co2InjectionFlashEcfvKernelBenchmark) BenchmarkTypeTag;
+    return Ewoms::runKernelBenchmark<BenchmarkTypeTag>(argc, argv, "bench_co2injection_flash_ecfv");
+}
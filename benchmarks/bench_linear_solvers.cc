@@ -0,0 +1,330 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Benchmarks the available linear solvers and preconditioners on linear systems
+ *        which were written by Ewoms::Linear::ParallelBaseBackend.
+ *
+ * The linear systems are written if the --linear-system-dump-file parameter is
+ * specified for a simulation. If the simulation was run in parallel, the files of all
+ * processes for the same time step and Newton iteration must be passed to this program.
+ */
+#include "config.h"
+
+#include <ewoms/linear/linearsystemdump.hh>
+#include <ewoms/linear/bicgstabsolver.hh>
+#include <ewoms/linear/residreductioncriterion.hh>
+#include <ewoms/common/timer.hh>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/version.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/scalarproducts.hh>
+#include <dune/istl/paamg/amg.hh>
+#if HAVE_SUPERLU
+#include <dune/istl/superlu.hh>
+#endif
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+struct Options
+{
+    unsigned repetitions = 3;
+    double tolerance = 1e-5;
+    unsigned maxIterations = 1000;
+    int coarsenTarget = 5000;
+    std::vector<std::string> files;
+};
+
+void printUsage(const char* progName)
+{
+    std::cout << "Benchmarks the available linear solvers on a captured linear system\n"
+              << "\n"
+              << "Usage: " << progName << " [OPTIONS] FILE [FILE ...]\n"
+              << "\n"
+              << "The files must contain the parts of a single linear system written by the\n"
+              << "processes of a simulation run using --linear-system-dump-file.\n"
+              << "\n"
+              << "Options:\n"
+              << "  --repetitions=N       Number of times each solver is run (default: 3)\n"
+              << "  --tolerance=X         Required reduction of the residual (default: 1e-5)\n"
+              << "  --max-iterations=N    Maximum number of iterations (default: 1000)\n"
+              << "  --amg-coarsen-target=N  Coarsening target of the AMG (default: 5000)\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        size_t eqPos = arg.find('=');
+        std::string key = arg.substr(0, eqPos);
+        std::string value = (eqPos == std::string::npos) ? "" : arg.substr(eqPos + 1);
+
+        if (key == "--repetitions")
+            options.repetitions = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (key == "--tolerance")
+            options.tolerance = std::strtod(value.c_str(), nullptr);
+        else if (key == "--max-iterations")
+            options.maxIterations = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (key == "--amg-coarsen-target")
+            options.coarsenTarget = std::atoi(value.c_str());
+        else if (arg.size() > 2 && arg.substr(0, 2) == "--")
+            return false;
+        else
+            options.files.push_back(arg);
+    }
+
+    return !options.files.empty() && options.repetitions > 0;
+}
+
+void printResult(const std::string& name,
+                 double setupTime,
+                 double solveTime,
+                 unsigned iterations,
+                 bool converged)
+{
+    std::cout << std::left << std::setw(24) << name << std::right
+              << std::scientific << std::setprecision(3)
+              << std::setw(14) << setupTime
+              << std::setw(12) << iterations
+              << std::setw(14) << solveTime
+              << std::setw(16) << ((iterations > 0) ? solveTime/iterations : 0.0)
+              << std::setw(11) << (converged ? "yes" : "no")
+              << "\n" << std::flush;
+}
+
+template <int blockSize>
+class LinearSolverBenchmark
+{
+    typedef Dune::FieldMatrix<double, blockSize, blockSize> MatrixBlock;
+    typedef Dune::FieldVector<double, blockSize> VectorBlock;
+    typedef Dune::BCRSMatrix<MatrixBlock> Matrix;
+    typedef Dune::BlockVector<VectorBlock> Vector;
+
+    typedef Dune::MatrixAdapter<Matrix, Vector, Vector> Operator;
+    typedef Dune::Preconditioner<Vector, Vector> Preconditioner;
+    typedef Ewoms::Linear::BiCGStabSolver<Operator, Vector, Preconditioner> Solver;
+
+    typedef Dune::SeqSOR<Matrix, Vector, Vector> AmgSmoother;
+    typedef Dune::Amg::AMG<Operator, Vector, AmgSmoother> Amg;
+
+public:
+    LinearSolverBenchmark(const std::vector<Ewoms::Linear::LinearSystemDump>& parts,
+                          const Options& options)
+        : options_(options)
+    {
+        Ewoms::Linear::LinearSystemDump::assemble(parts, A_, b_);
+        std::cout << "Linear system: " << A_.N() << " rows, " << A_.nonzeroes()
+                  << " non-zero blocks, block size " << blockSize << "\n\n";
+    }
+
+    void run()
+    {
+        std::cout << std::left << std::setw(24) << "Solver" << std::right
+                  << std::setw(14) << "setup [s]"
+                  << std::setw(12) << "iterations"
+                  << std::setw(14) << "solve [s]"
+                  << std::setw(16) << "s/iteration"
+                  << std::setw(11) << "converged"
+                  << "\n";
+
+        runIterative_("BiCGStab+ILU0",
+                      [this]()
+                      {
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,7)
+                          return std::make_shared<Dune::SeqILU<Matrix, Vector, Vector> >(A_, /*n=*/0, /*w=*/1.0);
+#else
+                          return std::make_shared<Dune::SeqILU0<Matrix, Vector, Vector> >(A_, /*w=*/1.0);
+#endif
+                      });
+        runIterative_("BiCGStab+Jacobi",
+                      [this]()
+                      { return std::make_shared<Dune::SeqJac<Matrix, Vector, Vector> >(A_, /*n=*/1, /*w=*/1.0); });
+        runIterative_("BiCGStab+SOR",
+                      [this]()
+                      { return std::make_shared<Dune::SeqSOR<Matrix, Vector, Vector> >(A_, /*n=*/1, /*w=*/1.0); });
+        runIterative_("BiCGStab+AMG",
+                      [this]()
+                      { return createAmg_(); });
+#if HAVE_SUPERLU
+        runSuperLU_();
+#endif
+    }
+
+private:
+    // run the BiCGStab solver of eWoms with a given preconditioner. the setup time is
+    // the time which is required to create the preconditioner.
+    template <class CreatePreconditionerFn>
+    void runIterative_(const std::string& name, const CreatePreconditionerFn& createPreconditioner)
+    {
+        Ewoms::Timer setupTimer;
+        Ewoms::Timer solveTimer;
+        unsigned iterations = 0;
+        bool converged = true;
+
+        for (unsigned repIdx = 0; repIdx < options_.repetitions; ++repIdx) {
+            setupTimer.start();
+            auto preconditioner = createPreconditioner();
+            setupTimer.stop();
+
+            Dune::SeqScalarProduct<Vector> scalarProduct;
+            Ewoms::Linear::ResidReductionCriterion<Vector> convergenceCriterion(scalarProduct,
+                                                                                options_.tolerance);
+            Solver solver(*preconditioner, convergenceCriterion, scalarProduct);
+            solver.setMaxIterations(options_.maxIterations);
+            solver.setLinearOperator(&operator_());
+            solver.setRhs(&b_);
+
+            Vector x(b_.size());
+            solveTimer.start();
+            converged = solver.apply(x) && converged;
+            solveTimer.stop();
+            iterations += solver.report().iterations();
+        }
+
+        unsigned n = options_.repetitions;
+        printResult(name,
+                    setupTimer.realTimeElapsed()/n,
+                    solveTimer.realTimeElapsed()/n,
+                    iterations/n,
+                    converged);
+    }
+
+#if HAVE_SUPERLU
+    // run the SuperLU direct solver. the setup time is the time needed for the
+    // factorization of the matrix
+    void runSuperLU_()
+    {
+        Ewoms::Timer setupTimer;
+        Ewoms::Timer solveTimer;
+        bool converged = true;
+
+        for (unsigned repIdx = 0; repIdx < options_.repetitions; ++repIdx) {
+            setupTimer.start();
+            Dune::SuperLU<Matrix> solver(A_, /*verbose=*/false);
+            setupTimer.stop();
+
+            Vector x(b_.size());
+            Vector b(b_);
+            Dune::InverseOperatorResult result;
+            solveTimer.start();
+            solver.apply(x, b, result);
+            solveTimer.stop();
+            converged = result.converged && converged;
+        }
+
+        unsigned n = options_.repetitions;
+        printResult("SuperLU",
+                    setupTimer.realTimeElapsed()/n,
+                    solveTimer.realTimeElapsed()/n,
+                    /*iterations=*/1,
+                    converged);
+    }
+#endif
+
+    std::shared_ptr<Amg> createAmg_()
+    {
+        typedef typename Dune::Amg::SmootherTraits<AmgSmoother>::Arguments SmootherArgs;
+        SmootherArgs smootherArgs;
+        smootherArgs.iterations = 1;
+        smootherArgs.relaxationFactor = 1.0;
+
+        // use the same settings as Ewoms::Linear::ParallelAmgBackend
+        typedef Dune::Amg::
+            CoarsenCriterion<Dune::Amg::SymmetricCriterion<Matrix, Dune::Amg::FrobeniusNorm> >
+            CoarsenCriterion;
+        CoarsenCriterion coarsenCriterion(/*maxLevel=*/15, options_.coarsenTarget);
+        coarsenCriterion.setDebugLevel(0);
+        coarsenCriterion.setMinCoarsenRate(1.05);
+        coarsenCriterion.setAccumulate(Dune::Amg::atOnceAccu);
+        coarsenCriterion.setSkipIsolated(false);
+
+        return std::make_shared<Amg>(operator_(), coarsenCriterion, smootherArgs);
+    }
+
+    Operator& operator_()
+    {
+        if (!operatorPtr_)
+            operatorPtr_.reset(new Operator(A_));
+        return *operatorPtr_;
+    }
+
+    const Options& options_;
+    Matrix A_;
+    Vector b_;
+    std::unique_ptr<Operator> operatorPtr_;
+};
+
+template <int blockSize>
+void runBenchmark(const std::vector<Ewoms::Linear::LinearSystemDump>& parts, const Options& options)
+{
+    LinearSolverBenchmark<blockSize> benchmark(parts, options);
+    benchmark.run();
+}
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::vector<Ewoms::Linear::LinearSystemDump> parts(options.files.size());
+        for (size_t i = 0; i < options.files.size(); ++i)
+            parts[i].read(options.files[i]);
+
+        // the block size must be known at compile time
+        switch (parts[0].blockSize()) {
+        case 1: runBenchmark<1>(parts, options); break;
+        case 2: runBenchmark<2>(parts, options); break;
+        case 3: runBenchmark<3>(parts, options); break;
+        case 4: runBenchmark<4>(parts, options); break;
+        case 5: runBenchmark<5>(parts, options); break;
+        case 6: runBenchmark<6>(parts, options); break;
+        default:
+            std::cerr << "Linear systems with a block size of " << parts[0].blockSize()
+                      << " are not supported\n";
+            return 1;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,412 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::KernelBenchmark
+ */
+#ifndef EWOMS_KERNEL_BENCHMARK_HH
+#define EWOMS_KERNEL_BENCHMARK_HH
+
+#include <ewoms/common/start.hh>
+#include <ewoms/parallel/collectivecontext.hh>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <set>
+#include <string>
+#include <vector>
+
+BEGIN_PROPERTIES
+
+NEW_TYPE_TAG(KernelBenchmark);
+
+//! The number of times each kernel is applied to all elements of the grid
+NEW_PROP_TAG(BenchmarkRepetitions);
+
+//! The name of the JSON file to which the results are written (empty: no file)
+NEW_PROP_TAG(BenchmarkOutputFile);
+
+SET_INT_PROP(KernelBenchmark, BenchmarkRepetitions, 5);
+SET_STRING_PROP(KernelBenchmark, BenchmarkOutputFile, "");
+
+END_PROPERTIES
+
+//! \cond SKIP_THIS
+namespace Ewoms {
+namespace Benchmark {
+// the number of heap allocations done by the program so far
+inline std::atomic<unsigned long>& numAllocations()
+{
+    static std::atomic<unsigned long> n(0);
+    return n;
+}
+}} // namespace Benchmark, Ewoms
+
+// count the heap allocations. since these are replacements of the global allocation
+// functions, this header must only be included by a single compile unit of each
+// benchmark executable.
+void* operator new(std::size_t size)
+{
+    ++ Ewoms::Benchmark::numAllocations();
+    void* ptr = std::malloc(size > 0 ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{ std::free(ptr); }
+//! \endcond
+
+namespace Ewoms {
+/*!
+ * \brief Measures the performance of the hot kernels of the finite volume
+ *        discretizations in isolation.
+ *
+ * Each kernel is applied to all interior elements of the grid a number of times. The
+ * time per element and the number of heap allocations per call of the kernel are
+ * reported. The size of the synthetic grid is controlled by the usual parameters of the
+ * problem's vanguard, e.g., --cells-x or --grid-global-refinements.
+ */
+template <class TypeTag>
+class KernelBenchmark
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
+    typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
+    typedef typename GET_PROP_TYPE(TypeTag, Stencil) Stencil;
+    typedef typename GET_PROP_TYPE(TypeTag, SparseMatrixAdapter) SparseMatrixAdapter;
+    typedef typename GridView::template Codim<0>::Entity Element;
+
+    typedef std::chrono::steady_clock Clock;
+
+public:
+    struct Result
+    {
+        std::string name;
+        double nsPerElement;
+        double allocationsPerCall;
+    };
+
+    KernelBenchmark(Simulator& simulator)
+        : simulator_(simulator)
+        , elemCtx_(simulator)
+        , stencil_(simulator.gridView(), simulator.model().dofMapper())
+    {
+        repetitions_ = static_cast<unsigned>(EWOMS_GET_PARAM(TypeTag, int, BenchmarkRepetitions));
+        numElements_ = 0;
+        auto elemIt = simulator_.gridView().template begin</*codim=*/0>();
+        const auto& elemEndIt = simulator_.gridView().template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt)
+            if (elemIt->partitionType() == Dune::InteriorEntity)
+                ++ numElements_;
+    }
+
+    /*!
+     * \brief Register the run-time parameters of the benchmark.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, int, BenchmarkRepetitions,
+                             "The number of times each kernel is applied to all elements");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, BenchmarkOutputFile,
+                             "The name of the JSON file to which the results are written");
+    }
+
+    /*!
+     * \brief Run all kernels.
+     */
+    void run()
+    {
+        auto& model = simulator_.model();
+        auto& localLinearizer = model.localLinearizer(/*threadId=*/0);
+        auto& linearizer = model.linearizer();
+
+        model.applyInitialSolution();
+
+        // make sure that the global linear system exists
+        linearizer.linearizeDomain();
+
+        measure_("Stencil::update",
+                 [](const Element&) {},
+                 [&](const Element& elem) { stencil_.update(elem); });
+
+        measure_("ElementContext::updateAll",
+                 [](const Element&) {},
+                 [&](const Element& elem) { elemCtx_.updateAll(elem); });
+
+        measure_("IntensiveQuantities::update",
+                 [&](const Element& elem) { elemCtx_.updateStencil(elem); },
+                 [&](const Element&) { elemCtx_.updateIntensiveQuantities(/*timeIdx=*/0); });
+
+        measure_("ExtensiveQuantities::update",
+                 [&](const Element& elem)
+                 {
+                     elemCtx_.updateStencil(elem);
+                     elemCtx_.updateAllIntensiveQuantities();
+                 },
+                 [&](const Element&) { elemCtx_.updateAllExtensiveQuantities(); });
+
+        measure_("LocalLinearizer::linearize",
+                 [](const Element&) {},
+                 [&](const Element& elem) { localLinearizer.linearize(elemCtx_, elem); });
+
+        measure_("LocalLinearizer::evalResidual",
+                 [](const Element&) {},
+                 [&](const Element& elem) { localLinearizer.evalResidual(elemCtx_, elem); });
+
+        auto& jacobian = linearizer.jacobian();
+        auto& residual = linearizer.residual();
+        measure_("global scatter",
+                 [&](const Element& elem) { localLinearizer.linearize(elemCtx_, elem); },
+                 [&](const Element&)
+                 {
+                     size_t numPrimaryDof = elemCtx_.numPrimaryDof(/*timeIdx=*/0);
+                     size_t numDof = elemCtx_.numDof(/*timeIdx=*/0);
+                     for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
+                         unsigned globI = elemCtx_.globalSpaceIndex(primaryDofIdx, /*timeIdx=*/0);
+                         residual[globI] += localLinearizer.residual(primaryDofIdx);
+
+                         for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx) {
+                             unsigned globJ = elemCtx_.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+                             jacobian.addToBlock(globJ, globI,
+                                                 localLinearizer.jacobian(dofIdx, primaryDofIdx));
+                         }
+                     }
+                 });
+
+        measureGlobal_("sparsity pattern creation",
+                       [&]() { createMatrix_(); });
+
+        // compare the full linearization of the domain with an evaluation of its residual
+        measureGlobal_("Linearizer::linearizeDomain",
+                       [&]() { linearizer.linearizeDomain(); });
+
+        CollectiveContext collectives(simulator_.gridView().comm());
+        measureGlobal_("Linearizer::linearizeResidual",
+                       [&]()
+                       {
+                           collectives.clear();
+                           linearizer.linearizeResidual(collectives);
+                       });
+    }
+
+    /*!
+     * \brief Returns the results of all kernels.
+     */
+    const std::vector<Result>& results() const
+    { return results_; }
+
+    /*!
+     * \brief Print a table of the results.
+     */
+    void print(std::ostream& os) const
+    {
+        os << "Number of elements: " << numElements_ << ", repetitions: " << repetitions_ << "\n";
+        os << std::left << std::setw(32) << "Kernel" << std::right
+           << std::setw(16) << "ns/element"
+           << std::setw(16) << "allocs/call" << "\n";
+        for (const auto& result : results_)
+            os << std::left << std::setw(32) << result.name << std::right
+               << std::fixed << std::setprecision(1)
+               << std::setw(16) << result.nsPerElement
+               << std::setprecision(2)
+               << std::setw(16) << result.allocationsPerCall << "\n";
+        os.unsetf(std::ios_base::floatfield);
+    }
+
+    /*!
+     * \brief Write the results to a JSON file which can be used to track regressions.
+     */
+    void writeJson(const std::string& fileName, const std::string& benchmarkName) const
+    {
+        std::ofstream os(fileName);
+        os << std::setprecision(8)
+           << "{\n"
+           << "  \"benchmark\": \"" << benchmarkName << "\",\n"
+           << "  \"numElements\": " << numElements_ << ",\n"
+           << "  \"repetitions\": " << repetitions_ << ",\n"
+           << "  \"kernels\": [\n";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const auto& result = results_[i];
+            os << "    { \"name\": \"" << result.name << "\""
+               << ", \"nsPerElement\": " << result.nsPerElement
+               << ", \"allocationsPerCall\": " << result.allocationsPerCall
+               << " }" << ((i + 1 < results_.size()) ? "," : "") << "\n";
+        }
+        os << "  ]\n"
+           << "}\n";
+    }
+
+private:
+    // apply a kernel to all interior elements. only the time spent in the kernel itself
+    // is measured, the preparation step is not.
+    template <class PrepareFn, class KernelFn>
+    void measure_(const std::string& name, const PrepareFn& prepare, const KernelFn& kernel)
+    {
+        Clock::duration kernelTime(0);
+        unsigned long numAllocs = 0;
+        unsigned long numCalls = 0;
+        for (unsigned repIdx = 0; repIdx < repetitions_; ++repIdx) {
+            auto elemIt = simulator_.gridView().template begin</*codim=*/0>();
+            const auto& elemEndIt = simulator_.gridView().template end</*codim=*/0>();
+            for (; elemIt != elemEndIt; ++elemIt) {
+                const Element& elem = *elemIt;
+                if (elem.partitionType() != Dune::InteriorEntity)
+                    continue;
+
+                prepare(elem);
+
+                unsigned long allocsBefore = Benchmark::numAllocations();
+                auto startTime = Clock::now();
+                kernel(elem);
+                kernelTime += Clock::now() - startTime;
+                numAllocs += Benchmark::numAllocations() - allocsBefore;
+                ++ numCalls;
+            }
+        }
+
+        addResult_(name, kernelTime, numAllocs, numCalls);
+    }
+
+    // apply a kernel which deals with the whole grid at once
+    template <class KernelFn>
+    void measureGlobal_(const std::string& name, const KernelFn& kernel)
+    {
+        Clock::duration kernelTime(0);
+        unsigned long numAllocs = 0;
+        for (unsigned repIdx = 0; repIdx < repetitions_; ++repIdx) {
+            unsigned long allocsBefore = Benchmark::numAllocations();
+            auto startTime = Clock::now();
+            kernel();
+            kernelTime += Clock::now() - startTime;
+            numAllocs += Benchmark::numAllocations() - allocsBefore;
+        }
+
+        addResult_(name, kernelTime, numAllocs, repetitions_);
+    }
+
+    void addResult_(const std::string& name,
+                    Clock::duration kernelTime,
+                    unsigned long numAllocs,
+                    unsigned long numCalls)
+    {
+        std::chrono::duration<double, std::nano> ns = kernelTime;
+        Result result;
+        result.name = name;
+        result.nsPerElement = ns.count()/std::max<double>(1.0, repetitions_*numElements_);
+        result.allocationsPerCall = static_cast<double>(numAllocs)/std::max<double>(1.0, numCalls);
+        results_.push_back(result);
+    }
+
+    // create the sparsity pattern of the Jacobian matrix the same way as
+    // FvBaseLinearizer does it
+    void createMatrix_()
+    {
+        const auto& model = simulator_.model();
+        std::vector<std::set<unsigned> > sparsityPattern(model.numTotalDof());
+
+        auto elemIt = simulator_.gridView().template begin</*codim=*/0>();
+        const auto& elemEndIt = simulator_.gridView().template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            stencil_.update(*elemIt);
+
+            for (unsigned primaryDofIdx = 0; primaryDofIdx < stencil_.numPrimaryDof(); ++primaryDofIdx) {
+                unsigned myIdx = stencil_.globalSpaceIndex(primaryDofIdx);
+
+                for (unsigned dofIdx = 0; dofIdx < stencil_.numDof(); ++dofIdx)
+                    sparsityPattern[myIdx].insert(stencil_.globalSpaceIndex(dofIdx));
+            }
+        }
+
+        for (unsigned auxModIdx = 0; auxModIdx < model.numAuxiliaryModules(); ++auxModIdx)
+            model.auxiliaryModule(auxModIdx)->addNeighbors(sparsityPattern);
+
+        SparseMatrixAdapter matrix(simulator_);
+        matrix.reserve(sparsityPattern);
+    }
+
+    Simulator& simulator_;
+    ElementContext elemCtx_;
+    Stencil stencil_;
+
+    unsigned repetitions_;
+    unsigned numElements_;
+    std::vector<Result> results_;
+};
+
+/*!
+ * \brief Provides a main function for the kernel benchmarks of a problem.
+ *
+ * \param benchmarkName The name of the benchmark which is used in the JSON output
+ */
+template <class TypeTag>
+int runKernelBenchmark(int argc, char **argv, const std::string& benchmarkName)
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
+
+    registerAllParameters_<TypeTag>(/*finalizeRegistration=*/false);
+    KernelBenchmark<TypeTag>::registerParameters();
+    EWOMS_END_PARAM_REGISTRATION(TypeTag);
+
+    int paramStatus = setupParameters_<TypeTag>(argc,
+                                                const_cast<const char**>(argv),
+                                                /*registerParams=*/false);
+    if (paramStatus == 1)
+        return 1;
+    if (paramStatus == 2)
+        return 0;
+
+    ThreadManager::init();
+#if HAVE_DUNE_FEM
+    Dune::Fem::MPIManager::initialize(argc, argv);
+#else
+    Dune::MPIHelper::instance(argc, argv);
+#endif
+
+    Simulator simulator(/*verbose=*/false);
+    KernelBenchmark<TypeTag> benchmark(simulator);
+    benchmark.run();
+
+    if (simulator.gridView().comm().rank() == 0) {
+        std::cout << "Kernel benchmark '" << benchmarkName << "':\n";
+        benchmark.print(std::cout);
+        std::cout << std::flush;
+
+        const std::string& outputFile = EWOMS_GET_PARAM(TypeTag, std::string, BenchmarkOutputFile);
+        if (!outputFile.empty())
+            benchmark.writeJson(outputFile, benchmarkName);
+    }
+
+    return 0;
+}
+} // namespace Ewoms
+
+#endif
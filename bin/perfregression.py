@@ -0,0 +1,193 @@
+#! /usr/bin/env python3
+#
+# Runs a subset of the test problems at increased grid refinement and
+# compares their run times against a stored baseline.
+#
+# Usage:
+#
+# perfregression.py [OPTIONS] [TEST_NAME ...]
+#
+# The script must be called from the build directory. Each problem is
+# run several times for each combination of the number of processes
+# and threads. The timing receipt which is written by
+# FvBaseProblem::finalize() using --timing-receipt-file is then used
+# to determine the median time spent in each phase of the
+# simulation. If a baseline is given, the median execution time of
+# each run is compared to that of the baseline and the script exits
+# with a non-zero code if it is slower by more than the noise
+# threshold.
+#
+import argparse
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+
+# the problems which are run by default together with the arguments
+# required to make them run for a reasonable amount of time
+DEFAULT_TESTS = {
+    "lens_immiscible_ecfv_ad": ["--end-time=3000"],
+    "lens_immiscible_vcfv_ad": ["--end-time=3000"],
+    "powerinjection_darcy_ad": [],
+    "powerinjection_forchheimer_ad": [],
+    "co2injection_immiscible_ecfv": [],
+    "co2injection_flash_ecfv": [],
+    "reservoir_blackoil_ecfv": ["--end-time=8750000"],
+}
+
+# the fields of the timing receipt which are compared against the
+# baseline and reported
+TIMING_FIELDS = [
+    "executionTime",
+    "linearizeTime",
+    "solveTime",
+    "linearSolverSetupTime",
+    "linearSolverIterationTime",
+    "updateTime",
+    "writeTime",
+]
+
+
+def findBinary(testName):
+    for root, dirs, files in os.walk("."):
+        if testName in files:
+            path = os.path.join(root, testName)
+            if os.access(path, os.X_OK):
+                return path
+    return None
+
+
+def runOnce(binary, args, numProcs, numThreads, mpiRunner):
+    receiptDir = tempfile.mkdtemp(prefix="perfregression-")
+    try:
+        receiptFile = os.path.join(receiptDir, "receipt.json")
+        cmd = [binary] + args + ["--threads-per-process=%d" % numThreads,
+                                 "--output-dir=%s" % receiptDir,
+                                 "--enable-vtk-output=false",
+                                 "--timing-receipt-file=%s" % receiptFile]
+        if numProcs > 1:
+            cmd = [mpiRunner, "-np", str(numProcs)] + cmd
+
+        result = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                                universal_newlines=True)
+        if result.returncode != 0:
+            raise RuntimeError("'%s' failed with exit code %d:\n%s"
+                               % (" ".join(cmd), result.returncode, result.stderr))
+
+        with open(receiptFile) as f:
+            return json.load(f)
+    finally:
+        shutil.rmtree(receiptDir, ignore_errors=True)
+
+
+def runKey(numProcs, numThreads):
+    return "p%d-t%d" % (numProcs, numThreads)
+
+
+def summarize(receipts):
+    summary = {}
+    for field in TIMING_FIELDS:
+        values = [r.get(field, 0.0) for r in receipts]
+        summary[field] = {
+            "median": statistics.median(values),
+            "min": min(values),
+            "max": max(values),
+        }
+    summary["numDof"] = receipts[0].get("numDof", 0)
+    summary["numTimeSteps"] = receipts[0].get("numTimeSteps", 0)
+    return summary
+
+
+def compare(results, baseline, threshold):
+    regressions = []
+    for testName, runs in sorted(results.items()):
+        for key, summary in sorted(runs.items()):
+            baseSummary = baseline.get(testName, {}).get(key)
+            if baseSummary is None:
+                print("%-32s %-8s no baseline" % (testName, key))
+                continue
+
+            for field in TIMING_FIELDS:
+                cur = summary[field]["median"]
+                base = baseSummary[field]["median"]
+                if base <= 0.0:
+                    continue
+                ratio = cur/base
+                if field == "executionTime" or ratio > 1.0 + threshold:
+                    flag = "REGRESSION" if ratio > 1.0 + threshold else ""
+                    print("%-32s %-8s %-26s %10.3f s %10.3f s %+7.1f%% %s"
+                          % (testName, key, field, base, cur, (ratio - 1.0)*100, flag))
+                if field == "executionTime" and ratio > 1.0 + threshold:
+                    regressions.append((testName, key))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the test problems and check for performance regressions")
+    parser.add_argument("tests", nargs="*",
+                        help="the tests to run (default: %s)" % ", ".join(sorted(DEFAULT_TESTS)))
+    parser.add_argument("--refinement", type=int, default=1,
+                        help="the number of global grid refinements (default: 1)")
+    parser.add_argument("--repetitions", type=int, default=3,
+                        help="the number of runs per configuration (default: 3)")
+    parser.add_argument("--threads", default="1",
+                        help="comma separated list of the number of threads per process (default: 1)")
+    parser.add_argument("--processes", default="1",
+                        help="comma separated list of the number of MPI processes (default: 1)")
+    parser.add_argument("--mpirun", default="mpirun",
+                        help="the command used to start parallel runs (default: mpirun)")
+    parser.add_argument("--output", default="perfregression.json",
+                        help="the file to which the results are written (default: perfregression.json)")
+    parser.add_argument("--baseline",
+                        help="the results of a previous run which the current run is compared against")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="the relative slowdown which is considered to be noise (default: 0.05)")
+    options = parser.parse_args()
+
+    testNames = options.tests or sorted(DEFAULT_TESTS)
+    threadList = [int(n) for n in options.threads.split(",")]
+    procList = [int(n) for n in options.processes.split(",")]
+
+    results = {}
+    for testName in testNames:
+        binary = findBinary(testName)
+        if binary is None:
+            print("Binary for test '%s' not found. Skipping it." % testName, file=sys.stderr)
+            continue
+
+        args = list(DEFAULT_TESTS.get(testName, []))
+        if options.refinement > 0:
+            args.append("--grid-global-refinements=%d" % options.refinement)
+
+        results[testName] = {}
+        for numProcs in procList:
+            for numThreads in threadList:
+                key = runKey(numProcs, numThreads)
+                receipts = []
+                for repIdx in range(options.repetitions):
+                    print("Running %s (%s, repetition %d of %d)"
+                          % (testName, key, repIdx + 1, options.repetitions), flush=True)
+                    receipts.append(runOnce(binary, args, numProcs, numThreads, options.mpirun))
+                results[testName][key] = summarize(receipts)
+
+    with open(options.output, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+    print("Results written to '%s'" % options.output)
+
+    if options.baseline:
+        with open(options.baseline) as f:
+            baseline = json.load(f)
+        regressions = compare(results, baseline, options.threshold)
+        if regressions:
+            print("%d performance regression(s) detected" % len(regressions))
+            return 1
+        print("No performance regressions detected")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
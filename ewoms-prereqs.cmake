@@ -15,6 +15,8 @@ set (ewoms_CONFIG_VAR
   HAVE_DUNE_FEM
   HAVE_ECL_INPUT
   HAVE_ECL_OUTPUT
+  HAVE_ZLIB
+  EWOMS_ENABLE_PROFILING
   DUNE_AVOID_CAPABILITIES_IS_PARALLEL_DEPRECATION_WARNING
   )
 
@@ -40,6 +42,8 @@ set (ewoms_DEPS
   "Valgrind"
   # quadruple precision floating point calculations
   "Quadmath"
+  # compression of the VTK output
+  "ZLIB"
   )
 
 find_package_deps(ewoms)
@@ -84,6 +84,10 @@ NEW_PROP_TAG(GridPart);
 //! after creation.
 NEW_PROP_TAG(GridGlobalRefinements);
 
+//! Property which specifies the directory in which the Vanguard caches the grids it has
+//! created. If it is empty, no grids are cached.
+NEW_PROP_TAG(GridCacheDirectory);
+
 //! Property provides the name of the file from which the additional runtime
 //! parameters should to be loaded from
 NEW_PROP_TAG(ParameterFile);
@@ -116,6 +120,22 @@ NEW_PROP_TAG(RestartTime);
 //! The name of the file with a number of forced time step lengths
 NEW_PROP_TAG(PredeterminedTimeStepsFile);
 
+//! Print the imbalance of the solver phases across the processes after each time step
+NEW_PROP_TAG(EnableLoadImbalanceLog);
+
+/*!
+ * \brief The name of the file to which the performance of each time step is logged.
+ *
+ * If the name ends with ".csv", comma separated values are written, else JSON Lines.
+ */
+NEW_PROP_TAG(PerformanceLogFile);
+
+//! Read the hardware performance counters for the phases of the solver
+NEW_PROP_TAG(EnablePerfCounters);
+
+//! Print the memory used by the major data structures during the simulation
+NEW_PROP_TAG(EnableMemoryReport);
+
 ///////////////////////////////////
 // Values for the properties
 ///////////////////////////////////
@@ -167,6 +187,9 @@ SET_STRING_PROP(NumericModel, ParameterFile, "");
 //! here, strictly speaking.
 SET_INT_PROP(NumericModel, GridGlobalRefinements, 0);
 
+//! Do not cache grids by default
+SET_STRING_PROP(NumericModel, GridCacheDirectory, "");
+
 //! By default, print the properties on startup
 SET_INT_PROP(NumericModel, PrintProperties, 2);
 
@@ -185,6 +208,18 @@ SET_SCALAR_PROP(NumericModel, RestartTime, -1e35);
 //! By default, do not force any time steps
 SET_STRING_PROP(NumericModel, PredeterminedTimeStepsFile, "");
 
+//! By default, only report the load imbalance at the end of the simulation
+SET_BOOL_PROP(NumericModel, EnableLoadImbalanceLog, false);
+
+//! By default, the performance of the time steps is not logged
+SET_STRING_PROP(NumericModel, PerformanceLogFile, "");
+
+//! Reading the hardware performance counters is disabled by default
+SET_BOOL_PROP(NumericModel, EnablePerfCounters, false);
+
+//! By default, only the peak memory usage is reported at the end of the simulation
+SET_BOOL_PROP(NumericModel, EnableMemoryReport, false);
+
 
 END_PROPERTIES
 
@@ -0,0 +1,75 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::InnerIterationCounter
+ */
+#ifndef EWOMS_INNER_ITERATION_COUNTER_HH
+#define EWOMS_INNER_ITERATION_COUNTER_HH
+
+namespace Ewoms {
+/*!
+ * \ingroup Common
+ *
+ * \brief Counts the iterations of the local non-linear solvers which are used while
+ *        evaluating the quantities of an element.
+ *
+ * Examples of such solvers are the Newton method which determines the Forchheimer
+ * velocity and the flash calculations of the compositional models. (Since the flash
+ * solvers do not report the number of iterations they needed, each flash calculation
+ * counts as a single iteration.) The counter is thread-local, so every thread which
+ * linearizes elements sees only its own iterations.
+ */
+class InnerIterationCounter
+{
+public:
+    /*!
+     * \brief Add a number of iterations to the counter of the current thread.
+     */
+    static void add(unsigned numIterations = 1)
+    { counter_() += numIterations; }
+
+    /*!
+     * \brief Reset the counter of the current thread to zero.
+     *
+     * The value of the counter before the reset is returned.
+     */
+    static unsigned reset()
+    {
+        unsigned& counter = counter_();
+        unsigned result = counter;
+        counter = 0;
+        return result;
+    }
+
+private:
+    static unsigned& counter_()
+    {
+        static thread_local unsigned counter = 0;
+        return counter;
+    }
+};
+} // namespace Ewoms
+
+#endif
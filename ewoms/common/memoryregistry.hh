@@ -0,0 +1,246 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::MemoryRegistry
+ */
+#ifndef EWOMS_MEMORY_REGISTRY_HH
+#define EWOMS_MEMORY_REGISTRY_HH
+
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace Ewoms {
+/*!
+ * \ingroup Common
+ *
+ * \brief Collects the amount of memory occupied by the major data structures of a
+ *        simulation.
+ *
+ * Each component adds a function which returns the number of bytes currently used by
+ * one of its containers. These functions are only called when a report is requested,
+ * so registering a component does not cause any overhead during the simulation. The
+ * reported sizes are estimates: they account for the payload of the containers, but not
+ * for the overhead of the memory allocator.
+ *
+ * In addition, the registry provides the current and the peak resident set size (RSS)
+ * of the process as reported by the operating system.
+ */
+class MemoryRegistry
+{
+public:
+    typedef std::function<size_t()> SizeFunction;
+
+    /*!
+     * \brief Add a function which returns the memory used by a component [bytes].
+     *
+     * If several functions are added for the same name, their results are summed. The
+     * function must stay valid as long as reports are requested, and all processes must
+     * add the same components in the same order.
+     */
+    void add(const std::string& name, SizeFunction sizeFn)
+    {
+        for (auto& entry : entries_) {
+            if (entry.first == name) {
+                SizeFunction oldFn = entry.second;
+                entry.second = [oldFn, sizeFn]() { return oldFn() + sizeFn(); };
+                return;
+            }
+        }
+
+        entries_.emplace_back(name, sizeFn);
+    }
+
+    /*!
+     * \brief Returns the names and the current sizes of all components of the local
+     *        process [bytes].
+     */
+    std::vector<std::pair<std::string, size_t> > localUsage() const
+    {
+        std::vector<std::pair<std::string, size_t> > result;
+        for (const auto& entry : entries_)
+            result.emplace_back(entry.first, entry.second());
+        return result;
+    }
+
+    /*!
+     * \brief Print the memory used by each component.
+     *
+     * This is a collective operation; only the first process prints the sum and the
+     * maximum of all processes.
+     */
+    template <class CollectiveCommunication>
+    void print(std::ostream& os,
+               const CollectiveCommunication& comm,
+               const std::string& title) const
+    {
+        const auto& usage = localUsage();
+
+        // the sizes of the components, the sum of all components, the current and the
+        // peak RSS
+        size_t n = usage.size() + 3;
+        std::vector<double> sumMiB(n);
+        size_t totalBytes = 0;
+        for (size_t i = 0; i < usage.size(); ++i) {
+            sumMiB[i] = toMiB(static_cast<double>(usage[i].second));
+            totalBytes += usage[i].second;
+        }
+        sumMiB[n - 3] = toMiB(static_cast<double>(totalBytes));
+        sumMiB[n - 2] = toMiB(static_cast<double>(currentRss()));
+        sumMiB[n - 1] = toMiB(static_cast<double>(peakRss()));
+
+        std::vector<double> maxMiB(sumMiB);
+        comm.sum(sumMiB.data(), static_cast<int>(n));
+        comm.max(maxMiB.data(), static_cast<int>(n));
+
+        if (comm.rank() != 0)
+            return;
+
+        os << title << "\n"
+           << std::left << std::setw(40) << "    component" << std::right
+           << std::setw(16) << "total [MiB]"
+           << std::setw(20) << "max/process [MiB]"
+           << "\n";
+
+        const auto& printRow =
+            [&os, &sumMiB, &maxMiB](const std::string& name, size_t idx)
+            {
+                os << "    " << std::left << std::setw(36) << name << std::right
+                   << std::fixed << std::setprecision(2)
+                   << std::setw(16) << sumMiB[idx]
+                   << std::setw(20) << maxMiB[idx]
+                   << "\n";
+            };
+
+        for (size_t i = 0; i < usage.size(); ++i)
+            printRow(usage[i].first, i);
+        printRow("sum of the above", n - 3);
+        printRow("current resident set size", n - 2);
+        printRow("peak resident set size", n - 1);
+        os.unsetf(std::ios_base::floatfield);
+        os << std::flush;
+    }
+
+    /*!
+     * \brief Returns the maximum resident set size of the process so far [bytes].
+     *
+     * If this is not supported by the operating system, 0 is returned.
+     */
+    static size_t peakRss()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#if defined(__APPLE__)
+        return static_cast<size_t>(usage.ru_maxrss);
+#else
+        // Linux reports kilobytes
+        return static_cast<size_t>(usage.ru_maxrss)*1024;
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    /*!
+     * \brief Returns the current resident set size of the process [bytes].
+     *
+     * This is only supported on Linux; on other operating systems, 0 is returned.
+     */
+    static size_t currentRss()
+    {
+#if defined(__linux__)
+        std::ifstream statm("/proc/self/statm");
+        size_t numPagesTotal = 0;
+        size_t numPagesResident = 0;
+        if (!(statm >> numPagesTotal >> numPagesResident))
+            return 0;
+        return numPagesResident*static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+
+    /*!
+     * \brief Converts a number of bytes to mebibytes.
+     */
+    static double toMiB(double numBytes)
+    { return numBytes/(1024.0*1024.0); }
+
+private:
+    std::vector<std::pair<std::string, SizeFunction> > entries_;
+};
+
+/*!
+ * \brief Returns the memory allocated by a std::vector [bytes].
+ */
+template <class Vector>
+size_t vectorMemoryUsage(const Vector& v)
+{ return v.capacity()*sizeof(typename Vector::value_type); }
+
+/*!
+ * \brief Returns an estimate of the memory used by a tree-based associative container
+ *        like std::map or std::set [bytes].
+ *
+ * Each node of such containers stores the value, three pointers and its color.
+ */
+template <class Container>
+size_t treeMemoryUsage(const Container& c)
+{ return c.size()*(sizeof(typename Container::value_type) + 4*sizeof(void*)); }
+
+/*!
+ * \brief Returns the memory used by a Dune::BlockVector [bytes].
+ */
+template <class BlockVector>
+size_t blockVectorMemoryUsage(const BlockVector& v)
+{ return v.size()*sizeof(typename BlockVector::block_type); }
+
+/*!
+ * \brief Returns the memory used by a Dune::BCRSMatrix [bytes].
+ *
+ * This accounts for the values and column indices of the non-zero blocks as well as for
+ * the row descriptors.
+ */
+template <class BCRSMatrix>
+size_t bcrsMatrixMemoryUsage(const BCRSMatrix& M)
+{
+    return
+        M.nonzeroes()*(sizeof(typename BCRSMatrix::block_type) + sizeof(typename BCRSMatrix::size_type))
+        + M.N()*sizeof(typename BCRSMatrix::row_type);
+}
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,423 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::PerfCounters
+ */
+#ifndef EWOMS_PERF_COUNTERS_HH
+#define EWOMS_PERF_COUNTERS_HH
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace Ewoms {
+/*!
+ * \ingroup Common
+ *
+ * \brief Reads the hardware performance counters of the CPU for the named regions of
+ *        Ewoms::Timer.
+ *
+ * The counters are read using the perf_event_open() system call of Linux. A separate
+ * set of counters is opened for each thread: enable() opens the ones of the calling
+ * thread and every other thread whose events ought to be counted has to call
+ * enableThread() itself, e.g., once for each worker thread of OpenMP. The events of a
+ * region are the sum over all of these threads during the period in which the region
+ * was active. Threads which did not call enableThread() are not counted. If the kernel
+ * does not allow to access the counters (e.g., because of
+ * /proc/sys/kernel/perf_event_paranoid or inside virtual machines) or on operating
+ * systems other than Linux, enable() fails and the counters are not read, i.e., the
+ * simulation continues normally.
+ *
+ * The number of bytes transferred from main memory cannot be measured per process
+ * without elevated privileges, so it is estimated as the number of misses of the last
+ * level cache times the size of a cache line.
+ */
+class PerfCounters
+{
+public:
+    enum Event {
+        cyclesEvent,
+        instructionsEvent,
+        llcMissesEvent,
+        numEvents
+    };
+
+    //! The size of a cache line which is assumed to estimate the memory traffic [bytes]
+    static const unsigned cacheLineSize = 64;
+
+    /*!
+     * \brief The events which occurred during the periods a region was active.
+     */
+    struct RegionStatistics
+    {
+        const char* name;
+        unsigned long numCalls;
+        double realTime; // [s]
+        double counts[numEvents];
+
+        /*!
+         * \brief Returns the average number of instructions per cycle.
+         */
+        double ipc() const
+        { return (counts[cyclesEvent] > 0) ? counts[instructionsEvent]/counts[cyclesEvent] : 0.0; }
+
+        /*!
+         * \brief Returns the estimated number of bytes transferred from main memory.
+         */
+        double dramBytes() const
+        { return counts[llcMissesEvent]*cacheLineSize; }
+
+        /*!
+         * \brief Returns the estimated memory bandwidth achieved by the region [GB/s].
+         */
+        double dramBandwidth() const
+        { return (realTime > 0) ? dramBytes()/realTime/1e9 : 0.0; }
+
+        /*!
+         * \brief Returns the estimated number of bytes transferred from main memory per
+         *        degree of freedom and call of the region.
+         */
+        double bytesPerDof(unsigned long numDof) const
+        { return (numDof > 0 && numCalls > 0) ? dramBytes()/numDof/numCalls : 0.0; }
+    };
+
+    /*!
+     * \brief Returns the performance counters of the process.
+     */
+    static PerfCounters& instance()
+    {
+        static PerfCounters counters;
+        return counters;
+    }
+
+    /*!
+     * \brief Returns true iff the counters are read for the named regions of timers.
+     *
+     * This is cheap, so timers can call it every time they are started or stopped.
+     */
+    static bool isEnabled()
+    { return enabledFlag_(); }
+
+    /*!
+     * \brief Start counting the hardware events of the calling thread.
+     *
+     * Returns false if none of the events can be counted. In this case, errorMessage()
+     * describes the reason.
+     */
+    bool enable()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (enabledFlag_())
+            return true;
+
+#if defined(__linux__)
+        FdArray fds;
+        if (!openThreadCounters_(fds))
+            return false;
+
+        threadFds_.push_back(fds);
+        threadEnabledFlag_() = true;
+        enabledFlag_() = true;
+        return true;
+#else
+        errorMessage_ = "hardware performance counters are only supported on Linux";
+        return false;
+#endif
+    }
+
+    /*!
+     * \brief Additionally count the hardware events of the calling thread.
+     *
+     * This must be called by each thread which ought to be considered after enable()
+     * succeeded. Calling it multiple times for the same thread is harmless. Returns
+     * false if the counters are not enabled or cannot be opened for the thread.
+     */
+    bool enableThread()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!enabledFlag_())
+            return false;
+        if (threadEnabledFlag_())
+            return true;
+
+        FdArray fds;
+        if (!openThreadCounters_(fds))
+            return false;
+
+        threadFds_.push_back(fds);
+        threadEnabledFlag_() = true;
+        return true;
+    }
+
+    /*!
+     * \brief Returns the reason why the counters could not be enabled.
+     */
+    const std::string& errorMessage() const
+    { return errorMessage_; }
+
+    /*!
+     * \brief Returns true iff a given event is counted.
+     */
+    bool isCounted(Event event) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !threadFds_.empty() && threadFds_.front()[event] >= 0;
+    }
+
+    /*!
+     * \brief Start recording the events for a region.
+     *
+     * The name must be a string literal.
+     */
+    void beginRegion(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        double counts[numEvents];
+        read_(counts);
+
+        Region& region = findRegion_(name);
+        if (region.isActive)
+            return;
+
+        region.isActive = true;
+        region.startTime = Clock::now();
+        for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx)
+            region.startCounts[eventIdx] = counts[eventIdx];
+    }
+
+    /*!
+     * \brief Stop recording the events for a region.
+     */
+    void endRegion(const char* name)
+    {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        double counts[numEvents];
+        read_(counts);
+
+        Region& region = findRegion_(name);
+        if (!region.isActive)
+            return;
+
+        region.isActive = false;
+        ++region.stats.numCalls;
+        region.stats.realTime += std::chrono::duration<double>(now - region.startTime).count();
+        for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx)
+            region.stats.counts[eventIdx] += counts[eventIdx] - region.startCounts[eventIdx];
+    }
+
+    /*!
+     * \brief Returns the statistics of all regions which have been active at least once.
+     */
+    std::vector<RegionStatistics> statistics() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<RegionStatistics> result;
+        for (const auto& region : regions_)
+            if (region.stats.numCalls > 0)
+                result.push_back(region.stats);
+        return result;
+    }
+
+    /*!
+     * \brief Print a table with the counters and the derived metrics of all regions.
+     *
+     * \param os The stream to which the table is written
+     * \param numDof The number of degrees of freedom used to normalize the memory traffic
+     */
+    void print(std::ostream& os, unsigned long numDof) const
+    {
+        os << std::left << std::setw(28) << "    region" << std::right
+           << std::setw(10) << "calls"
+           << std::setw(12) << "Gcycles"
+           << std::setw(8) << "IPC"
+           << std::setw(12) << "LLC misses"
+           << std::setw(12) << "DRAM [GB]"
+           << std::setw(10) << "GB/s"
+           << std::setw(12) << "bytes/DOF"
+           << "\n";
+
+        os << std::fixed;
+        for (const auto& stats : statistics()) {
+            os << "    " << std::left << std::setw(24) << stats.name << std::right
+               << std::setw(10) << stats.numCalls
+               << std::setprecision(3) << std::setw(12) << stats.counts[cyclesEvent]/1e9
+               << std::setprecision(2) << std::setw(8) << stats.ipc()
+               << std::setprecision(0) << std::setw(12) << stats.counts[llcMissesEvent]
+               << std::setprecision(3) << std::setw(12) << stats.dramBytes()/1e9
+               << std::setprecision(2) << std::setw(10) << stats.dramBandwidth()
+               << std::setprecision(1) << std::setw(12) << stats.bytesPerDof(numDof)
+               << "\n";
+        }
+        os.unsetf(std::ios_base::floatfield);
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::array<int, numEvents> FdArray;
+
+    struct Region
+    {
+        RegionStatistics stats;
+        bool isActive;
+        Clock::time_point startTime;
+        double startCounts[numEvents];
+    };
+
+    PerfCounters()
+    { }
+
+    ~PerfCounters()
+    {
+#if defined(__linux__)
+        for (const auto& fds : threadFds_)
+            for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx)
+                if (fds[eventIdx] >= 0)
+                    close(fds[eventIdx]);
+#endif
+    }
+
+    static bool& enabledFlag_()
+    {
+        static bool enabled = false;
+        return enabled;
+    }
+
+    static bool& threadEnabledFlag_()
+    {
+        static thread_local bool enabled = false;
+        return enabled;
+    }
+
+    // open the counters for the events of the calling thread. returns false if none of
+    // the events can be counted.
+    bool openThreadCounters_(FdArray& fds)
+    {
+        fds.fill(-1);
+
+#if defined(__linux__)
+        static const uint64_t eventConfigs[numEvents] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES
+        };
+
+        bool anyOpened = false;
+        for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx) {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = eventConfigs[eventIdx];
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            // count the events of the calling thread on any CPU
+            long fd = syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1,
+                              /*groupFd=*/-1, /*flags=*/0UL);
+            if (fd < 0) {
+                if (errorMessage_.empty())
+                    errorMessage_ = std::string("perf_event_open: ")+std::strerror(errno);
+                continue;
+            }
+
+            fds[eventIdx] = static_cast<int>(fd);
+            anyOpened = true;
+        }
+
+        return anyOpened;
+#else
+        return false;
+#endif
+    }
+
+    // read the current values of all counters summed over all threads. the values are
+    // scaled if the kernel had to multiplex the hardware counters between several
+    // events. the mutex must be held by the caller.
+    void read_(double* counts) const
+    {
+        for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx)
+            counts[eventIdx] = 0.0;
+
+#if defined(__linux__)
+        for (const auto& fds : threadFds_) {
+            for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx) {
+                if (fds[eventIdx] < 0)
+                    continue;
+
+                uint64_t buf[3]; // value, time enabled, time running
+                if (::read(fds[eventIdx], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)))
+                    continue;
+
+                double value = static_cast<double>(buf[0]);
+                if (buf[2] > 0 && buf[2] < buf[1])
+                    value *= static_cast<double>(buf[1])/buf[2];
+                counts[eventIdx] += value;
+            }
+        }
+#endif
+    }
+
+    Region& findRegion_(const char* name)
+    {
+        for (auto& region : regions_)
+            if (region.stats.name == name || std::strcmp(region.stats.name, name) == 0)
+                return region;
+
+        regions_.emplace_back();
+        Region& region = regions_.back();
+        region.stats.name = name;
+        region.stats.numCalls = 0;
+        region.stats.realTime = 0.0;
+        region.isActive = false;
+        for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx) {
+            region.stats.counts[eventIdx] = 0.0;
+            region.startCounts[eventIdx] = 0.0;
+        }
+        return region;
+    }
+
+    std::vector<FdArray> threadFds_; // the counters of the main thread come first
+    std::string errorMessage_;
+    std::vector<Region> regions_;
+    mutable std::mutex mutex_;
+};
+} // namespace Ewoms
+
+#endif
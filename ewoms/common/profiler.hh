@@ -0,0 +1,380 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::Profiler
+ */
+#ifndef EWOMS_PROFILER_HH
+#define EWOMS_PROFILER_HH
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Measure the time spent in the current scope as a region of the profiler.
+ *
+ * The name must be a string literal. If eWoms is not configured with
+ * EWOMS_ENABLE_PROFILING, this macro expands to nothing.
+ */
+#if EWOMS_ENABLE_PROFILING
+#define EWOMS_PROFILE_CONCAT_(a, b) a ## b
+#define EWOMS_PROFILE_CONCAT(a, b) EWOMS_PROFILE_CONCAT_(a, b)
+#define EWOMS_PROFILE_REGION(name)                                      \
+    ::Ewoms::ProfileRegion EWOMS_PROFILE_CONCAT(ewomsProfileRegion_, __LINE__)(name)
+#else
+#define EWOMS_PROFILE_REGION(name) do {} while (false)
+#endif
+
+namespace Ewoms {
+/*!
+ * \ingroup Common
+ *
+ * \brief Records nested regions of code on a per-thread basis.
+ *
+ * Every thread has its own stack of open regions and its own tree of regions which
+ * accumulates the number of calls and the time spent in each path of the call tree.
+ * Additionally, each closed region is recorded as an event, which allows to export a
+ * timeline in the trace event format understood by chrome://tracing and Perfetto.
+ *
+ * Region names must be string literals or otherwise outlive the profiler. The results
+ * must only be exported while no thread is within a profiled region, e.g., at the end
+ * of a simulation.
+ */
+class Profiler
+{
+    struct Node
+    {
+        const char* name;
+        unsigned parentIdx;
+        std::vector<unsigned> children;
+        size_t numCalls;
+        double totalTime;
+        double minTime;
+        double maxTime;
+    };
+
+    struct Event
+    {
+        const char* name;
+        double beginTime; // [us] since the profiler was created
+        double duration; // [us]
+    };
+
+    struct ThreadData
+    {
+        unsigned threadIdx;
+        std::vector<Node> nodes;
+        std::vector<unsigned> stack;
+        std::vector<double> startTimes;
+        std::vector<Event> events;
+        size_t numDroppedEvents;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+public:
+    //! The maximum number of events which are recorded for each thread
+    static const size_t maxEventsPerThread = 1 << 20;
+
+    /*!
+     * \brief Returns the profiler of the process.
+     */
+    static Profiler& instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    /*!
+     * \brief Open a region for the calling thread.
+     */
+    void beginRegion(const char* name)
+    {
+        ThreadData& td = threadData_();
+        unsigned parentIdx = td.stack.back();
+
+        unsigned nodeIdx = 0;
+        bool found = false;
+        for (unsigned childIdx : td.nodes[parentIdx].children) {
+            const char* childName = td.nodes[childIdx].name;
+            if (childName == name || std::strcmp(childName, name) == 0) {
+                nodeIdx = childIdx;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            nodeIdx = static_cast<unsigned>(td.nodes.size());
+            td.nodes.push_back(Node{name, parentIdx, {}, 0, 0.0,
+                                    std::numeric_limits<double>::max(), 0.0});
+            td.nodes[parentIdx].children.push_back(nodeIdx);
+        }
+
+        td.stack.push_back(nodeIdx);
+        td.startTimes.push_back(now_());
+    }
+
+    /*!
+     * \brief Close a region of the calling thread.
+     *
+     * If a name is specified and the innermost open region has a different name, all
+     * regions up to the innermost one with the specified name are closed. If no such
+     * region is open, nothing happens.
+     */
+    void endRegion(const char* name = nullptr)
+    {
+        ThreadData& td = threadData_();
+        if (name) {
+            auto it = std::find_if(td.stack.rbegin(), td.stack.rend() - 1,
+                                   [&td, name](unsigned nodeIdx) -> bool
+                                   {
+                                       const char* nodeName = td.nodes[nodeIdx].name;
+                                       return nodeName == name || std::strcmp(nodeName, name) == 0;
+                                   });
+            if (it == td.stack.rend() - 1)
+                return;
+
+            size_t numToClose = static_cast<size_t>(it - td.stack.rbegin()) + 1;
+            for (size_t i = 0; i < numToClose; ++i)
+                closeInnermost_(td);
+        }
+        else if (td.stack.size() > 1)
+            closeInnermost_(td);
+    }
+
+    /*!
+     * \brief Write all events in the Chrome trace event format.
+     *
+     * \param os The stream to which the JSON document is written
+     * \param processIdx The index of the process (i.e., the MPI rank)
+     */
+    void writeChromeTrace(std::ostream& os, int processIdx = 0) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        bool first = true;
+        for (const auto& td : threads_) {
+            for (const auto& event : td->events) {
+                if (!first)
+                    os << ",\n";
+                first = false;
+
+                os << std::fixed << std::setprecision(3)
+                   << "{\"name\": \"" << jsonEscape_(event.name) << "\""
+                   << ", \"cat\": \"ewoms\", \"ph\": \"X\""
+                   << ", \"ts\": " << event.beginTime
+                   << ", \"dur\": " << event.duration
+                   << ", \"pid\": " << processIdx
+                   << ", \"tid\": " << td->threadIdx << "}";
+            }
+        }
+        os << "\n]}\n";
+        os.unsetf(std::ios::floatfield);
+    }
+
+    /*!
+     * \brief Write all events in the Chrome trace event format to a file.
+     */
+    void writeChromeTrace(const std::string& fileName, int processIdx = 0) const
+    {
+        std::ofstream os(fileName);
+        if (!os)
+            throw std::runtime_error("Could not open file '"+fileName+"' for writing");
+        writeChromeTrace(os, processIdx);
+    }
+
+    /*!
+     * \brief Print the aggregated region tree of all threads.
+     */
+    void printTree(std::ostream& os) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (const auto& td : threads_) {
+            if (td->nodes[0].children.empty())
+                continue;
+
+            os << "Thread " << td->threadIdx << ":\n";
+            os << std::setw(50) << std::left << "  region"
+               << std::right
+               << std::setw(10) << "calls"
+               << std::setw(14) << "total [s]"
+               << std::setw(14) << "avg [ms]"
+               << std::setw(14) << "max [ms]"
+               << std::setw(10) << "parent"
+               << "\n";
+            for (unsigned childIdx : td->nodes[0].children)
+                printNode_(os, *td, childIdx, /*depth=*/1);
+            if (td->numDroppedEvents > 0)
+                os << "  (" << td->numDroppedEvents << " trace events were dropped)\n";
+        }
+    }
+
+    /*!
+     * \brief Print the aggregated region tree of all threads to a file.
+     */
+    void printTree(const std::string& fileName) const
+    {
+        std::ofstream os(fileName);
+        if (!os)
+            throw std::runtime_error("Could not open file '"+fileName+"' for writing");
+        printTree(os);
+    }
+
+private:
+    Profiler()
+        : epoch_(Clock::now())
+    {}
+
+    ThreadData& threadData_()
+    {
+        thread_local ThreadData* td = nullptr;
+        if (!td) {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            threads_.emplace_back(new ThreadData);
+            td = threads_.back().get();
+            td->threadIdx = static_cast<unsigned>(threads_.size() - 1);
+            td->numDroppedEvents = 0;
+
+            // the root node of the tree is always open
+            td->nodes.push_back(Node{"", 0, {}, 0, 0.0, 0.0, 0.0});
+            td->stack.push_back(0);
+            td->startTimes.push_back(0.0);
+        }
+
+        return *td;
+    }
+
+    void closeInnermost_(ThreadData& td)
+    {
+        double endTime = now_();
+        double beginTime = td.startTimes.back();
+        double duration = endTime - beginTime;
+
+        Node& node = td.nodes[td.stack.back()];
+        ++node.numCalls;
+        node.totalTime += duration;
+        node.minTime = std::min(node.minTime, duration);
+        node.maxTime = std::max(node.maxTime, duration);
+
+        if (td.events.size() < maxEventsPerThread)
+            td.events.push_back(Event{node.name, beginTime, duration});
+        else
+            ++td.numDroppedEvents;
+
+        td.stack.pop_back();
+        td.startTimes.pop_back();
+    }
+
+    void printNode_(std::ostream& os, const ThreadData& td, unsigned nodeIdx, unsigned depth) const
+    {
+        const Node& node = td.nodes[nodeIdx];
+        const Node& parent = td.nodes[node.parentIdx];
+
+        std::string label = std::string(2*depth, ' ') + node.name;
+        double totalSeconds = node.totalTime*1e-6;
+        double avgMs = (node.numCalls > 0) ? node.totalTime*1e-3/static_cast<double>(node.numCalls) : 0.0;
+
+        os << std::setw(50) << std::left << label
+           << std::right << std::fixed
+           << std::setw(10) << node.numCalls
+           << std::setw(14) << std::setprecision(3) << totalSeconds
+           << std::setw(14) << std::setprecision(3) << avgMs
+           << std::setw(14) << std::setprecision(3) << node.maxTime*1e-3;
+        if (node.parentIdx != 0 && parent.totalTime > 0)
+            os << std::setw(9) << std::setprecision(1) << 100*node.totalTime/parent.totalTime << "%";
+        os << "\n";
+        os.unsetf(std::ios::floatfield);
+
+        for (unsigned childIdx : node.children)
+            printNode_(os, td, childIdx, depth + 1);
+    }
+
+    // returns the number of microseconds since the profiler was created
+    double now_() const
+    {
+        std::chrono::duration<double, std::micro> dt = Clock::now() - epoch_;
+        return dt.count();
+    }
+
+    static std::string jsonEscape_(const char* str)
+    {
+        std::string result;
+        for (; *str; ++str) {
+            if (*str == '"' || *str == '\\')
+                result += '\\';
+            result += *str;
+        }
+        return result;
+    }
+
+    Clock::time_point epoch_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadData> > threads_;
+};
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Opens a region of the profiler for the lifetime of the object.
+ *
+ * Use the EWOMS_PROFILE_REGION macro instead of this class directly, so that the
+ * regions are compiled out if profiling is disabled.
+ */
+class ProfileRegion
+{
+public:
+    explicit ProfileRegion(const char* name)
+        : name_(name)
+    { Profiler::instance().beginRegion(name_); }
+
+    ~ProfileRegion()
+    { Profiler::instance().endRegion(name_); }
+
+    ProfileRegion(const ProfileRegion&) = delete;
+    ProfileRegion& operator=(const ProfileRegion&) = delete;
+
+private:
+    const char* name_;
+};
+
+} // namespace Ewoms
+
+#endif
@@ -29,11 +29,15 @@
 #define EWOMS_SIMULATOR_HH
 
 #include <ewoms/io/restart.hh>
+#include <ewoms/io/performancelog.hh>
 #include <ewoms/common/parametersystem.hh>
 
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/timer.hh>
 #include <ewoms/common/timerguard.hh>
+#include <ewoms/common/perfcounters.hh>
+#include <ewoms/common/memoryregistry.hh>
+#include <ewoms/parallel/loadimbalancereport.hh>
 
 #include <dune/common/version.hh>
 #include <dune/common/parallel/mpihelper.hh>
@@ -56,6 +60,11 @@ NEW_PROP_TAG(EndTime);
 NEW_PROP_TAG(RestartTime);
 NEW_PROP_TAG(InitialTimeStepSize);
 NEW_PROP_TAG(PredeterminedTimeStepsFile);
+NEW_PROP_TAG(EnableLoadImbalanceLog);
+NEW_PROP_TAG(PerformanceLogFile);
+NEW_PROP_TAG(EnablePerfCounters);
+NEW_PROP_TAG(EnableMemoryReport);
+NEW_PROP_TAG(ThreadManager);
 
 END_PROPERTIES
 
@@ -106,12 +115,17 @@ class Simulator
     typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
     typedef typename GET_PROP_TYPE(TypeTag, Model) Model;
     typedef typename GET_PROP_TYPE(TypeTag, Problem) Problem;
+    typedef typename GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
 
 public:
     // do not allow to copy simulators around
     Simulator(const Simulator& ) = delete;
 
     Simulator(bool verbose = true)
+        : setupTimer_("setup")
+        , executionTimer_("simulation")
+        , prePostProcessTimer_("pre/post processing")
+        , writeTimer_("output")
     {
         Ewoms::TimerGuard setupTimerGuard(setupTimer_);
 
@@ -120,6 +134,34 @@ public:
         const auto& comm = Dune::MPIHelper::getCollectiveCommunication();
         verbose_ = verbose && comm.rank() == 0;
 
+        // the hardware performance counters are opened separately for each thread. the
+        // worker threads of OpenMP are kept alive between parallel regions of the same
+        // size, so letting each of them open its counters once is sufficient.
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnablePerfCounters)) {
+            auto& perfCounters = PerfCounters::instance();
+            if (perfCounters.enable()) {
+#ifdef _OPENMP
+#pragma omp parallel num_threads(ThreadManager::maxThreads())
+#endif
+                perfCounters.enableThread();
+            }
+            else if (comm.rank() == 0)
+                std::cout << "Warning: Hardware performance counters are not available ("
+                          << perfCounters.errorMessage() << "). Continuing without them.\n"
+                          << std::flush;
+        }
+
+        enableLoadImbalanceLog_ = EWOMS_GET_PARAM(TypeTag, bool, EnableLoadImbalanceLog);
+        enableMemoryReport_ = EWOMS_GET_PARAM(TypeTag, bool, EnableMemoryReport);
+
+        // the performance log is only written by the first process, but all processes
+        // need to know whether it is written because collecting its data requires
+        // collective communication
+        const std::string& performanceLogFile = EWOMS_GET_PARAM(TypeTag, std::string, PerformanceLogFile);
+        enablePerformanceLog_ = !performanceLogFile.empty();
+        if (enablePerformanceLog_ && comm.rank() == 0)
+            performanceLog_.open(performanceLogFile);
+
         timeStepIdx_ = 0;
         startTime_ = 0.0;
         time_ = 0.0;
@@ -228,6 +270,20 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, std::string, PredeterminedTimeStepsFile,
                              "A file with a list of predetermined time step sizes (one "
                              "time step per line)");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableLoadImbalanceLog,
+                             "Print the imbalance of the solver phases across the "
+                             "processes after each time step");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, PerformanceLogFile,
+                             "The name of the file to which the performance of each time "
+                             "step is logged by the first process (*.csv: comma separated "
+                             "values, otherwise JSON Lines, empty: none)");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnablePerfCounters,
+                             "Read the hardware performance counters of the CPU for the "
+                             "phases of the solver using perf_event_open() (Linux only)");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableMemoryReport,
+                             "Print the memory used by the major data structures after the "
+                             "setup, after the first time step and at the end of the "
+                             "simulation");
 
         Vanguard::registerParameters();
         Model::registerParameters();
@@ -389,6 +445,67 @@ public:
     const Ewoms::Timer& writeTimer() const
     { return writeTimer_; }
 
+    /*!
+     * \brief Returns a reference to the timer object which measures the time needed to
+     *        set up the linear solver
+     */
+    const Ewoms::Timer& linearSolverSetupTimer() const
+    { return linearSolverSetupTimer_; }
+
+    /*!
+     * \brief Returns a reference to the timer object which measures the time needed for
+     *        the iterations of the linear solver
+     */
+    const Ewoms::Timer& linearSolverIterationTimer() const
+    { return linearSolverIterationTimer_; }
+
+    /*!
+     * \brief Returns a reference to the timer object which measures the time needed to
+     *        synchronize the linear systems of equations with the peer processes
+     */
+    const Ewoms::Timer& overlapSyncTimer() const
+    { return overlapSyncTimer_; }
+
+    /*!
+     * \brief Returns the structured log of the performance of the time steps.
+     *
+     * The log is only open on the first process and only if the PerformanceLogFile
+     * parameter has been specified.
+     */
+    PerformanceLog& performanceLog()
+    { return performanceLog_; }
+
+    /*!
+     * \brief Returns the registry to which the components of the simulation report the
+     *        memory used by their data structures.
+     *
+     * Adding components to the registry does not change the state of the simulation,
+     * so this is also available for constant simulator objects.
+     */
+    MemoryRegistry& memoryRegistry() const
+    { return memoryRegistry_; }
+
+    /*!
+     * \brief Returns true iff the memory used by the components of the simulation is
+     *        printed during the simulation.
+     */
+    bool enableMemoryReport() const
+    { return enableMemoryReport_; }
+
+    /*!
+     * \brief Collect the time spent in each phase of the solver by all processes since
+     *        the beginning of the simulation.
+     *
+     * This is a collective operation; the result is only available on the first rank.
+     */
+    LoadImbalanceReport loadImbalanceReport() const
+    {
+        LoadImbalanceReport report;
+        addSolverPhases_(report, *this, writeTimer_.realTimeElapsed());
+        report.gather(gridView().comm());
+        return report;
+    }
+
     /*!
      * \brief Set the current time step size to a given value.
      *
@@ -654,10 +771,15 @@ public:
         }
         setupTimer_.stop();
 
+        if (enableMemoryReport_)
+            memoryRegistry_.print(std::cout, gridView().comm(), "Memory usage after the setup:");
+
         executionTimer_.start();
         bool episodeBegins = episodeIsOver() || (timeStepIdx_ == 0);
+        bool isFirstTimeStep = true;
         // do the time steps
         while (!finished()) {
+            Scalar stepStartTime = executionTimer_.realTimeElapsed();
             prePostProcessTimer_.start();
             if (episodeBegins) {
                 // notify the problem that a new episode has just been
@@ -708,6 +830,9 @@ public:
                 linearizeTimer_ += model.linearizeTimer();
                 solveTimer_ += model.solveTimer();
                 updateTimer_ += model.updateTimer();
+                linearSolverSetupTimer_ += model.linearSolverSetupTimer();
+                linearSolverIterationTimer_ += model.linearSolverIterationTimer();
+                overlapSyncTimer_ += model.overlapSyncTimer();
 
                 throw;
             }
@@ -717,6 +842,9 @@ public:
             linearizeTimer_ += model.linearizeTimer();
             solveTimer_ += model.solveTimer();
             updateTimer_ += model.updateTimer();
+            linearSolverSetupTimer_ += model.linearSolverSetupTimer();
+            linearSolverIterationTimer_ += model.linearSolverIterationTimer();
+            overlapSyncTimer_ += model.overlapSyncTimer();
 
             // post-process the current solution
             prePostProcessTimer_.start();
@@ -724,11 +852,26 @@ public:
             prePostProcessTimer_.stop();
 
             // write the result to disk
+            Scalar writeTimeBefore = writeTimer_.realTimeElapsed();
             writeTimer_.start();
             if (problem_->shouldWriteOutput())
                 EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(problem_->writeOutput());
             writeTimer_.stop();
 
+            if (enableLoadImbalanceLog_)
+                printTimeStepLoadImbalance_(writeTimer_.realTimeElapsed() - writeTimeBefore);
+
+            if (enablePerformanceLog_)
+                logTimeStepPerformance_(executionTimer_.realTimeElapsed() - stepStartTime,
+                                        writeTimer_.realTimeElapsed() - writeTimeBefore);
+
+            // the linear system and the caches have been allocated by the first time
+            // step, so this is usually the point where the memory usage is highest
+            if (enableMemoryReport_ && isFirstTimeStep)
+                memoryRegistry_.print(std::cout, gridView().comm(),
+                                      "Memory usage after the first time step:");
+            isFirstTimeStep = false;
+
             // do the next time integration
             Scalar oldDt = timeStepSize();
             EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(problem_->advanceTimeLevel());
@@ -925,6 +1068,73 @@ public:
     }
 
 private:
+    // add the phases of the solver to a load imbalance report. the timers are either
+    // the ones of the model (for a single time step) or the ones of the simulator.
+    template <class SolverTimers>
+    static void addSolverPhases_(LoadImbalanceReport& report,
+                                 const SolverTimers& timers,
+                                 double writeTime)
+    {
+        report.addPhase("linearization", timers.linearizeTimer().realTimeElapsed());
+        report.addPhase("linear solve", timers.solveTimer().realTimeElapsed());
+        report.addPhase("  solver setup", timers.linearSolverSetupTimer().realTimeElapsed());
+        report.addPhase("  solver iterations", timers.linearSolverIterationTimer().realTimeElapsed());
+        report.addPhase("  overlap sync", timers.overlapSyncTimer().realTimeElapsed());
+        report.addPhase("Newton update", timers.updateTimer().realTimeElapsed());
+        report.addPhase("output", writeTime);
+    }
+
+    void logTimeStepPerformance_(double wallTime, double writeTime)
+    {
+        const auto& model = problem_->model();
+        const auto& newtonMethod = model.newtonMethod();
+
+        TimeStepPerformance step;
+        step.timeStepIdx = timeStepIndex();
+        step.time = this->time() + timeStepSize();
+        step.timeStepSize = timeStepSize();
+        step.numTimeStepCuts = problem_->numTimeStepCuts();
+        step.numNewtonIterations = static_cast<unsigned>(newtonMethod.numIterations());
+        step.numReusedJacobians = newtonMethod.numReusedJacobians();
+        step.linearIterations = newtonMethod.linearIterations();
+        step.stepLengths.assign(newtonMethod.stepLengths().begin(), newtonMethod.stepLengths().end());
+        step.wallTime = wallTime;
+        step.linearizeTime = model.linearizeTimer().realTimeElapsed();
+        step.solveTime = model.solveTimer().realTimeElapsed();
+        step.linearSolverSetupTime = model.linearSolverSetupTimer().realTimeElapsed();
+        step.linearSolverIterationTime = model.linearSolverIterationTimer().realTimeElapsed();
+        step.overlapSyncTime = model.overlapSyncTimer().realTimeElapsed();
+        step.updateTime = model.updateTimer().realTimeElapsed();
+        step.prePostProcessTime = model.prePostProcessTimer().realTimeElapsed();
+        step.writeTime = writeTime;
+        step.numDof = gridView().comm().sum(static_cast<unsigned long>(model.numGridDof()));
+
+        Scalar maxResid;
+        Scalar avgResid;
+        newtonMethod.residualStatistics(maxResid, avgResid);
+        step.maxResidual = maxResid;
+        step.avgResidual = avgResid;
+
+        performanceLog_.writeTimeStep(step);
+    }
+
+    void printTimeStepLoadImbalance_(double writeTime) const
+    {
+        LoadImbalanceReport report(/*numSlowestRanks=*/1);
+        addSolverPhases_(report, problem_->model(), writeTime);
+        report.gather(gridView().comm());
+
+        if (gridView().comm().rank() == 0) {
+            std::cout << "Load imbalance (max/avg) of time step " << timeStepIndex() + 1 << ": ";
+            report.printCompact(std::cout);
+            std::cout << std::flush;
+        }
+    }
+
+    // the registry is declared before the components of the simulation because these
+    // add themselves to it during their construction
+    mutable MemoryRegistry memoryRegistry_;
+
     std::unique_ptr<Vanguard> vanguard_;
     std::unique_ptr<Model> model_;
     std::unique_ptr<Problem> problem_;
@@ -940,6 +1150,9 @@ private:
     Ewoms::Timer solveTimer_;
     Ewoms::Timer updateTimer_;
     Ewoms::Timer writeTimer_;
+    Ewoms::Timer linearSolverSetupTimer_;
+    Ewoms::Timer linearSolverIterationTimer_;
+    Ewoms::Timer overlapSyncTimer_;
 
     std::vector<Scalar> forcedTimeSteps_;
     Scalar startTime_;
@@ -951,6 +1164,10 @@ private:
 
     bool finished_;
     bool verbose_;
+    bool enableLoadImbalanceLog_;
+    bool enablePerformanceLog_;
+    bool enableMemoryReport_;
+    PerformanceLog performanceLog_;
 };
 } // namespace Ewoms
 
@@ -28,8 +28,14 @@
 #ifndef EWOMS_TIMER_HH
 #define EWOMS_TIMER_HH
 
+#include "perfcounters.hh"
+
 #include <chrono>
 
+#if EWOMS_ENABLE_PROFILING
+#include "profiler.hh"
+#endif
+
 #if HAVE_MPI
 #include <mpi.h>
 #endif
@@ -44,6 +50,11 @@ namespace Ewoms {
  * used by all threads of a single process and the CPU time used by
  * the overall simulation. (i.e., the time used by all threads of all
  * involved processes.)
+ *
+ * If a name for a profiling region is specified, the periods during which the timer
+ * is active are additionally recorded by Ewoms::Profiler if eWoms has been configured
+ * with EWOMS_ENABLE_PROFILING, and the hardware performance counters are read for the
+ * region if Ewoms::PerfCounters have been enabled.
  */
 class Timer
 {
@@ -54,6 +65,17 @@ class Timer
     };
 public:
     Timer()
+        : isStopped_(true)
+        , profileRegion_(nullptr)
+    { halt(); }
+
+    /*!
+     * \param profileRegion The name of the profiling region for the timer. This must
+     *                      be a string literal.
+     */
+    explicit Timer(const char* profileRegion)
+        : isStopped_(true)
+        , profileRegion_(profileRegion)
     { halt(); }
 
     /*!
@@ -61,6 +83,13 @@ public:
      */
     void start()
     {
+#if EWOMS_ENABLE_PROFILING
+        if (profileRegion_ && isStopped_)
+            Profiler::instance().beginRegion(profileRegion_);
+#endif
+        if (profileRegion_ && isStopped_ && PerfCounters::isEnabled())
+            PerfCounters::instance().beginRegion(profileRegion_);
+
         isStopped_ = false;
         measure_(startTime_);
     }
@@ -73,6 +102,13 @@ public:
     double stop()
     {
         if (!isStopped_) {
+#if EWOMS_ENABLE_PROFILING
+            if (profileRegion_)
+                Profiler::instance().endRegion(profileRegion_);
+#endif
+            if (profileRegion_ && PerfCounters::isEnabled())
+                PerfCounters::instance().endRegion(profileRegion_);
+
             TimeData stopTime;
 
             measure_(stopTime);
@@ -98,6 +134,13 @@ public:
      */
     void halt()
     {
+#if EWOMS_ENABLE_PROFILING
+        if (profileRegion_ && !isStopped_)
+            Profiler::instance().endRegion(profileRegion_);
+#endif
+        if (profileRegion_ && !isStopped_ && PerfCounters::isEnabled())
+            PerfCounters::instance().endRegion(profileRegion_);
+
         isStopped_ = true;
         cpuTimeElapsed_ = 0.0;
         realTimeElapsed_ = 0.0;
@@ -208,6 +251,7 @@ private:
     }
 
     bool isStopped_;
+    const char* profileRegion_;
     double cpuTimeElapsed_;
     double realTimeElapsed_;
     TimeData startTime_;
@@ -207,6 +207,38 @@ public:
         }
     }
 
+    /*!
+     * \brief Evaluate the residual of an element without computing its local Jacobian.
+     *
+     * Since the values of the residual do not depend on the focus degree of freedom, the
+     * local residual only needs to be evaluated once instead of once per primary degree
+     * of freedom and the derivatives of the result can be ignored. After calling this
+     * method, the local Jacobian matrix is undefined and the ElementContext is in an
+     * undefined state.
+     *
+     * \param elemCtx The element execution context for which the local residual should
+     *                be calculated.
+     * \param elem The grid element for which the local residual should be calculated.
+     */
+    void evalResidual(ElementContext& elemCtx, const Element& elem)
+    {
+        elemCtx.updateStencil(elem);
+        elemCtx.updateAllIntensiveQuantities();
+
+        size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
+        residual_.resize(numDof);
+
+        elemCtx.setFocusDofIndex(/*dofIdx=*/0);
+        elemCtx.updateAllExtensiveQuantities();
+        localResidual_.eval(elemCtx);
+
+        const auto& resid = localResidual_.residual();
+        unsigned numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+        for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; dofIdx++)
+            for (unsigned eqIdx = 0; eqIdx < numEq; eqIdx++)
+                residual_[dofIdx][eqIdx] = resid[dofIdx][eqIdx].value();
+    }
+
     /*!
      * \brief Return reference to the local residual.
      */
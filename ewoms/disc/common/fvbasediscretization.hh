@@ -54,6 +54,9 @@
 #include <ewoms/common/alignedallocator.hh>
 #include <ewoms/common/timer.hh>
 #include <ewoms/common/timerguard.hh>
+#include <ewoms/common/memoryregistry.hh>
+#include <ewoms/io/outputselection.hh>
+#include <ewoms/io/vtklinearizationcostmodule.hh>
 #include <ewoms/linear/matrixblock.hh>
 
 #include <opm/material/common/MathToolbox.hpp>
@@ -77,6 +80,9 @@
 #include <dune/fem/misc/capabilities.hh>
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
 #include <limits>
 #include <list>
 #include <sstream>
@@ -133,6 +139,13 @@ SET_TYPE_PROP(FvBaseDiscretization, GradientCalculator, Ewoms::FvBaseGradientCal
 //! Newton solver
 SET_INT_PROP(FvBaseDiscretization, MaxTimeStepDivisions, 10);
 
+//! By default, adapt the time step size to the number of Newton iterations and halve
+//! it if the Newton method failed
+SET_STRING_PROP(FvBaseDiscretization, TimeStepControl, "iterationcount");
+SET_SCALAR_PROP(FvBaseDiscretization, TimeStepCutFactor, 0.5);
+SET_SCALAR_PROP(FvBaseDiscretization, TimeStepControlTargetChange, 0.1);
+SET_SCALAR_PROP(FvBaseDiscretization, TimeStepControlMaxGrowth, 3.0);
+
 
 //! By default, do not continue with a non-converged solution instead of giving up
 //! if we encounter a time step size smaller than the minimum time
@@ -209,6 +222,16 @@ SET_TYPE_PROP(FvBaseDiscretization, ThreadManager, Ewoms::ThreadManager<TypeTag>
 SET_INT_PROP(FvBaseDiscretization, ThreadsPerProcess, 1);
 SET_BOOL_PROP(FvBaseDiscretization, UseLinearizationLock, true);
 
+//! Do not measure the linearization cost of the elements by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableLinearizationCostMap, false);
+
+//! Do not print the linearization statistics by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableLinearizationStatistics, false);
+
+//! Linearize all elements in each Newton iteration by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableIncrementalLinearization, false);
+SET_SCALAR_PROP(FvBaseDiscretization, IncrementalLinearizationTolerance, 1e-6);
+
 /*!
  * \brief Linearizer for the global system of equations.
  */
@@ -226,6 +249,10 @@ SET_BOOL_PROP(FvBaseDiscretization, EnableGridAdaptation, false);
 //! By default, write the simulation output to the current working directory
 SET_STRING_PROP(FvBaseDiscretization, OutputDir, ".");
 
+//! Write all output fields for the whole domain by default
+SET_STRING_PROP(FvBaseDiscretization, OutputSelection, "");
+SET_STRING_PROP(FvBaseDiscretization, OutputSelectionFile, "");
+
 //! Enable the VTK output by default
 SET_BOOL_PROP(FvBaseDiscretization, EnableVtkOutput, true);
 
@@ -234,9 +261,30 @@ SET_BOOL_PROP(FvBaseDiscretization, EnableVtkOutput, true);
 //! This has only an effect if EnableVtkOutput is true
 SET_BOOL_PROP(FvBaseDiscretization, EnableAsyncVtkOutput, true);
 
+//! Use double buffering for asynchronous VTK output by default
+SET_INT_PROP(FvBaseDiscretization, VtkOutputBufferDepth, 2);
+
+//! Allow the pending VTK output data to occupy 1 GiB of memory by default
+SET_SCALAR_PROP(FvBaseDiscretization, VtkOutputBufferMemoryLimit, 1024.0);
+
 //! Set the format of the VTK output to ASCII by default
 SET_INT_PROP(FvBaseDiscretization, VtkOutputFormat, Dune::VTK::ascii);
 
+//! Use Dune's VTK writer by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableVtkAppendedRawOutput, false);
+
+//! Do not compress the VTK output by default
+SET_INT_PROP(FvBaseDiscretization, VtkCompressionLevel, 0);
+
+//! Compress the VTK output using the thread which does the writing by default
+SET_INT_PROP(FvBaseDiscretization, VtkCompressionThreads, 1);
+
+//! Do not write a time series file by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableTimeSeriesOutput, false);
+
+//! By default, the timing receipt is not written to a file
+SET_STRING_PROP(FvBaseDiscretization, TimingReceiptFile, "");
+
 // disable caching the storage term by default
 SET_BOOL_PROP(FvBaseDiscretization, EnableStorageCache, false);
 
@@ -253,6 +301,9 @@ SET_BOOL_PROP(FvBaseDiscretization, EnableIntensiveQuantityCache, false);
 // enable the intensive quantity cache above to avoid getting an exception...
 SET_BOOL_PROP(FvBaseDiscretization, EnableThermodynamicHints, false);
 
+// start the Newton method at the solution of the previous time step by default
+SET_INT_PROP(FvBaseDiscretization, SolutionPredictorOrder, 0);
+
 // if the deflection of the newton method is large, we do not need to solve the linear
 // approximation accurately. Assuming that the value for the current solution is quite
 // close to the final value, a reduction of 3 orders of magnitude in the defect should be
@@ -400,6 +451,12 @@ public:
         , enableStorageCache_(EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache))
         , enableThermodynamicHints_(EWOMS_GET_PARAM(TypeTag, bool, EnableThermodynamicHints))
     {
+        int predictorOrder = EWOMS_GET_PARAM(TypeTag, int, SolutionPredictorOrder);
+        if (predictorOrder < 0 || predictorOrder > 2)
+            throw std::invalid_argument("The order of the solution predictor must be 0, 1 or 2 (is: "
+                                        + std::to_string(predictorOrder) + ")");
+        solutionPredictorOrder_ = static_cast<unsigned>(predictorOrder);
+
 #if HAVE_DUNE_FEM
         if (enableGridAdaptation_ && !Dune::Fem::Capabilities::isLocallyAdaptive<Grid>::v)
             throw std::invalid_argument("Grid adaptation enabled, but chosen Grid is not capable"
@@ -431,6 +488,65 @@ public:
         }
 
         resizeAndResetIntensiveQuantitiesCache_();
+
+        auto& memoryRegistry = simulator.memoryRegistry();
+        memoryRegistry.add("solution history",
+                           [this]() -> size_t
+                           {
+                               size_t result = 0;
+                               for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx)
+                                   result += blockVectorMemoryUsage(solution(timeIdx));
+                               return result;
+                           });
+        memoryRegistry.add("intensive quantity cache",
+                           [this]() -> size_t
+                           {
+                               size_t result = 0;
+                               for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx)
+                                   result +=
+                                       vectorMemoryUsage(intensiveQuantityCache_[timeIdx])
+                                       + intensiveQuantityCacheUpToDate_[timeIdx].capacity()/8;
+                               return result;
+                           });
+        memoryRegistry.add("storage cache",
+                           [this]() -> size_t
+                           {
+                               size_t result = 0;
+                               for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx)
+                                   result += blockVectorMemoryUsage(storageCache_[timeIdx]);
+                               return result;
+                           });
+
+        // the linearizer may be replaced during the simulation (cf. resetLinearizer()),
+        // so its data structures are accessed via the model
+        memoryRegistry.add("Jacobian matrix and residual",
+                           [this]() -> size_t
+                           { return linearizer_->linearSystemMemoryUsage(); });
+        memoryRegistry.add("element contexts",
+                           [this]() -> size_t
+                           { return linearizer_->elementContextMemoryUsage(); });
+        memoryRegistry.add("linearization cost map",
+                           [this]() -> size_t
+                           { return linearizer_->linearizationCostMapMemoryUsage(); });
+        memoryRegistry.add("cached local linearizations",
+                           [this]() -> size_t
+                           { return linearizer_->incrementalLinearizationMemoryUsage(); });
+        memoryRegistry.add("solution predictor history",
+                           [this]() -> size_t
+                           {
+                               size_t result = 0;
+                               for (const auto& entry : predictorHistory_)
+                                   result += blockVectorMemoryUsage(entry.solution);
+                               return result;
+                           });
+
+        const std::string& selectionFile = EWOMS_GET_PARAM(TypeTag, std::string, OutputSelectionFile);
+        if (!selectionFile.empty())
+            outputSelection_.parseFile(selectionFile);
+        outputSelection_.parse(EWOMS_GET_PARAM(TypeTag, std::string, OutputSelection),
+                               "OutputSelection parameter");
+        outputSelection_.validate(GridView::dimensionworld, gridView_.comm().size());
+
         asImp_().registerOutputModules_();
     }
 
@@ -460,13 +576,23 @@ public:
 
         // register runtime parameters of the output modules
         Ewoms::VtkPrimaryVarsModule<TypeTag>::registerParameters();
+        Ewoms::VtkLinearizationCostModule<TypeTag>::registerParameters();
 
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableGridAdaptation, "Enable adaptive grid refinement/coarsening");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableVtkOutput, "Global switch for turning on writing VTK files");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableThermodynamicHints, "Enable thermodynamic hints");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIntensiveQuantityCache, "Turn on caching of intensive quantities");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStorageCache, "Store previous storage terms and avoid re-calculating them.");
+        EWOMS_REGISTER_PARAM(TypeTag, int, SolutionPredictorOrder,
+                             "The order of the polynomial used to extrapolate the initial guess of "
+                             "each time step from the previous solutions (0: no extrapolation, "
+                             "1: linear, 2: quadratic)");
         EWOMS_REGISTER_PARAM(TypeTag, std::string, OutputDir, "The directory to which result files are written");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, OutputSelection,
+                             "Statements which restrict the output to a subset of the fields, a "
+                             "region of the domain and/or select per-field output intervals");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, OutputSelectionFile,
+                             "The name of a file containing statements for the output selection");
     }
 
     /*!
@@ -595,6 +721,9 @@ public:
         for (unsigned timeIdx = 1; timeIdx < historySize; ++timeIdx)
             solution(timeIdx) = solution(/*timeIdx=*/0);
 
+        // the initial solution can't be extrapolated
+        predictorHistory_.clear();
+
 #ifndef NDEBUG
         for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx)  {
             const auto& sol = solution(timeIdx);
@@ -1205,6 +1334,9 @@ public:
         linearizeTimer_.halt();
         solveTimer_.halt();
         updateTimer_.halt();
+        linearSolverSetupTimer_.halt();
+        linearSolverIterationTimer_.halt();
+        overlapSyncTimer_.halt();
 
         prePostProcessTimer_.start();
         asImp_().updateBegin();
@@ -1220,6 +1352,7 @@ public:
             linearizeTimer_ += newtonMethod_.linearizeTimer();
             solveTimer_ += newtonMethod_.solveTimer();
             updateTimer_ += newtonMethod_.updateTimer();
+            accumulateLinearSolverTimers_();
 
             throw;
         }
@@ -1239,6 +1372,7 @@ public:
         linearizeTimer_ += newtonMethod_.linearizeTimer();
         solveTimer_ += newtonMethod_.solveTimer();
         updateTimer_ += newtonMethod_.updateTimer();
+        accumulateLinearSolverTimers_();
 
         prePostProcessTimer_.start();
         if (converged)
@@ -1275,9 +1409,52 @@ public:
      * \brief Called by the update() method before it tries to
      *        apply the newton method. This is primary a hook
      *        which the actual model can overload.
+     *
+     * If the SolutionPredictorOrder parameter is larger than zero, the initial guess
+     * for the current solution is extrapolated from the previous time steps here.
      */
     void updateBegin()
-    { }
+    {
+        if (solutionPredictorOrder_ > 0)
+            asImp_().predictSolution_();
+    }
+
+    /*!
+     * \brief Returns true if the primary variables of a degree of freedom can be used
+     *        to extrapolate the initial guess of a time step.
+     *
+     * Models which switch the meaning of their primary variables must overload this
+     * method and return false if the meanings of the two vectors differ.
+     *
+     * \param globalDofIdx The global index of the degree of freedom
+     * \param pv1 The first vector of primary variables
+     * \param pv2 The second vector of primary variables
+     */
+    bool primaryVarsCompatible(unsigned globalDofIdx OPM_UNUSED,
+                               const PrimaryVariables& pv1 OPM_UNUSED,
+                               const PrimaryVariables& pv2 OPM_UNUSED) const
+    { return true; }
+
+    /*!
+     * \brief Returns true if the primary variables of a degree of freedom are within
+     *        their physically admissible range.
+     *
+     * This is used to decide whether the extrapolated initial guess of a time step can
+     * be used. By default, it is only checked that all primary variables are finite.
+     * Models whose primary variables are bounded (e.g., saturations or mole fractions)
+     * should overload this method.
+     *
+     * \param globalDofIdx The global index of the degree of freedom
+     * \param pv The vector of primary variables
+     */
+    bool primaryVarsAdmissible(unsigned globalDofIdx OPM_UNUSED,
+                               const PrimaryVariables& pv) const
+    {
+        for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx)
+            if (!std::isfinite(pv[pvIdx]))
+                return false;
+        return true;
+    }
 
     /*!
      * \brief Called by the update() method if it was
@@ -1366,6 +1543,11 @@ public:
         // at this point we can adapt the grid
         asImp_().adaptGrid();
 
+        // remember the solution which is about to be overwritten if the initial guess
+        // is extrapolated
+        if (solutionPredictorOrder_ > 0)
+            pushPredictorHistory_();
+
         // make the current solution the previous one.
         solution(/*timeIdx=*/1) = solution(/*timeIdx=*/0);
 
@@ -1494,6 +1676,19 @@ public:
     const ElementMapper& elementMapper() const
     { return elementMapper_; }
 
+    /*!
+     * \brief Returns the fields, the region and the output intervals selected for the
+     *        output.
+     */
+    const OutputSelection& outputSelection() const
+    { return outputSelection_; }
+
+    /*!
+     * \copydoc outputSelection() const
+     */
+    OutputSelection& outputSelection()
+    { return outputSelection_; }
+
     /*!
      * \brief Resets the Jacobian matrix linearizer, so that the
      *        boundary types can be altered.
@@ -1653,7 +1848,9 @@ public:
         auto modIt = outputModules_.begin();
         const auto& modEndIt = outputModules_.end();
         for (; modIt != modEndIt; ++modIt) {
+            (*modIt)->beginOutputStep();
             (*modIt)->allocBuffers();
+            (*modIt)->endBufferAllocation();
             needFullContextUpdate = needFullContextUpdate || (*modIt)->needExtensiveQuantities();
         }
 
@@ -1671,6 +1868,12 @@ public:
                     // ignore non-interior entities
                     continue;
 
+                if (outputSelection_.hasRegion()
+                    && !outputSelection_.elementSelected(elementMapper_.index(elem),
+                                                         elem.geometry().center()))
+                    // ignore elements outside of the region of interest
+                    continue;
+
                 if (needFullContextUpdate)
                     elemCtx.updateAll(elem);
                 else {
@@ -1801,7 +2004,35 @@ public:
     const Ewoms::Timer& updateTimer() const
     { return updateTimer_; }
 
+    /*!
+     * \brief Returns the timer for setting up the linear solver, i.e., the part of
+     *        solveTimer() which is spent on preparing the preconditioner.
+     */
+    const Ewoms::Timer& linearSolverSetupTimer() const
+    { return linearSolverSetupTimer_; }
+
+    /*!
+     * \brief Returns the timer for the iterations of the linear solver.
+     */
+    const Ewoms::Timer& linearSolverIterationTimer() const
+    { return linearSolverIterationTimer_; }
+
+    /*!
+     * \brief Returns the timer for synchronizing the linear system of equations with the
+     *        peer processes.
+     */
+    const Ewoms::Timer& overlapSyncTimer() const
+    { return overlapSyncTimer_; }
+
 protected:
+    void accumulateLinearSolverTimers_()
+    {
+        const auto& linearSolver = newtonMethod_.linearSolver();
+        linearSolverSetupTimer_ += linearSolver.setupTimer();
+        linearSolverIterationTimer_ += linearSolver.iterationTimer();
+        overlapSyncTimer_ += linearSolver.overlapSyncTimer();
+    }
+
     void resizeAndResetIntensiveQuantitiesCache_()
     {
         // allocate the storage cache
@@ -1829,6 +2060,105 @@ protected:
                                     unsigned timeIdx OPM_UNUSED)
     { }
 
+    // remember the solution of the previous time step before it is overwritten by the
+    // one of the time step which has just been completed. at this point, the simulated
+    // time has not been advanced yet, i.e., it is the one of the previous solution.
+    void pushPredictorHistory_()
+    {
+        const SolutionVector& prevSol = solution(/*timeIdx=*/1);
+        if (!predictorHistory_.empty()
+            && predictorHistory_.front().solution.size() != prevSol.size())
+            // the grid has been changed
+            predictorHistory_.clear();
+
+        predictorHistory_.push_front(PredictorHistoryEntry());
+        predictorHistory_.front().time = simulator_.time();
+        predictorHistory_.front().solution = prevSol;
+
+        while (predictorHistory_.size() > solutionPredictorOrder_)
+            predictorHistory_.pop_back();
+    }
+
+    // extrapolate the initial guess of the current time step from the solutions of the
+    // previous time steps using Lagrange polynomials. for degrees of freedom where the
+    // meaning of the primary variables differs between the time levels, the order of
+    // the extrapolation is reduced until they are compatible. it is reduced further
+    // if the extrapolated primary variables are not physically admissible, i.e., such
+    // degrees of freedom fall back to the solution of the last time step.
+    void predictSolution_()
+    {
+        const SolutionVector& lastSol = solution(/*timeIdx=*/1);
+        for (const auto& entry : predictorHistory_) {
+            if (entry.solution.size() != lastSol.size()) {
+                // the grid has been changed
+                predictorHistory_.clear();
+                return;
+            }
+        }
+
+        unsigned maxOrder =
+            std::min(solutionPredictorOrder_, static_cast<unsigned>(predictorHistory_.size()));
+        if (maxOrder == 0)
+            return;
+
+        // the points in time of the solutions which are used for the extrapolation
+        Scalar t[3];
+        t[0] = simulator_.time();
+        for (unsigned k = 1; k <= maxOrder; ++k)
+            t[k] = predictorHistory_[k - 1].time;
+        Scalar tNext = simulator_.time() + simulator_.timeStepSize();
+
+        // weights[order][k] is the weight of the k-th previous solution if a polynomial
+        // of the given order is used
+        Scalar weights[3][3] = {};
+        for (unsigned order = 0; order <= maxOrder; ++order) {
+            for (unsigned k = 0; k <= order; ++k) {
+                weights[order][k] = 1.0;
+                for (unsigned j = 0; j <= order; ++j) {
+                    if (j == k)
+                        continue;
+                    if (t[k] == t[j])
+                        // the time levels are not distinct, so we do not extrapolate
+                        return;
+                    weights[order][k] *= (tNext - t[j])/(t[k] - t[j]);
+                }
+            }
+        }
+
+        SolutionVector& sol = solution(/*timeIdx=*/0);
+        size_t numGridDof = asImp_().numGridDof();
+        for (unsigned dofIdx = 0; dofIdx < numGridDof; ++dofIdx) {
+            const PrimaryVariables& lastPv = lastSol[dofIdx];
+
+            unsigned order = 0;
+            while (order < maxOrder
+                   && asImp_().primaryVarsCompatible(dofIdx,
+                                                     lastPv,
+                                                     predictorHistory_[order].solution[dofIdx]))
+                ++ order;
+
+            // this also copies the meaning of the primary variables
+            PrimaryVariables& pv = sol[dofIdx];
+            for (; order > 0; --order) {
+                pv = lastPv;
+                for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                    Scalar value = weights[order][0]*lastPv[pvIdx];
+                    for (unsigned k = 1; k <= order; ++k)
+                        value += weights[order][k]*predictorHistory_[k - 1].solution[dofIdx][pvIdx];
+                    pv[pvIdx] = value;
+                }
+
+                if (asImp_().primaryVarsAdmissible(dofIdx, pv))
+                    break;
+            }
+
+            if (order == 0)
+                pv = lastPv;
+        }
+
+        invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+    }
+
     /*!
      * \brief Register all output modules which make sense for the model.
      *
@@ -1839,8 +2169,8 @@ protected:
     void registerOutputModules_()
     {
         // add the output modules available on all model
-        auto *mod = new Ewoms::VtkPrimaryVarsModule<TypeTag>(simulator_);
-        this->outputModules_.push_back(mod);
+        this->outputModules_.push_back(new Ewoms::VtkPrimaryVarsModule<TypeTag>(simulator_));
+        this->outputModules_.push_back(new Ewoms::VtkLinearizationCostModule<TypeTag>(simulator_));
     }
 
     /*!
@@ -1880,6 +2210,9 @@ protected:
     Ewoms::Timer linearizeTimer_;
     Ewoms::Timer solveTimer_;
     Ewoms::Timer updateTimer_;
+    Ewoms::Timer linearSolverSetupTimer_;
+    Ewoms::Timer linearSolverIterationTimer_;
+    Ewoms::Timer overlapSyncTimer_;
 
     // calculates the local jacobian matrix for a given element
     std::vector<LocalLinearizer> localLinearizer_;
@@ -1902,6 +2235,8 @@ protected:
 
 
     std::list<BaseOutputModule<TypeTag>*> outputModules_;
+    // the output step index is advanced by FvBaseProblem::writeOutput()
+    OutputSelection outputSelection_;
 
     Scalar gridTotalVolume_;
     std::vector<Scalar> dofTotalVolume_;
@@ -1913,6 +2248,17 @@ protected:
     bool enableIntensiveQuantityCache_;
     bool enableStorageCache_;
     bool enableThermodynamicHints_;
+
+    // the solutions of the time steps before the previous one, most recent first. they
+    // are only kept if the initial guess of each time step is extrapolated.
+    struct PredictorHistoryEntry
+    {
+        Scalar time;
+        SolutionVector solution;
+    };
+
+    unsigned solutionPredictorOrder_;
+    std::deque<PredictorHistoryEntry> predictorHistory_;
 };
 } // namespace Ewoms
 
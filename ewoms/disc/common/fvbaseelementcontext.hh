@@ -29,6 +29,7 @@
 #define EWOMS_FV_BASE_ELEMENT_CONTEXT_HH
 
 #include "fvbaseproperties.hh"
+#include "linearizationcounters.hh"
 
 #include <ewoms/common/alignedallocator.hh>
 
@@ -324,6 +325,20 @@ public:
     size_t numBoundaryFaces(unsigned timeIdx) const
     { return stencil(timeIdx).numBoundaryFaces(); }
 
+    /*!
+     * \brief Returns an estimate of the memory used by the element context [bytes].
+     *
+     * This does not account for the memory which is dynamically allocated by the
+     * stencil.
+     */
+    size_t memoryUsage() const
+    {
+        return
+            sizeof(*this)
+            + dofVars_.capacity()*sizeof(DofStore_)
+            + extensiveQuantities_.capacity()*sizeof(ExtensiveQuantities);
+    }
+
     /*!
      * \brief Return the current finite element geometry.
      *
@@ -559,11 +574,17 @@ protected:
             dofVars_[dofIdx].thermodynamicHint[timeIdx] =
                 model().thermodynamicHint(globalIdx, timeIdx);
 
+            auto& counts = LinearizationCounters::local();
+            if (dofVars_[dofIdx].thermodynamicHint[timeIdx])
+                ++ counts.thermodynamicHints;
+
             const auto *cachedIntQuants = model().cachedIntensiveQuantities(globalIdx, timeIdx);
             if (cachedIntQuants) {
+                ++ counts.intensiveQuantityCacheHits;
                 dofVars_[dofIdx].intensiveQuantities[timeIdx] = *cachedIntQuants;
             }
             else {
+                ++ counts.intensiveQuantityCacheMisses;
                 updateSingleIntQuants_(dofSol, dofIdx, timeIdx);
                 model().updateCachedIntensiveQuantities(dofVars_[dofIdx].intensiveQuantities[timeIdx],
                                                         globalIdx,
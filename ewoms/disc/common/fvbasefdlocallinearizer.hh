@@ -258,6 +258,29 @@ public:
         }
     }
 
+    /*!
+     * \brief Evaluate the residual of an element without computing its local Jacobian.
+     *
+     * This skips the perturbations of the primary variables, i.e., only the unperturbed
+     * residual is calculated. After calling this method, the local Jacobian matrix is
+     * undefined and the ElementContext is in an undefined state.
+     *
+     * \param elemCtx The element execution context for which the local residual should
+     *                be calculated.
+     * \param elem The grid element for which the local residual should be calculated.
+     */
+    void evalResidual(ElementContext& elemCtx, const Element& elem)
+    {
+        elemCtx.updateAll(elem);
+
+        size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
+        residual_.resize(numDof);
+        for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx)
+            residual_[dofIdx] = 0.0;
+
+        localResidual_.eval(residual_, elemCtx);
+    }
+
     /*!
      * \brief Returns the unweighted epsilon value used to calculate
      *        the local derivatives
@@ -29,11 +29,16 @@
 #define EWOMS_FV_BASE_LINEARIZER_HH
 
 #include "fvbaseproperties.hh"
+#include "linearizationcounters.hh"
 
 #include <ewoms/parallel/gridcommhandles.hh>
 #include <ewoms/parallel/threadmanager.hh>
 #include <ewoms/parallel/threadedentityiterator.hh>
+#include <ewoms/parallel/collectivecontext.hh>
 #include <ewoms/disc/common/baseauxiliarymodule.hh>
+#include <ewoms/common/profiler.hh>
+#include <ewoms/common/inneriterationcounter.hh>
+#include <ewoms/common/memoryregistry.hh>
 
 #include <opm/material/common/Exceptions.hpp>
 
@@ -42,7 +47,11 @@
 #include <dune/common/fmatrix.hh>
 
 #include <type_traits>
+#include <chrono>
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
 #include <vector>
 #include <thread>
 #include <set>
@@ -114,6 +123,15 @@ public:
         : jacobian_()
     {
         simulatorPtr_ = 0;
+        enableLinearizationCostMap_ = false;
+        enableLinearizationStatistics_ = false;
+        enableIncrementalLinearization_ = false;
+        incrementalLinearizationTolerance_ = 0.0;
+        incremental_ = false;
+        residualOnly_ = false;
+        fuseResidualError_ = false;
+        residualErrorValid_ = false;
+        residualError_ = 0.0;
     }
 
     ~FvBaseLinearizer()
@@ -128,7 +146,20 @@ public:
      * \brief Register all run-time parameters for the Jacobian linearizer.
      */
     static void registerParameters()
-    { }
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableLinearizationCostMap,
+                             "Measure the time and the number of inner iterations needed to "
+                             "linearize each element");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableLinearizationStatistics,
+                             "Print the throughput and the cache efficiency of each "
+                             "linearization");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIncrementalLinearization,
+                             "Only relinearize the elements which contain a degree of freedom "
+                             "that changed significantly since its last linearization");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, IncrementalLinearizationTolerance,
+                             "The accumulated relative change of a degree of freedom above "
+                             "which the elements containing it are relinearized");
+    }
 
     /*!
      * \brief Initialize the linearizer.
@@ -142,6 +173,11 @@ public:
     void init(Simulator& simulator)
     {
         simulatorPtr_ = &simulator;
+        enableLinearizationCostMap_ = EWOMS_GET_PARAM(TypeTag, bool, EnableLinearizationCostMap);
+        enableLinearizationStatistics_ = EWOMS_GET_PARAM(TypeTag, bool, EnableLinearizationStatistics);
+        enableIncrementalLinearization_ = EWOMS_GET_PARAM(TypeTag, bool, EnableIncrementalLinearization);
+        incrementalLinearizationTolerance_ =
+            EWOMS_GET_PARAM(TypeTag, Scalar, IncrementalLinearizationTolerance);
         eraseMatrix();
     }
 
@@ -155,6 +191,7 @@ public:
     void eraseMatrix()
     {
         jacobian_.reset();
+        elementLinearization_.clear();
     }
 
     /*!
@@ -180,46 +217,47 @@ public:
      */
     void linearizeDomain()
     {
-        // we defer the initialization of the Jacobian matrix until here because the
-        // auxiliary modules usually assume the problem, model and grid to be fully
-        // initialized...
-        if (!jacobian_)
-            initFirstIteration_();
+        CollectiveContext collectives(gridView_().comm());
+        linearizeDomain(collectives);
 
-        int succeeded;
-        try {
-            linearize_();
-            succeeded = 1;
-        }
-#if ! DUNE_VERSION_NEWER(DUNE_COMMON, 2,5)
-        catch (const Dune::Exception& e)
-        {
-            std::cout << "rank " << simulator_().gridView().comm().rank()
-                      << " caught an exception while linearizing:" << e.what()
-                      << "\n"  << std::flush;
-            succeeded = 0;
-        }
-#endif
-        catch (const std::exception& e)
         {
-            std::cout << "rank " << simulator_().gridView().comm().rank()
-                      << " caught an exception while linearizing:" << e.what()
-                      << "\n"  << std::flush;
-            succeeded = 0;
+            EWOMS_PROFILE_REGION("wait for peer processes");
+            collectives.resolve();
         }
-        catch (...)
-        {
-            std::cout << "rank " << simulator_().gridView().comm().rank()
-                      << " caught an exception while linearizing"
-                      << "\n"  << std::flush;
-            succeeded = 0;
-        }
-        succeeded = gridView_().comm().min(succeeded);
 
-        if (!succeeded)
+        if (collectives.failed())
             throw Opm::NumericalIssue("A process did not succeed in linearizing the system");
     }
 
+    /*!
+     * \brief Linearize the part of the non-linear system of equations that is associated
+     *        with the spatial domain without synchronizing with the peer processes.
+     *
+     * Instead of throwing an exception, a failure of the local process is recorded in
+     * the collective context, which must be resolved by the caller.
+     */
+    void linearizeDomain(CollectiveContext& collectives)
+    {
+        residualOnly_ = false;
+        linearizeDomain_(collectives);
+    }
+
+    /*!
+     * \brief Evaluate the residual of the spatial domain without modifying the
+     *        Jacobian matrix.
+     *
+     * This allows to reuse the Jacobian matrix of a previous linearization. Since the
+     * auxiliary modules write directly into the Jacobian matrix, they are not
+     * considered. Like linearizeDomain(CollectiveContext&), this method records a
+     * failure of the local process in the collective context.
+     */
+    void linearizeResidual(CollectiveContext& collectives)
+    {
+        residualOnly_ = true;
+        linearizeDomain_(collectives);
+        residualOnly_ = false;
+    }
+
     void finalize()
     { jacobian_->finalize(); }
 
@@ -229,11 +267,29 @@ public:
      */
     void linearizeAuxiliaryEquations()
     {
+        CollectiveContext collectives(gridView_().comm());
+        linearizeAuxiliaryEquations(collectives);
+        collectives.resolve();
+
+        if (collectives.failed())
+            throw Opm::NumericalIssue("linearization of an auxilary equation failed");
+    }
+
+    /*!
+     * \brief Linearize the auxiliary equations without synchronizing with the peer
+     *        processes.
+     *
+     * A failure of the local process is recorded in the collective context, which must
+     * be resolved by the caller.
+     */
+    void linearizeAuxiliaryEquations(CollectiveContext& collectives)
+    {
+        EWOMS_PROFILE_REGION("linearize auxiliary equations");
+
         // flush possible local caches into matrix structure
         jacobian_->commit();
 
         auto& model = model_();
-        const auto& comm = simulator_().gridView().comm();
         for (unsigned auxModIdx = 0; auxModIdx < model.numAuxiliaryModules(); ++auxModIdx) {
             bool succeeded = true;
             try {
@@ -257,10 +313,7 @@ public:
             }
 #endif
 
-            succeeded = comm.min(succeeded);
-
-            if (!succeeded)
-                throw Opm::NumericalIssue("linearization of an auxilary equation failed");
+            collectives.addFailure(!succeeded);
         }
     }
 
@@ -282,6 +335,28 @@ public:
     GlobalEqVector& residual()
     { return residual_; }
 
+    /*!
+     * \brief Returns true if the error of the Newton method for the residual of the
+     *        most recent linearization is available on the local process.
+     *
+     * If the residual of each degree of freedom is assembled by a single element (i.e.,
+     * no linearization lock is required), the model does not use any auxiliary modules
+     * and the incremental linearization is not active, the error is determined while
+     * the elements are linearized. Otherwise, the Newton method needs to compute the
+     * error from the residual.
+     */
+    bool hasResidualError() const
+    { return residualErrorValid_; }
+
+    /*!
+     * \brief Returns the error of the Newton method for the residual of the most recent
+     *        linearization on the local process.
+     *
+     * This is only meaningful if hasResidualError() returns true.
+     */
+    Scalar residualError() const
+    { return residualError_; }
+
     /*!
      * \brief Returns the map of constraint degrees of freedom.
      *
@@ -290,7 +365,141 @@ public:
     const std::map<unsigned, Constraints>& constraintsMap() const
     { return constraintsMap_; }
 
+    /*!
+     * \brief Returns the work done and the cache efficiency of each thread during the
+     *        most recent linearization of the spatial domain.
+     *
+     * The vector is indexed by the thread index and only considers the elements of the
+     * local process.
+     */
+    const std::vector<LinearizationCounters::Counts>& threadLinearizationCounts() const
+    { return threadCounts_; }
+
+    /*!
+     * \brief Returns true if the time needed to linearize each element is measured.
+     */
+    bool enableLinearizationCostMap() const
+    { return enableLinearizationCostMap_; }
+
+    /*!
+     * \brief Returns the wall clock time in microseconds which was needed to linearize
+     *        each element during the current time step.
+     *
+     * The vector is indexed by the element index and it is only non-empty if the
+     * EnableLinearizationCostMap parameter is set. Besides visualizing hotspots, its
+     * values are suitable as element weights for load balancing.
+     */
+    const std::vector<double>& elementLinearizationCost() const
+    { return elementLinearizationCost_; }
+
+    /*!
+     * \brief Returns the number of iterations of the local non-linear solvers needed by
+     *        each element during the current time step.
+     *
+     * \copydetails Ewoms::InnerIterationCounter
+     */
+    const std::vector<unsigned>& elementInnerIterations() const
+    { return elementInnerIterations_; }
+
+    /*!
+     * \brief Returns true if only the elements whose degrees of freedom changed
+     *        significantly are relinearized.
+     */
+    bool enableIncrementalLinearization() const
+    { return enableIncrementalLinearization_; }
+
+    /*!
+     * \brief Record the relative change of a degree of freedom by a solution update.
+     *
+     * The changes are accumulated until all elements which contain the degree of
+     * freedom have been relinearized. If incremental linearization is disabled, this
+     * method does nothing. A change of infinity forces the elements to be relinearized,
+     * e.g., if the meaning of the primary variables has been switched.
+     *
+     * \param globalDofIdx The global index of the degree of freedom
+     * \param relativeChange The weighted relative change of the primary variables, cf.
+     *                       FvBaseDiscretization::relativeDofError()
+     */
+    void addDofChange(unsigned globalDofIdx, Scalar relativeChange)
+    {
+        if (!enableIncrementalLinearization_ || dofChange_.empty())
+            return;
+
+        dofChange_[globalDofIdx] += relativeChange;
+    }
+
+    /*!
+     * \brief Returns the memory used by the Jacobian matrix and the residual [bytes].
+     */
+    size_t linearSystemMemoryUsage() const
+    {
+        size_t result = blockVectorMemoryUsage(residual_);
+        if (jacobian_)
+            result += bcrsMatrixMemoryUsage(jacobian_->istlMatrix());
+        return result;
+    }
+
+    /*!
+     * \brief Returns an estimate of the memory used by the element contexts of all
+     *        threads [bytes].
+     */
+    size_t elementContextMemoryUsage() const
+    {
+        size_t result = vectorMemoryUsage(elementCtx_);
+        for (const auto* elemCtx : elementCtx_)
+            if (elemCtx)
+                result += elemCtx->memoryUsage();
+        return result;
+    }
+
+    /*!
+     * \brief Returns the memory used by the linearization cost map [bytes].
+     */
+    size_t linearizationCostMapMemoryUsage() const
+    { return vectorMemoryUsage(elementLinearizationCost_) + vectorMemoryUsage(elementInnerIterations_); }
+
+    /*!
+     * \brief Returns the memory used by the cached local linearizations of the
+     *        incremental linearization mode [bytes].
+     */
+    size_t incrementalLinearizationMemoryUsage() const
+    {
+        size_t result =
+            vectorMemoryUsage(elementLinearization_)
+            + vectorMemoryUsage(dofChange_)
+            + vectorMemoryUsage(dofDirty_);
+        for (const auto& elemLin : elementLinearization_)
+            result +=
+                vectorMemoryUsage(elemLin.dofIndices)
+                + vectorMemoryUsage(elemLin.residual)
+                + vectorMemoryUsage(elemLin.jacobian);
+        return result;
+    }
+
 private:
+    // the local linearization of an element as it is kept by the incremental
+    // linearization mode
+    struct ElementLinearization
+    {
+        ElementLinearization()
+            : numPrimaryDof(0)
+            , valid(false)
+        {}
+
+        // the global indices of the degrees of freedom of the element's stencil. the
+        // first numPrimaryDof entries are the primary ones.
+        std::vector<unsigned> dofIndices;
+        unsigned numPrimaryDof;
+
+        // the local residual of the primary degrees of freedom
+        std::vector<VectorBlock> residual;
+
+        // the local Jacobian matrix, indexed by primaryDofIdx*dofIndices.size() + dofIdx
+        std::vector<MatrixBlock> jacobian;
+
+        bool valid;
+    };
+
     Simulator& simulator_()
     { return *simulatorPtr_; }
     const Simulator& simulator_() const
@@ -374,8 +583,10 @@ private:
     void resetSystem_()
     {
         residual_ = 0.0;
-        // zero all matrix entries
-        jacobian_->clear();
+        // zero all matrix entries unless the Jacobian of the previous linearization is
+        // to be kept
+        if (!residualOnly_)
+            jacobian_->clear();
     }
 
     // query the problem for all constraint degrees of freedom. note that this method is
@@ -424,10 +635,60 @@ private:
         }
     }
 
+    // linearize the spatial domain and record a failure of the local process in the
+    // collective context
+    void linearizeDomain_(CollectiveContext& collectives)
+    {
+        // we defer the initialization of the Jacobian matrix until here because the
+        // auxiliary modules usually assume the problem, model and grid to be fully
+        // initialized...
+        if (!jacobian_)
+            initFirstIteration_();
+
+        int succeeded;
+        try {
+            linearize_();
+            succeeded = 1;
+        }
+#if ! DUNE_VERSION_NEWER(DUNE_COMMON, 2,5)
+        catch (const Dune::Exception& e)
+        {
+            std::cout << "rank " << simulator_().gridView().comm().rank()
+                      << " caught an exception while linearizing:" << e.what()
+                      << "\n"  << std::flush;
+            succeeded = 0;
+        }
+#endif
+        catch (const std::exception& e)
+        {
+            std::cout << "rank " << simulator_().gridView().comm().rank()
+                      << " caught an exception while linearizing:" << e.what()
+                      << "\n"  << std::flush;
+            succeeded = 0;
+        }
+        catch (...)
+        {
+            std::cout << "rank " << simulator_().gridView().comm().rank()
+                      << " caught an exception while linearizing"
+                      << "\n"  << std::flush;
+            succeeded = 0;
+        }
+
+        collectives.addFailure(!succeeded);
+
+        if (enableLinearizationStatistics_)
+            printLinearizationStatistics_();
+    }
+
     // linearize the whole system
     void linearize_()
     {
-        resetSystem_();
+        residualErrorValid_ = false;
+
+        {
+            EWOMS_PROFILE_REGION("reset linear system");
+            resetSystem_();
+        }
 
         // before the first iteration of each time step, we need to update the
         // constraints. (i.e., we assume that constraints can be time dependent, but they
@@ -435,8 +696,30 @@ private:
         if (model_().newtonMethod().numIterations() == 0)
             updateConstraintsMap_();
 
+        // the linearization costs are accumulated over all iterations of a time step
+        if (enableLinearizationCostMap_
+            && (model_().newtonMethod().numIterations() == 0
+                || elementLinearizationCost_.size() != elementMapper_().size()))
+        {
+            elementLinearizationCost_.assign(elementMapper_().size(), 0.0);
+            elementInnerIterations_.assign(elementMapper_().size(), 0);
+        }
+
         applyConstraintsToSolution_();
 
+        prepareIncrementalLinearization_();
+
+        // if the residual of each degree of freedom is complete once its element has
+        // been linearized, the error of the Newton method can be determined while
+        // linearizing. the auxiliary modules modify the residual afterwards, though,
+        // and the residuals of the cached local linearizations of the incremental mode
+        // are those of the solution at which they were computed.
+        fuseResidualError_ =
+            !GET_PROP_VALUE(TypeTag, UseLinearizationLock)
+            && model_().numAuxiliaryModules() == 0
+            && !incremental_;
+        threadResidualError_.resize(ThreadManager::maxThreads());
+
         // to avoid a race condition if two threads handle an exception at the same time,
         // we use an explicit lock to control access to the exception storage object
         // amongst thread-local handlers
@@ -446,12 +729,24 @@ private:
         // parallel block below. initialized to null to indicate no exception
         std::exception_ptr exceptionPtr = nullptr;
 
+        // each thread stores its counters in a separate slot of this vector at the end
+        // of the parallel block, so no synchronization is required
+        threadCounts_.resize(ThreadManager::maxThreads());
+
         // relinearize the elements...
         ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_());
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
         {
+            EWOMS_PROFILE_REGION("linearize elements");
+
+            // discard anything that was counted outside of the linearization, e.g. by
+            // the output modules
+            LinearizationCounters::reset();
+            localResidualError_() = 0.0;
+            auto threadStartTime = std::chrono::steady_clock::now();
+
             ElementIterator elemIt = threadedElemIt.beginParallel();
             ElementIterator nextElemIt = elemIt;
             try {
@@ -473,7 +768,10 @@ private:
                     if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
                         continue;
 
-                    linearizeElement_(elem);
+                    if (enableLinearizationCostMap_)
+                        linearizeElementMeasured_(elem);
+                    else
+                        linearizeElement_(elem);
                 }
             }
             // If an exception occurs in the parallel block, it won't escape the
@@ -490,6 +788,13 @@ private:
                 exceptionPtr = std::current_exception();
                 threadedElemIt.setFinished();
             }
+
+            std::chrono::duration<double> busyTime =
+                std::chrono::steady_clock::now() - threadStartTime;
+            auto& counts = threadCounts_[ThreadManager::threadId()];
+            counts = LinearizationCounters::reset();
+            counts.busyTime = busyTime.count();
+            threadResidualError_[ThreadManager::threadId()] = localResidualError_();
         }  // parallel block
 
         // after reduction from the parallel block, exceptionPtr will point to
@@ -499,9 +804,146 @@ private:
             std::rethrow_exception(exceptionPtr);
         }
 
+        finishIncrementalLinearization_();
+
+        if (fuseResidualError_) {
+            residualError_ = 0.0;
+            for (Scalar threadError : threadResidualError_)
+                residualError_ = std::max(residualError_, threadError);
+            residualErrorValid_ = true;
+        }
+
+        EWOMS_PROFILE_REGION("apply constraints");
         applyConstraintsToLinearization_();
     }
 
+    // the maximum of the errors of the degrees of freedom which were linearized by the
+    // current thread
+    static Scalar& localResidualError_()
+    {
+        static thread_local Scalar value;
+        return value;
+    }
+
+    // add the error of a degree of freedom to the error of the current thread. this
+    // must only be called once the residual of the degree of freedom is complete.
+    void accumulateResidualError_(const Element& elem, unsigned globI)
+    {
+        // like the Newton method, only consider the degrees of freedom of the local
+        // process which are not constraint
+        if (elem.partitionType() != Dune::InteriorEntity)
+            return;
+        if (enableConstraints_() && constraintsMap_.count(globI) > 0)
+            return;
+
+        Scalar& error = localResidualError_();
+        error = std::max(error, model_().newtonMethod().dofError(globI, residual_[globI]));
+    }
+
+    // decide which degrees of freedom changed enough to relinearize the elements which
+    // contain them. all elements are relinearized at the beginning of each time step
+    // (i.e., also after the time step size was reduced because the Newton method
+    // failed) and after the sparsity pattern of the Jacobian matrix was changed.
+    void prepareIncrementalLinearization_()
+    {
+        // the Jacobian matrix is not assembled if only the residual is evaluated, so
+        // the cached local linearizations can neither be used nor updated
+        incremental_ = enableIncrementalLinearization_ && !residualOnly_;
+        if (!incremental_)
+            return;
+
+        size_t numDof = model_().numTotalDof();
+        size_t numElements = elementMapper_().size();
+        bool fullRefresh =
+            model_().newtonMethod().numIterations() == 0
+            || elementLinearization_.size() != numElements
+            || dofChange_.size() != numDof;
+
+        if (fullRefresh) {
+            elementLinearization_.resize(numElements);
+            for (auto& elemLin : elementLinearization_)
+                elemLin.valid = false;
+            dofChange_.assign(numDof, 0.0);
+        }
+
+        dofDirty_.resize(numDof);
+        for (size_t dofIdx = 0; dofIdx < numDof; ++ dofIdx)
+            dofDirty_[dofIdx] = dofChange_[dofIdx] > incrementalLinearizationTolerance_;
+    }
+
+    // all elements which contain a changed degree of freedom have been relinearized, so
+    // the change of these degrees of freedom starts to accumulate from scratch
+    void finishIncrementalLinearization_()
+    {
+        if (!incremental_)
+            return;
+
+        for (size_t dofIdx = 0; dofIdx < dofDirty_.size(); ++ dofIdx)
+            if (dofDirty_[dofIdx])
+                dofChange_[dofIdx] = 0.0;
+    }
+
+    // returns true if the cached local linearization of an element can be used
+    bool reuseElementLinearization_(const ElementLinearization& elemLin) const
+    {
+        if (!elemLin.valid)
+            return false;
+
+        for (unsigned globJ : elemLin.dofIndices)
+            if (dofDirty_[globJ])
+                return false;
+
+        return true;
+    }
+
+    // store the local linearization of an element for the incremental linearization
+    // mode
+    template <class LocalLinearizer>
+    void storeElementLinearization_(ElementLinearization& elemLin,
+                                    const ElementContext& elemCtx,
+                                    const LocalLinearizer& localLinearizer)
+    {
+        size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
+        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+
+        elemLin.dofIndices.resize(numDof);
+        for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx)
+            elemLin.dofIndices[dofIdx] = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+        elemLin.numPrimaryDof = static_cast<unsigned>(numPrimaryDof);
+
+        elemLin.residual.resize(numPrimaryDof);
+        elemLin.jacobian.resize(numPrimaryDof*numDof);
+        for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
+            elemLin.residual[primaryDofIdx] = localLinearizer.residual(primaryDofIdx);
+            for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx)
+                elemLin.jacobian[primaryDofIdx*numDof + dofIdx] =
+                    localLinearizer.jacobian(dofIdx, primaryDofIdx);
+        }
+
+        elemLin.valid = true;
+    }
+
+    // add the cached local linearization of an element to the global linear system
+    void scatterElementLinearization_(const ElementLinearization& elemLin)
+    {
+        size_t numDof = elemLin.dofIndices.size();
+
+        if (GET_PROP_VALUE(TypeTag, UseLinearizationLock))
+            globalMatrixMutex_.lock();
+
+        for (unsigned primaryDofIdx = 0; primaryDofIdx < elemLin.numPrimaryDof; ++ primaryDofIdx) {
+            unsigned globI = elemLin.dofIndices[primaryDofIdx];
+            residual_[globI] += elemLin.residual[primaryDofIdx];
+
+            for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx)
+                jacobian_->addToBlock(elemLin.dofIndices[dofIdx], globI,
+                                      elemLin.jacobian[primaryDofIdx*numDof + dofIdx]);
+        }
+
+        if (GET_PROP_VALUE(TypeTag, UseLinearizationLock))
+            globalMatrixMutex_.unlock();
+    }
+
     // linearize an element in the interior of the process' grid partition
     void linearizeElement_(const Element& elem)
     {
@@ -510,8 +952,34 @@ private:
         ElementContext *elementCtx = elementCtx_[threadId];
         auto& localLinearizer = model_().localLinearizer(threadId);
 
-        // the actual work of linearization is done by the local linearizer class
-        localLinearizer.linearize(*elementCtx, elem);
+        // in incremental mode, the elements whose degrees of freedom did not change
+        // significantly contribute their local linearization from the cache. each
+        // element is only handled by a single thread, so the cache entry can be
+        // accessed without synchronization.
+        ElementLinearization* elemLin = nullptr;
+        if (incremental_) {
+            elemLin = &elementLinearization_[elementMapper_().index(elem)];
+            if (reuseElementLinearization_(*elemLin)) {
+                ++ LinearizationCounters::local().numReusedElements;
+                scatterElementLinearization_(*elemLin);
+                return;
+            }
+        }
+
+        // the actual work of linearization is done by the local linearizer class. if
+        // the Jacobian matrix is not required, its local contribution is not computed.
+        if (residualOnly_)
+            localLinearizer.evalResidual(*elementCtx, elem);
+        else
+            localLinearizer.linearize(*elementCtx, elem);
+
+        auto& counts = LinearizationCounters::local();
+        ++ counts.numElements;
+        counts.numDof += elementCtx->numPrimaryDof(/*timeIdx=*/0);
+        counts.numFaces += elementCtx->numInteriorFaces(/*timeIdx=*/0);
+
+        if (elemLin)
+            storeElementLinearization_(*elemLin, *elementCtx, localLinearizer);
 
         // update the right hand side and the Jacobian matrix
         if (GET_PROP_VALUE(TypeTag, UseLinearizationLock))
@@ -523,6 +991,11 @@ private:
 
             // update the right hand side
             residual_[globI] += localLinearizer.residual(primaryDofIdx);
+            if (fuseResidualError_)
+                accumulateResidualError_(elem, globI);
+
+            if (residualOnly_)
+                continue;
 
             // update the global Jacobian matrix
             for (unsigned dofIdx = 0; dofIdx < elementCtx->numDof(/*timeIdx=*/0); ++ dofIdx) {
@@ -536,6 +1009,90 @@ private:
             globalMatrixMutex_.unlock();
     }
 
+    // linearize an element and record the time and the number of inner iterations this
+    // took. since each element is only linearized by a single thread, the elements of
+    // the cost map can be written without synchronization.
+    void linearizeElementMeasured_(const Element& elem)
+    {
+        unsigned elemIdx = static_cast<unsigned>(elementMapper_().index(elem));
+
+        InnerIterationCounter::reset();
+        auto startTime = std::chrono::steady_clock::now();
+
+        linearizeElement_(elem);
+
+        auto endTime = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::micro> dt = endTime - startTime;
+        elementLinearizationCost_[elemIdx] += dt.count();
+        elementInnerIterations_[elemIdx] += InnerIterationCounter::reset();
+    }
+
+    // print the throughput of each thread of the first process and the totals of the
+    // cache statistics over all processes
+    void printLinearizationStatistics_() const
+    {
+        const auto& comm = gridView_().comm();
+
+        LinearizationCounters::Counts total;
+        for (const auto& counts : threadCounts_)
+            total += counts;
+
+        unsigned long globalCounts[] = {
+            total.numElements,
+            total.numDof,
+            total.numFaces,
+            total.intensiveQuantityCacheHits,
+            total.intensiveQuantityCacheMisses,
+            total.thermodynamicHints,
+            total.storageCacheHits,
+            total.storageCacheMisses,
+            total.numReusedElements
+        };
+        comm.sum(globalCounts, sizeof(globalCounts)/sizeof(globalCounts[0]));
+
+        if (comm.rank() != 0)
+            return;
+
+        LinearizationCounters::Counts global;
+        global.numElements = globalCounts[0];
+        global.numDof = globalCounts[1];
+        global.numFaces = globalCounts[2];
+        global.intensiveQuantityCacheHits = globalCounts[3];
+        global.intensiveQuantityCacheMisses = globalCounts[4];
+        global.thermodynamicHints = globalCounts[5];
+        global.storageCacheHits = globalCounts[6];
+        global.storageCacheMisses = globalCounts[7];
+        global.numReusedElements = globalCounts[8];
+
+        unsigned long numIntQuantUpdates =
+            global.intensiveQuantityCacheHits + global.intensiveQuantityCacheMisses;
+
+        std::ostringstream oss;
+        oss << "Linearization statistics of Newton iteration "
+            << model_().newtonMethod().numIterations() << ":\n";
+        for (unsigned threadId = 0; threadId < threadCounts_.size(); ++ threadId) {
+            const auto& counts = threadCounts_[threadId];
+            double dt = std::max(counts.busyTime, 1e-100);
+            oss << "  thread " << threadId << ": "
+                << counts.numElements << " elements ("
+                << std::setprecision(3) << counts.numElements/dt << "/s), "
+                << counts.numDof << " DOFs (" << counts.numDof/dt << "/s), "
+                << counts.numFaces << " faces (" << counts.numFaces/dt << "/s)\n";
+        }
+        oss << "  intensive quantity cache: " << global.intensiveQuantityCacheHits << " hits, "
+            << global.intensiveQuantityCacheMisses << " misses ("
+            << 100*global.intensiveQuantityCacheHitRate() << "% hit rate)\n"
+            << "  thermodynamic hints: used for " << global.thermodynamicHints << " of "
+            << numIntQuantUpdates << " intensive quantity updates\n"
+            << "  storage cache: " << global.storageCacheHits << " hits, "
+            << global.storageCacheMisses << " misses ("
+            << 100*global.storageCacheHitRate() << "% hit rate)\n";
+        if (enableIncrementalLinearization_)
+            oss << "  incremental linearization: " << global.numElements << " elements relinearized, "
+                << global.numReusedElements << " taken from the cache\n";
+        std::cout << oss.str() << std::flush;
+    }
+
     // apply the constraints to the solution. (i.e., the solution of constraint degrees
     // of freedom is set to the value of the constraint.)
     void applyConstraintsToSolution_()
@@ -569,7 +1126,8 @@ private:
 
             // reset the column of the Jacobian matrix
             // put an identity matrix on the main diagonal of the Jacobian
-            jacobian_->clearRow(constraintDofIdx, Scalar(1.0));
+            if (!residualOnly_)
+                jacobian_->clearRow(constraintDofIdx, Scalar(1.0));
 
             // make the right-hand side of constraint DOFs zero
             residual_[constraintDofIdx] = 0.0;
@@ -592,6 +1150,37 @@ private:
     // the right-hand side
     GlobalEqVector residual_;
 
+    // true while only the residual is evaluated and the Jacobian matrix is left alone
+    bool residualOnly_;
+
+    // the error of the Newton method which is determined while linearizing the
+    // elements, and the partial maxima of the individual threads
+    bool fuseResidualError_;
+    bool residualErrorValid_;
+    Scalar residualError_;
+    std::vector<Scalar> threadResidualError_;
+
+    // the cached local linearization of each element and the accumulated relative
+    // change of each degree of freedom since the last relinearization of the elements
+    // containing it (only used if the EnableIncrementalLinearization parameter is set)
+    bool enableIncrementalLinearization_;
+    Scalar incrementalLinearizationTolerance_;
+    bool incremental_;
+    std::vector<ElementLinearization> elementLinearization_;
+    std::vector<Scalar> dofChange_;
+    std::vector<unsigned char> dofDirty_;
+
+    // the time in microseconds and the number of inner iterations needed to linearize
+    // each element (only used if the EnableLinearizationCostMap parameter is set)
+    bool enableLinearizationCostMap_;
+    std::vector<double> elementLinearizationCost_;
+    std::vector<unsigned> elementInnerIterations_;
+
+    // the work done and the cache efficiency of each thread during the most recent
+    // linearization
+    bool enableLinearizationStatistics_;
+    std::vector<LinearizationCounters::Counts> threadCounts_;
+
 
     std::mutex globalMatrixMutex_;
 };
@@ -29,6 +29,7 @@
 #define EWOMS_FV_BASE_LOCAL_RESIDUAL_HH
 
 #include "fvbaseproperties.hh"
+#include "linearizationcounters.hh"
 
 #include <ewoms/common/parametersystem.hh>
 #include <ewoms/common/alignedallocator.hh>
@@ -560,6 +561,7 @@ protected:
                     Opm::Valgrind::CheckDefined(tmp2);
 
                     model.updateCachedStorage(globalDofIdx, /*timeIdx=*/1, tmp2);
+                    ++ LinearizationCounters::local().storageCacheMisses;
                 }
                 else {
                     // if the mass storage at the beginning of the time step is not cached,
@@ -567,6 +569,7 @@ protected:
                     // iteration of the time step, we take the cached data.
                     tmp2 = model.cachedStorage(globalDofIdx, /*timeIdx=*/1);
                     Opm::Valgrind::CheckDefined(tmp2);
+                    ++ LinearizationCounters::local().storageCacheHits;
                 }
             }
             else {
@@ -575,6 +578,7 @@ protected:
                 tmp2 = 0.0;
                 asImp_().computeStorage(tmp2, elemCtx,  dofIdx, /*timeIdx=*/1);
                 Opm::Valgrind::CheckDefined(tmp2);
+                ++ LinearizationCounters::local().storageCacheMisses;
             }
 
             // Use the implicit Euler time discretization
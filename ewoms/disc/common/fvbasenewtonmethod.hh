@@ -31,7 +31,14 @@
 #include "fvbasenewtonconvergencewriter.hh"
 
 #include <ewoms/nonlinear/newtonmethod.hh>
+#include <ewoms/nonlinear/andersonacceleration.hh>
 #include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/parametersystem.hh>
+#include <ewoms/common/memoryregistry.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace Ewoms {
 
@@ -66,6 +73,14 @@ NEW_PROP_TAG(DiscNewtonMethod);
 //! The class implementing the Newton algorithm
 NEW_PROP_TAG(NewtonMethod);
 
+//! The number of previous Newton iterations which are used to accelerate the update
+//! of a stalled Newton method (Anderson acceleration). 0 disables the acceleration.
+NEW_PROP_TAG(NewtonAndersonDepth);
+
+//! The ratio of the errors of two consecutive Newton iterations above which the
+//! Newton method is considered to be stalled and the update is accelerated
+NEW_PROP_TAG(NewtonAndersonStallRatio);
+
 // set default values
 SET_TYPE_PROP(FvBaseNewtonMethod, DiscNewtonMethod,
               Ewoms::FvBaseNewtonMethod<TypeTag>);
@@ -73,6 +88,8 @@ SET_TYPE_PROP(FvBaseNewtonMethod, NewtonMethod,
               typename GET_PROP_TYPE(TypeTag, DiscNewtonMethod));
 SET_TYPE_PROP(FvBaseNewtonMethod, NewtonConvergenceWriter,
               Ewoms::FvBaseNewtonConvergenceWriter<TypeTag>);
+SET_INT_PROP(FvBaseNewtonMethod, NewtonAndersonDepth, 0);
+SET_SCALAR_PROP(FvBaseNewtonMethod, NewtonAndersonStallRatio, 0.7);
 
 END_PROPERTIES
 
@@ -102,15 +119,65 @@ class FvBaseNewtonMethod : public NewtonMethod<TypeTag>
     typedef typename GET_PROP_TYPE(TypeTag, PrimaryVariables) PrimaryVariables;
     typedef typename GET_PROP_TYPE(TypeTag, EqVector) EqVector;
 
+    enum { numEq = GET_PROP_VALUE(TypeTag, NumEq) };
 
 public:
     FvBaseNewtonMethod(Simulator& simulator)
         : ParentType(simulator)
-    { }
+    {
+        anderson_.setDepth(static_cast<unsigned>(std::max(0, EWOMS_GET_PARAM(TypeTag, int, NewtonAndersonDepth))));
+        numAcceleratedIterations_ = 0;
+
+        auto& memoryRegistry = simulator.memoryRegistry();
+        memoryRegistry.add("Anderson acceleration history",
+                           [this]() -> size_t
+                           {
+                               return
+                                   anderson_.memoryUsage()
+                                   + blockVectorMemoryUsage(acceleratedUpdate_);
+                           });
+    }
+
+    /*!
+     * \brief Register all run-time parameters for the Newton method.
+     */
+    static void registerParameters()
+    {
+        ParentType::registerParameters();
+
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonAndersonDepth,
+                             "The number of previous Newton iterations which are used "
+                             "to accelerate a stalled Newton method. 0 disables the "
+                             "Anderson acceleration");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonAndersonStallRatio,
+                             "The ratio of the errors of two consecutive Newton "
+                             "iterations above which the update is accelerated");
+    }
+
+    /*!
+     * \brief Returns the number of Newton iterations of the last invocation of the
+     *        Newton method which used an accelerated update.
+     */
+    unsigned numAcceleratedIterations() const
+    { return numAcceleratedIterations_; }
 
 protected:
     friend class Ewoms::NewtonMethod<TypeTag>;
 
+    /*!
+     * \brief Called before the Newton method is applied to an non-linear system of
+     *        equations.
+     *
+     * \param u The initial solution
+     */
+    void begin_(const SolutionVector& u)
+    {
+        ParentType::begin_(u);
+
+        numAcceleratedIterations_ = 0;
+        anderson_.clear();
+    }
+
     /*!
      * \brief Update the current solution with a delta vector.
      *
@@ -133,7 +200,10 @@ protected:
                  const GlobalEqVector& solutionUpdate,
                  const GlobalEqVector& currentResidual)
     {
-        ParentType::update_(nextSolution, currentSolution, solutionUpdate, currentResidual);
+        if (anderson_.depth() > 0 && asImp_().accelerateUpdate_(currentSolution, solutionUpdate))
+            ParentType::update_(nextSolution, currentSolution, acceleratedUpdate_, currentResidual);
+        else
+            ParentType::update_(nextSolution, currentSolution, solutionUpdate, currentResidual);
 
         // make sure that the intensive quantities get recalculated at the next
         // linearization
@@ -143,6 +213,24 @@ protected:
                                                                   /*timeIdx=*/0,
                                                                   /*valid=*/false);
         }
+
+        // tell the linearizer how much each degree of freedom has changed, so that it
+        // can decide which elements need to be relinearized. the values of the primary
+        // variables cannot be compared if their meaning has changed, so the elements of
+        // such degrees of freedom are always relinearized.
+        auto& linearizer = model_().linearizer();
+        if (linearizer.enableIncrementalLinearization()) {
+            for (unsigned dofIdx = 0; dofIdx < model_().numGridDof(); ++dofIdx) {
+                Scalar change = std::numeric_limits<Scalar>::infinity();
+                if (model_().primaryVarsCompatible(dofIdx,
+                                                   currentSolution[dofIdx],
+                                                   nextSolution[dofIdx]))
+                    change = model_().relativeDofError(dofIdx,
+                                                       currentSolution[dofIdx],
+                                                       nextSolution[dofIdx]);
+                linearizer.addDofChange(dofIdx, change);
+            }
+        }
     }
 
     /*!
@@ -155,6 +243,90 @@ protected:
         ParentType::beginIteration_();
     }
 
+    /*!
+     * \copydoc NewtonMethod::lineSearchTrialSolution_
+     *
+     * The primary variables of degrees of freedom which switched their meaning during
+     * the full update cannot be interpolated, so these use the full update.
+     */
+    void lineSearchTrialSolution_(SolutionVector& trialSolution,
+                                  const SolutionVector& currentSolution,
+                                  const SolutionVector& fullStepSolution,
+                                  Scalar lambda)
+    {
+        ParentType::lineSearchTrialSolution_(trialSolution,
+                                             currentSolution,
+                                             fullStepSolution,
+                                             lambda);
+
+        for (unsigned dofIdx = 0; dofIdx < model_().numGridDof(); ++dofIdx) {
+            if (!model_().primaryVarsCompatible(dofIdx,
+                                                currentSolution[dofIdx],
+                                                fullStepSolution[dofIdx]))
+                trialSolution[dofIdx] = fullStepSolution[dofIdx];
+        }
+
+        // the intensive quantities need to be recalculated for the trial solution
+        if (model_().storeIntensiveQuantities()) {
+            for (unsigned dofIdx = 0; dofIdx < model_().numGridDof(); ++dofIdx)
+                model_().setIntensiveQuantitiesCacheEntryValidity(dofIdx,
+                                                                  /*timeIdx=*/0,
+                                                                  /*valid=*/false);
+        }
+    }
+
+    /*!
+     * \brief Compute an accelerated update if the Newton method stalls.
+     *
+     * The update is accelerated using AndersonAcceleration. It is passed through the
+     * model's updatePrimaryVariables_() method, i.e., the limits which the model
+     * imposes on the update still apply. Since the history uses the iterates which
+     * resulted from the limited updates, this does not spoil the acceleration. Degrees
+     * of freedom whose primary variables switched their meaning within the history
+     * and auxiliary degrees of freedom are updated by the plain Newton step.
+     *
+     * \return true if the accelerated update has been stored in acceleratedUpdate_.
+     */
+    bool accelerateUpdate_(const SolutionVector& currentSolution,
+                           const GlobalEqVector& solutionUpdate)
+    {
+        const auto& model = model_();
+        size_t numGridDof = model.numGridDof();
+
+        anderson_.push(currentSolution, solutionUpdate,
+                       [&model, numGridDof](unsigned dofIdx,
+                                            const PrimaryVariables& pvNew,
+                                            const PrimaryVariables& pvOld) -> bool
+                       {
+                           return dofIdx < numGridDof
+                               && model.primaryVarsCompatible(dofIdx, pvNew, pvOld);
+                       });
+
+        // only accelerate if the Newton method does not make good progress. since the
+        // errors are global quantities, all processes come to the same decision
+        Scalar stallRatio = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonAndersonStallRatio);
+        if (anderson_.historySize() == 0 || this->error_ < stallRatio*this->lastError_)
+            return false;
+
+        bool accelerated =
+            anderson_.accelerate(acceleratedUpdate_, solutionUpdate,
+                                 [&model](unsigned dofIdx, unsigned pvIdx) -> Scalar
+                                 {
+                                     if (!model.isLocalDof(dofIdx))
+                                         return 0.0;
+                                     return model.primaryVarWeight(dofIdx, pvIdx);
+                                 },
+                                 [&model](Scalar* values, int n)
+                                 { model.gridView().comm().sum(values, n); });
+        if (!accelerated)
+            return false;
+
+        ++ numAcceleratedIterations_;
+        this->endIterMsg() << ", Anderson accelerated (depth "
+                           << anderson_.historySize() << ")";
+        return true;
+    }
+
     /*!
      * \brief Returns a reference to the model.
      */
@@ -167,6 +339,11 @@ protected:
     const Model& model_() const
     { return ParentType::model(); }
 
+    AndersonAcceleration<SolutionVector, GlobalEqVector> anderson_;
+    unsigned numAcceleratedIterations_;
+
+    GlobalEqVector acceleratedUpdate_;
+
 private:
     Implementation& asImp_()
     { return *static_cast<Implementation*>(this); }
@@ -29,9 +29,14 @@
 #define EWOMS_FV_BASE_PROBLEM_HH
 
 #include "fvbaseproperties.hh"
+#include "fvbasetimestepcontrol.hh"
 
 #include <ewoms/io/vtkmultiwriter.hh>
+#include <ewoms/io/vtkappendedrawwriter.hh>
+#include <ewoms/io/timeserieswriter.hh>
 #include <ewoms/io/restart.hh>
+#include <ewoms/io/timingreceipt.hh>
+#include <ewoms/common/profiler.hh>
 #include <ewoms/disc/common/restrictprolong.hh>
 
 #include <opm/material/common/Unused.hpp>
@@ -41,6 +46,7 @@
 
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <string>
 
 #include <sys/stat.h>
@@ -65,6 +71,7 @@ private:
 
     static const int vtkOutputFormat = GET_PROP_VALUE(TypeTag, VtkOutputFormat);
     typedef Ewoms::VtkMultiWriter<GridView, vtkOutputFormat> VtkMultiWriter;
+    typedef Ewoms::VtkAppendedRawWriter<GridView> VtkAppendedRawWriter;
 
     typedef typename GET_PROP_TYPE(TypeTag, Model) Model;
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
@@ -110,6 +117,7 @@ public:
      */
     FvBaseProblem(Simulator& simulator)
         : nextTimeStepSize_(0.0)
+        , numTimeStepCuts_(0)
         , gridView_(simulator.gridView())
 #if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
         , elementMapper_(gridView_, Dune::mcmgElementLayout())
@@ -122,7 +130,22 @@ public:
         , boundingBoxMax_(-std::numeric_limits<double>::max())
         , simulator_(simulator)
         , defaultVtkWriter_(0)
+        , appendedRawVtkWriter_(0)
+        , timeSeriesWriter_(0)
+        , timeStepControl_(FvBaseTimeStepControl<TypeTag>::create(simulator))
     {
+        // the VTK writers are created later, so check which one is used when the
+        // memory usage is requested
+        simulator.memoryRegistry().add("output buffers (peak)",
+                                       [this]() -> size_t
+                                       {
+                                           if (defaultVtkWriter_)
+                                               return defaultVtkWriter_->peakBufferBytes();
+                                           if (appendedRawVtkWriter_)
+                                               return appendedRawVtkWriter_->peakBufferBytes();
+                                           return 0;
+                                       });
+
         // calculate the bounding box of the local partition of the grid view
         VertexIterator vIt = gridView_.template begin<dim>();
         const VertexIterator vEndIt = gridView_.template end<dim>();
@@ -139,7 +162,21 @@ public:
             boundingBoxMax_[i] = gridView_.comm().max(boundingBoxMax_[i]);
         }
 
-        if (enableVtkOutput_()) {
+        if (enableVtkOutput_() && EWOMS_GET_PARAM(TypeTag, bool, EnableVtkAppendedRawOutput)) {
+            // this writer copies all data and does not communicate while writing, so
+            // it can be used asynchronously for parallel runs and with grid adaptivity
+            bool asyncVtkOutput = EWOMS_GET_PARAM(TypeTag, bool, EnableAsyncVtkOutput);
+            int compressionLevel = EWOMS_GET_PARAM(TypeTag, int, VtkCompressionLevel);
+            unsigned compressionThreads = EWOMS_GET_PARAM(TypeTag, unsigned, VtkCompressionThreads);
+
+            std::string outputDir = asImp_().outputDir();
+
+            appendedRawVtkWriter_ =
+                new VtkAppendedRawWriter(asyncVtkOutput, gridView_, outputDir, asImp_().name(),
+                                         /*multiFileName=*/"", compressionLevel, compressionThreads,
+                                         vtkOutputBufferDepth_(), vtkOutputBufferMemoryLimit_());
+        }
+        else if (enableVtkOutput_()) {
             bool asyncVtkOutput =
                 simulator_.gridView().comm().size() == 1 &&
                 EWOMS_GET_PARAM(TypeTag, bool, EnableAsyncVtkOutput);
@@ -155,12 +192,24 @@ public:
             std::string outputDir = asImp_().outputDir();
 
             defaultVtkWriter_ =
-                new VtkMultiWriter(asyncVtkOutput, gridView_, outputDir, asImp_().name());
+                new VtkMultiWriter(asyncVtkOutput, gridView_, outputDir, asImp_().name(),
+                                   /*multiFileName=*/"",
+                                   vtkOutputBufferDepth_(), vtkOutputBufferMemoryLimit_());
         }
+
+        if (enableVtkOutput_() && EWOMS_GET_PARAM(TypeTag, bool, EnableTimeSeriesOutput))
+            timeSeriesWriter_ =
+                new TimeSeriesWriter(asImp_().outputDir(), asImp_().name(),
+                                     static_cast<unsigned>(gridView_.comm().rank()),
+                                     static_cast<unsigned>(gridView_.comm().size()));
     }
 
     ~FvBaseProblem()
-    { delete defaultVtkWriter_; }
+    {
+        delete defaultVtkWriter_;
+        delete appendedRawVtkWriter_;
+        delete timeSeriesWriter_;
+    }
 
     /*!
      * \brief Registers all available parameters for the problem and
@@ -174,14 +223,37 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, MinTimeStepSize,
                              "The minimum size to which all time steps are limited to [s]");
         EWOMS_REGISTER_PARAM(TypeTag, unsigned, MaxTimeStepDivisions,
-                             "The maximum number of divisions by two of the timestep size "
+                             "The maximum number of times the time step size may be cut "
                              "before the simulation bails out");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableAsyncVtkOutput,
                              "Dispatch a separate thread to write the VTK output");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, VtkOutputBufferDepth,
+                             "The maximum number of time steps for which the VTK output "
+                             "may be kept in memory at the same time (1: wait until the "
+                             "previous output has been written)");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, VtkOutputBufferMemoryLimit,
+                             "The maximum memory which may be occupied by the VTK output "
+                             "that waits to be written [MiB]");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableVtkAppendedRawOutput,
+                             "Write the VTK output as appended raw binary data instead of "
+                             "using Dune's VTK writer");
+        EWOMS_REGISTER_PARAM(TypeTag, int, VtkCompressionLevel,
+                             "The zlib compression level of the appended raw VTK output "
+                             "(0: uncompressed, 1 to 9: fastest to best compression)");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, VtkCompressionThreads,
+                             "The number of threads used to compress the appended raw VTK output");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableTimeSeriesOutput,
+                             "Additionally write the output fields of all time steps to a "
+                             "columnar time series file (requires the VTK output to be enabled)");
         EWOMS_REGISTER_PARAM(TypeTag, bool, ContinueOnConvergenceError,
                              "Continue with a non-converged solution instead of giving up "
                              "if we encounter a time step size smaller than the minimum time "
                              "step size.");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, TimingReceiptFile,
+                             "The name of the file to which the timing receipt is written "
+                             "as a JSON object at the end of the simulation (empty: none)");
+
+        FvBaseTimeStepControl<TypeTag>::registerParameters();
     }
 
     /*!
@@ -304,8 +376,10 @@ public:
         elementMapper_.update();
         vertexMapper_.update();
 
-        if (enableVtkOutput_())
+        if (defaultVtkWriter_)
             defaultVtkWriter_->gridChanged();
+        if (appendedRawVtkWriter_)
+            appendedRawVtkWriter_->gridChanged();
     }
 
     /*!
@@ -460,17 +534,87 @@ public:
     {
         const auto& executionTimer = simulator().executionTimer();
 
-        Scalar executionTime = executionTimer.realTimeElapsed();
-        Scalar setupTime = simulator().setupTimer().realTimeElapsed();
-        Scalar prePostProcessTime = simulator().prePostProcessTimer().realTimeElapsed();
-        Scalar localCpuTime = executionTimer.cpuTimeElapsed();
-        Scalar globalCpuTime = executionTimer.globalCpuTimeElapsed();
-        Scalar writeTime = simulator().writeTimer().realTimeElapsed();
-        Scalar linearizeTime = simulator().linearizeTimer().realTimeElapsed();
-        Scalar solveTime = simulator().solveTimer().realTimeElapsed();
-        Scalar updateTime = simulator().updateTimer().realTimeElapsed();
-        unsigned numProcesses = static_cast<unsigned>(this->gridView().comm().size());
-        unsigned threadsPerProcess = ThreadManager::maxThreads();
+        TimingReceipt receipt;
+        receipt.problemName = asImp_().name();
+        receipt.numProcesses = static_cast<unsigned>(this->gridView().comm().size());
+        receipt.threadsPerProcess = ThreadManager::maxThreads();
+        receipt.numTimeSteps = static_cast<unsigned>(simulator().timeStepIndex());
+        receipt.numDof = gridView().comm().sum(static_cast<unsigned long>(model().numGridDof()));
+        receipt.executionTime = executionTimer.realTimeElapsed();
+        receipt.setupTime = simulator().setupTimer().realTimeElapsed();
+        receipt.prePostProcessTime = simulator().prePostProcessTimer().realTimeElapsed();
+        receipt.localCpuTime = executionTimer.cpuTimeElapsed();
+        receipt.globalCpuTime = executionTimer.globalCpuTimeElapsed();
+        receipt.writeTime = simulator().writeTimer().realTimeElapsed();
+        receipt.linearizeTime = simulator().linearizeTimer().realTimeElapsed();
+        receipt.solveTime = simulator().solveTimer().realTimeElapsed();
+        receipt.linearSolverSetupTime = simulator().linearSolverSetupTimer().realTimeElapsed();
+        receipt.linearSolverIterationTime = simulator().linearSolverIterationTimer().realTimeElapsed();
+        receipt.overlapSyncTime = simulator().overlapSyncTimer().realTimeElapsed();
+        receipt.updateTime = simulator().updateTimer().realTimeElapsed();
+        receipt.numTimeStepCuts = timeStepControl_->numTimeStepCuts();
+        receipt.numNewtonIterations = timeStepControl_->numNewtonIterations();
+        receipt.numFailedNewtonIterations = timeStepControl_->numFailedNewtonIterations();
+        receipt.numLinearIterations = model().newtonMethod().totalLinearIterations();
+        receipt.numSavedLinearIterations = model().newtonMethod().estimatedSavedLinearIterations();
+
+        Scalar executionTime = receipt.executionTime;
+        Scalar setupTime = receipt.setupTime;
+        Scalar prePostProcessTime = receipt.prePostProcessTime;
+        Scalar localCpuTime = receipt.localCpuTime;
+        Scalar globalCpuTime = receipt.globalCpuTime;
+        Scalar writeTime = receipt.writeTime;
+        Scalar linearizeTime = receipt.linearizeTime;
+        Scalar solveTime = receipt.solveTime;
+        Scalar updateTime = receipt.updateTime;
+        unsigned numProcesses = receipt.numProcesses;
+        unsigned threadsPerProcess = receipt.threadsPerProcess;
+
+        // the amount of data written by the VTK output and the time spent on encoding
+        // and writing it (which happens in the background for asynchronous output)
+        double outputBytes = 0.0;
+        Scalar outputIoTime = 0.0;
+        if (defaultVtkWriter_) {
+            defaultVtkWriter_->flush();
+            outputBytes = static_cast<double>(defaultVtkWriter_->numBytesWritten());
+            outputIoTime = defaultVtkWriter_->ioTimer().realTimeElapsed();
+        }
+        else if (appendedRawVtkWriter_) {
+            appendedRawVtkWriter_->flush();
+            outputBytes = static_cast<double>(appendedRawVtkWriter_->numBytesWritten());
+            outputIoTime = appendedRawVtkWriter_->ioTimer().realTimeElapsed();
+        }
+        outputBytes = gridView().comm().sum(outputBytes);
+        outputIoTime = gridView().comm().max(outputIoTime);
+        Scalar outputMiB = outputBytes/(1024.0*1024.0);
+        receipt.outputBytes = outputBytes;
+        receipt.outputIoTime = outputIoTime;
+
+        // the minimum, average and maximum time of the solver phases across all
+        // processes
+        receipt.loadImbalance = simulator().loadImbalanceReport();
+        const auto& loadImbalance = receipt.loadImbalance;
+
+        const auto& perfCounters = PerfCounters::instance();
+        if (PerfCounters::isEnabled())
+            receipt.perfCounters = perfCounters.statistics();
+
+        // the peak memory usage of each process
+        double localPeakRss = static_cast<double>(MemoryRegistry::peakRss());
+        receipt.peakRss.resize(numProcesses);
+        gridView().comm().gather(&localPeakRss, receipt.peakRss.data(), /*len=*/1, /*root=*/0);
+        if (simulator().enableMemoryReport())
+            simulator().memoryRegistry().print(std::cout, gridView().comm(),
+                                               "Memory usage at the end of the simulation:");
+
+        // write the receipt in a machine-readable form if requested
+        const std::string& receiptFileName = EWOMS_GET_PARAM(TypeTag, std::string, TimingReceiptFile);
+        if (!receiptFileName.empty() && gridView().comm().rank() == 0)
+            receipt.writeJson(receiptFileName);
+
+        // the summary of the performance log contains the same figures
+        simulator().performanceLog().writeSummary(receipt);
+
         if (gridView().comm().rank() == 0) {
             std::cout << std::setprecision(3)
                       << "Simulation of problem '" << asImp_().name() << "' finished.\n"
@@ -494,10 +638,31 @@ public:
                       << "Number of processes: " << numProcesses << "\n"
                       << "Threads per processes: " << threadsPerProcess << "\n"
                       << "Total CPU time: " << globalCpuTime << " seconds" << Simulator::humanReadableTime(globalCpuTime) << "\n"
-                      << "\n"
+                      << "Output volume: " << outputMiB << " MiB, encoded and written at "
+                      << ((outputIoTime > 0) ? outputMiB/outputIoTime : 0.0) << " MiB/s\n"
+                      << "Peak resident set size: " << MemoryRegistry::toMiB(receipt.maxPeakRss())
+                      << " MiB (maximum over all processes), "
+                      << MemoryRegistry::toMiB(receipt.avgPeakRss()) << " MiB (average)\n";
+            timeStepControl_->printStatistics(std::cout);
+            std::cout << "Linear solver iterations: " << receipt.numLinearIterations;
+            if (receipt.numSavedLinearIterations > 0)
+                std::cout << ", about " << static_cast<unsigned long>(receipt.numSavedLinearIterations + 0.5)
+                          << " saved by the adaptive linear tolerance";
+            std::cout << "\n";
+            if (numProcesses > 1) {
+                std::cout << "Load imbalance across processes:\n";
+                loadImbalance.print(std::cout);
+                std::cout << std::setprecision(3);
+            }
+            if (!receipt.perfCounters.empty()) {
+                std::cout << "Hardware performance counters of the first process:\n";
+                perfCounters.print(std::cout, receipt.numDof/receipt.numProcesses);
+                std::cout << std::setprecision(3);
+            }
+            std::cout << "\n"
                       << "Note 1: If not stated otherwise, all times are wall clock times\n"
                       << "Note 2: Taxes and administrative overhead are "
-                      << (executionTime - (linearizeTime+solveTime+updateTime+prePostProcessTime+writeTime))/executionTime*100
+                      << receipt.overheadTime()/executionTime*100
                       << "%\n"
                       << "\n"
                       << "Our simulation hours are 24/7. Thank you for choosing us.\n"
@@ -505,6 +670,20 @@ public:
                       << "\n"
                       << std::flush;
         }
+
+#if EWOMS_ENABLE_PROFILING
+        // write the profile of each process as a timeline and as an aggregated tree
+        int rank = gridView().comm().rank();
+        const auto& profiler = Profiler::instance();
+        std::string profileName = asImp_().outputDir()+"/"+asImp_().name()+"-p"+std::to_string(rank);
+        profiler.writeChromeTrace(profileName+".trace.json", rank);
+        profiler.printTree(profileName+".profile.txt");
+        if (rank == 0) {
+            std::cout << "Profile of the first process:\n";
+            profiler.printTree(std::cout);
+            std::cout << "\n" << std::flush;
+        }
+#endif
     }
 
     /*!
@@ -517,19 +696,23 @@ public:
         Scalar minTimeStepSize = asImp_().minTimeStepSize();
 
         std::string errorMessage;
+        numTimeStepCuts_ = 0;
         for (unsigned i = 0; i < maxFails; ++i) {
             bool converged = model().update();
-            if (converged)
+            if (converged) {
+                timeStepControl_->timeStepSucceeded(simulator().timeStepSize());
                 return;
+            }
 
             Scalar dt = simulator().timeStepSize();
-            Scalar nextDt = dt / 2.0;
+            Scalar nextDt = timeStepControl_->timeStepFailed(dt);
             if (dt < minTimeStepSize*(1 + 1e-9)) {
                 if (asImp_().continueOnConvergenceError()) {
                     if (gridView().comm().rank() == 0)
                         std::cout << "Newton solver did not converge with minimum time step of "
                                   << dt << " seconds. Continuing with unconverged solution!\n"
                                   << std::flush;
+                    timeStepControl_->timeStepSucceeded(dt);
                     return;
                 }
                 else {
@@ -542,6 +725,7 @@ public:
             else if (nextDt < minTimeStepSize)
                 nextDt = minTimeStepSize;
             simulator().setTimeStepSize(nextDt);
+            ++numTimeStepCuts_;
 
             // update failed
             if (gridView().comm().rank() == 0)
@@ -558,6 +742,13 @@ public:
         throw std::runtime_error(errorMessage);
     }
 
+    /*!
+     * \brief Returns the number of times the time step size was cut during the last
+     *        call of timeIntegration().
+     */
+    unsigned numTimeStepCuts() const
+    { return numTimeStepCuts_; }
+
     /*!
      * \brief Returns the minimum allowable size of a time step.
      */
@@ -595,8 +786,10 @@ public:
         if (nextTimeStepSize_ > 0.0)
             return nextTimeStepSize_;
 
-        Scalar dtNext = std::min(EWOMS_GET_PARAM(TypeTag, Scalar, MaxTimeStepSize),
-                                 newtonMethod().suggestTimeStepSize(simulator().timeStepSize()));
+        Scalar dtNext = timeStepControl_->suggestTimeStepSize(simulator().timeStepSize());
+        if (timeStepControl_->limitsTimeStepSize())
+            dtNext = std::max(asImp_().minTimeStepSize(), dtNext);
+        dtNext = std::min(EWOMS_GET_PARAM(TypeTag, Scalar, MaxTimeStepSize), dtNext);
 
         if (dtNext < simulator().maxTimeStepSize()
             && simulator().maxTimeStepSize() < dtNext*2)
@@ -756,8 +949,13 @@ public:
     template <class Restarter>
     void serialize(Restarter& res)
     {
-        if (enableVtkOutput_())
+        if (defaultVtkWriter_)
             defaultVtkWriter_->serialize(res);
+        if (appendedRawVtkWriter_)
+            appendedRawVtkWriter_->serialize(res);
+        if (timeSeriesWriter_)
+            timeSeriesWriter_->serialize(res);
+        model().outputSelection().serialize(res);
     }
 
     /*!
@@ -773,8 +971,13 @@ public:
     template <class Restarter>
     void deserialize(Restarter& res)
     {
-        if (enableVtkOutput_())
+        if (defaultVtkWriter_)
             defaultVtkWriter_->deserialize(res);
+        if (appendedRawVtkWriter_)
+            appendedRawVtkWriter_->deserialize(res);
+        if (timeSeriesWriter_)
+            timeSeriesWriter_->deserialize(res);
+        model().outputSelection().deserialize(res);
     }
 
     /*!
@@ -795,10 +998,21 @@ public:
         // calculate the time _after_ the time was updated
         Scalar t = simulator().time() + simulator().timeStepSize();
 
-        defaultVtkWriter_->beginWrite(t);
+        model().outputSelection().beginOutputStep();
+
+        BaseOutputWriter& vtkWriter = vtkWriter_();
+        vtkWriter.beginWrite(t);
         model().prepareOutputFields();
-        model().appendOutputFields(*defaultVtkWriter_);
-        defaultVtkWriter_->endWrite();
+        model().appendOutputFields(vtkWriter);
+        vtkWriter.endWrite();
+
+        // the output fields have already been prepared for the VTK writer, so they only
+        // need to be attached to the time series writer
+        if (timeSeriesWriter_) {
+            timeSeriesWriter_->beginWrite(t);
+            model().appendOutputFields(*timeSeriesWriter_);
+            timeSeriesWriter_->endWrite();
+        }
 
     }
 
@@ -809,13 +1023,36 @@ public:
     VtkMultiWriter& defaultVtkWriter() const
     { return defaultVtkWriter_; }
 
+    /*!
+     * \brief Returns the strategy which determines the size of the next time step.
+     */
+    const FvBaseTimeStepControl<TypeTag>& timeStepControl() const
+    { return *timeStepControl_; }
+
 protected:
     Scalar nextTimeStepSize_;
+    unsigned numTimeStepCuts_;
 
 private:
     bool enableVtkOutput_() const
     { return EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput); }
 
+    unsigned vtkOutputBufferDepth_() const
+    { return EWOMS_GET_PARAM(TypeTag, unsigned, VtkOutputBufferDepth); }
+
+    size_t vtkOutputBufferMemoryLimit_() const
+    {
+        Scalar limitMiB = EWOMS_GET_PARAM(TypeTag, Scalar, VtkOutputBufferMemoryLimit);
+        return static_cast<size_t>(std::max<Scalar>(0.0, limitMiB)*1024*1024);
+    }
+
+    BaseOutputWriter& vtkWriter_()
+    {
+        if (appendedRawVtkWriter_)
+            return *appendedRawVtkWriter_;
+        return *defaultVtkWriter_;
+    }
+
     //! Returns the implementation of the problem (i.e. static polymorphism)
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
@@ -834,6 +1071,10 @@ private:
     // Attributes required for the actual simulation
     Simulator& simulator_;
     mutable VtkMultiWriter *defaultVtkWriter_;
+    VtkAppendedRawWriter *appendedRawVtkWriter_;
+    TimeSeriesWriter *timeSeriesWriter_;
+
+    std::unique_ptr<FvBaseTimeStepControl<TypeTag> > timeStepControl_;
 };
 
 } // namespace Ewoms
@@ -168,6 +168,19 @@ NEW_PROP_TAG(ThreadsPerProcess);
 //! discretizations do not need this.)
 NEW_PROP_TAG(UseLinearizationLock);
 
+//! Measure the time and the number of inner iterations needed to linearize each element
+NEW_PROP_TAG(EnableLinearizationCostMap);
+
+//! Print the throughput and the cache efficiency of each linearization
+NEW_PROP_TAG(EnableLinearizationStatistics);
+
+//! Only relinearize the elements whose degrees of freedom changed significantly
+NEW_PROP_TAG(EnableIncrementalLinearization);
+
+//! The accumulated relative change of a degree of freedom above which the elements
+//! which contain it are relinearized
+NEW_PROP_TAG(IncrementalLinearizationTolerance);
+
 // high-level simulation control
 
 //! Manages the simulation time
@@ -186,6 +199,22 @@ NEW_PROP_TAG(EnableGridAdaptation);
  */
 NEW_PROP_TAG(OutputDir);
 
+/*!
+ * \brief Statements which select the output fields, the region of interest and the
+ *        output intervals of the fields.
+ *
+ * See Ewoms::OutputSelection for the syntax. Statements are separated by semicolons.
+ */
+NEW_PROP_TAG(OutputSelection);
+
+/*!
+ * \brief The name of a file which contains statements for the output selection.
+ *
+ * If both, this file and the OutputSelection property are specified, the statements
+ * of both are combined.
+ */
+NEW_PROP_TAG(OutputSelectionFile);
+
 /*!
  * \brief Global switch to enable or disable the writing of VTK output files
  *
@@ -205,6 +234,25 @@ NEW_PROP_TAG(EnableVtkOutput);
  */
 NEW_PROP_TAG(EnableAsyncVtkOutput);
 
+/*!
+ * \brief The maximum number of time steps for which the VTK output data may be kept in
+ *        memory at the same time.
+ *
+ * If this is larger than one, the fields of a time step can be extracted while the
+ * data of the previous ones is still written. This has only an effect if the output is
+ * written asynchronously.
+ */
+NEW_PROP_TAG(VtkOutputBufferDepth);
+
+/*!
+ * \brief The maximum memory [MiB] which may be occupied by the VTK output data which
+ *        waits to be written.
+ *
+ * If this limit would be exceeded, the simulation waits until all pending output has
+ * been written.
+ */
+NEW_PROP_TAG(VtkOutputBufferMemoryLimit);
+
 /*!
  * \brief Specify the format the VTK output is written to disk
  *
@@ -216,6 +264,43 @@ NEW_PROP_TAG(EnableAsyncVtkOutput);
  */
 NEW_PROP_TAG(VtkOutputFormat);
 
+/*!
+ * \brief Write the VTK output using Ewoms::VtkAppendedRawWriter instead of Dune's VTK
+ *        writer.
+ *
+ * This writer stores all data in a single section of appended raw binary data and
+ * thus ignores the VtkOutputFormat property.
+ */
+NEW_PROP_TAG(EnableVtkAppendedRawOutput);
+
+/*!
+ * \brief The zlib compression level of the data arrays written by the appended raw
+ *        VTK writer.
+ *
+ * 0 means that the data is not compressed, 1 to 9 correspond to the compression levels
+ * of zlib.
+ */
+NEW_PROP_TAG(VtkCompressionLevel);
+
+//! The number of threads used to compress the data arrays of the VTK output
+NEW_PROP_TAG(VtkCompressionThreads);
+
+/*!
+ * \brief Additionally write all output fields to a columnar time series file.
+ *
+ * The file contains the fields of all time steps and can be read efficiently using
+ * Ewoms::TimeSeriesReader or the tsdump utility. Since the output fields are provided
+ * by the VTK output modules, this requires the VTK output to be enabled.
+ */
+NEW_PROP_TAG(EnableTimeSeriesOutput);
+
+/*!
+ * \brief The name of the file to which the timing receipt is written as JSON.
+ *
+ * If this is empty, the receipt is only printed in human-readable form.
+ */
+NEW_PROP_TAG(TimingReceiptFile);
+
 //! Specify whether the some degrees of fredom can be constraint
 NEW_PROP_TAG(EnableConstraints);
 
@@ -246,6 +331,35 @@ NEW_PROP_TAG(MaxTimeStepDivisions);
  */
 NEW_PROP_TAG(ContinueOnConvergenceError);
 
+/*!
+ * \brief The strategy which determines the size of the next time step.
+ *
+ * Possible values are 'iterationcount', 'pid' and 'solutionchange', cf.
+ * Ewoms::FvBaseTimeStepControl.
+ */
+NEW_PROP_TAG(TimeStepControl);
+
+/*!
+ * \brief The factor by which the time step size is multiplied if the Newton method did
+ *        not converge.
+ */
+NEW_PROP_TAG(TimeStepCutFactor);
+
+/*!
+ * \brief The weighted relative change of the solution per time step which is aimed at
+ *        by the time step controls that consider the change of the solution.
+ */
+NEW_PROP_TAG(TimeStepControlTargetChange);
+
+/*!
+ * \brief The maximum factor by which the time step size may grow from one time step to
+ *        the next.
+ *
+ * This only applies to the time step controls which limit the time step size, i.e.,
+ * not to 'iterationcount'.
+ */
+NEW_PROP_TAG(TimeStepControlMaxGrowth);
+
 /*!
  * \brief Specify whether all intensive quantities for the grid should be
  *        cached in the discretization.
@@ -275,6 +389,15 @@ NEW_PROP_TAG(EnableStorageCache);
  */
 NEW_PROP_TAG(EnableThermodynamicHints);
 
+/*!
+ * \brief The order of the polynomial which is used to extrapolate the initial guess of
+ *        the Newton method from the solutions of the previous time steps.
+ *
+ * 0 means that the solution of the last time step is used, 1 selects linear and 2
+ * quadratic extrapolation.
+ */
+NEW_PROP_TAG(SolutionPredictorOrder);
+
 // mappers from local to global DOF indices
 
 /*!
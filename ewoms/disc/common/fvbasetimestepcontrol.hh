@@ -0,0 +1,443 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::FvBaseTimeStepControl
+ */
+#ifndef EWOMS_FV_BASE_TIME_STEP_CONTROL_HH
+#define EWOMS_FV_BASE_TIME_STEP_CONTROL_HH
+
+#include "fvbaseproperties.hh"
+
+#include <opm/material/common/Unused.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace Ewoms {
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief Base class for the strategies which determine the size of the next time step.
+ *
+ * The time step control is notified about each attempt of a time integration. If an
+ * attempt fails, the time step size is reduced by the TimeStepCutFactor parameter.
+ * Otherwise, the size of the next time step is suggested by the concrete strategy.
+ *
+ * Strategies which limit the time step size (cf. limitsTimeStepSize()) do not allow the
+ * time step which follows a successful attempt with a reduced step size to grow. This
+ * avoids oscillations between cutting the time step size and growing it again. Their
+ * time step size also grows at most by the TimeStepControlMaxGrowth parameter and is
+ * not smaller than the minimum time step size of the problem.
+ *
+ * Besides this, the time step control counts the accepted time steps, the cuts and
+ * the Newton iterations spent on successful and failed attempts.
+ */
+template <class TypeTag>
+class FvBaseTimeStepControl
+{
+protected:
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+
+public:
+    FvBaseTimeStepControl(Simulator& simulator)
+        : simulator_(simulator)
+    {
+        cutFactor_ = EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepCutFactor);
+        if (!(0.0 < cutFactor_ && cutFactor_ < 1.0))
+            throw std::invalid_argument("The factor by which the time step size is cut must be "
+                                        "between 0 and 1 (is: "+std::to_string(double(cutFactor_))+")");
+
+        maxGrowth_ = EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepControlMaxGrowth);
+        wasCut_ = false;
+
+        numTimeSteps_ = 0;
+        numTimeStepCuts_ = 0;
+        numNewtonIterations_ = 0;
+        numFailedNewtonIterations_ = 0;
+        simulatedTime_ = 0.0;
+    }
+
+    virtual ~FvBaseTimeStepControl()
+    {}
+
+    /*!
+     * \brief Register all run-time parameters of the time step controls.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, TimeStepControl,
+                             "The strategy which determines the size of the next time step "
+                             "('iterationcount', 'pid' or 'solutionchange')");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepCutFactor,
+                             "The factor by which the time step size is multiplied if the "
+                             "Newton method did not converge");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepControlTargetChange,
+                             "The weighted relative change of the solution per time step which "
+                             "is aimed at by the 'pid' and 'solutionchange' time step controls");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepControlMaxGrowth,
+                             "The maximum factor by which the time step size may grow from one "
+                             "time step to the next for the 'pid' and 'solutionchange' time "
+                             "step controls");
+    }
+
+    /*!
+     * \brief Create the time step control selected by the TimeStepControl parameter.
+     */
+    static std::unique_ptr<FvBaseTimeStepControl> create(Simulator& simulator);
+
+    /*!
+     * \brief Returns the name of the strategy.
+     */
+    virtual std::string name() const = 0;
+
+    /*!
+     * \brief Returns true if the suggested time step sizes are limited after cuts, by
+     *        the maximum growth and by the minimum time step size.
+     */
+    virtual bool limitsTimeStepSize() const
+    { return true; }
+
+    /*!
+     * \brief Called after a time integration has been successful.
+     *
+     * At this point, solution(0) is the solution at the end of the time step and
+     * solution(1) is the one at its beginning.
+     *
+     * \param dt The size of the successful time step
+     */
+    void timeStepSucceeded(Scalar dt)
+    {
+        ++ numTimeSteps_;
+        numNewtonIterations_ += newtonIterationsOfAttempt_();
+        simulatedTime_ += dt;
+
+        succeeded_(dt);
+    }
+
+    /*!
+     * \brief Called after a time integration has failed.
+     *
+     * Returns the size of the time step for the next attempt.
+     *
+     * \param dt The size of the failed time step
+     */
+    Scalar timeStepFailed(Scalar dt)
+    {
+        ++ numTimeStepCuts_;
+        numFailedNewtonIterations_ += newtonIterationsOfAttempt_();
+        wasCut_ = true;
+
+        return dt*cutFactor_;
+    }
+
+    /*!
+     * \brief Returns the size of the next time step after a successful one.
+     *
+     * \param dt The size of the time step which has just been completed
+     */
+    Scalar suggestTimeStepSize(Scalar dt)
+    {
+        if (!limitsTimeStepSize()) {
+            wasCut_ = false;
+            return suggest_(dt);
+        }
+
+        Scalar nextDt = std::min(suggest_(dt), dt*maxGrowth_);
+
+        // the last time step needed to be cut, so we do not grow the step size again
+        // immediately
+        if (wasCut_)
+            nextDt = std::min(nextDt, dt);
+        wasCut_ = false;
+
+        return nextDt;
+    }
+
+    /*!
+     * \brief Returns the number of accepted time steps.
+     */
+    unsigned long numTimeSteps() const
+    { return numTimeSteps_; }
+
+    /*!
+     * \brief Returns the number of times the time step size was cut.
+     */
+    unsigned long numTimeStepCuts() const
+    { return numTimeStepCuts_; }
+
+    /*!
+     * \brief Returns the number of Newton iterations of the accepted time steps.
+     */
+    unsigned long numNewtonIterations() const
+    { return numNewtonIterations_; }
+
+    /*!
+     * \brief Returns the number of Newton iterations which were wasted on failed
+     *        attempts of time integrations.
+     */
+    unsigned long numFailedNewtonIterations() const
+    { return numFailedNewtonIterations_; }
+
+    /*!
+     * \brief Print the statistics of the time step control.
+     */
+    void printStatistics(std::ostream& os) const
+    {
+        const Scalar secondsPerDay = 24*60*60;
+        unsigned long numTotalIterations = numNewtonIterations_ + numFailedNewtonIterations_;
+        Scalar days = simulatedTime_/secondsPerDay;
+
+        std::ostringstream oss;
+        oss << std::setprecision(3)
+            << "Time step control '" << name() << "': "
+            << numTimeSteps_ << " time steps, "
+            << numTimeStepCuts_ << " cuts, "
+            << numTotalIterations << " Newton iterations ("
+            << numFailedNewtonIterations_ << " in failed attempts)";
+        if (days > 0)
+            oss << ", " << numTotalIterations/days << " Newton iterations per simulated day";
+        oss << "\n";
+        os << oss.str();
+    }
+
+protected:
+    // called after a successful time step
+    virtual void succeeded_(Scalar dt OPM_UNUSED)
+    {}
+
+    // returns the size of the next time step
+    virtual Scalar suggest_(Scalar dt) = 0;
+
+    // returns the maximum weighted relative change of the primary variables between the
+    // beginning and the end of the time step over all processes
+    Scalar relativeSolutionChange_() const
+    {
+        const auto& model = simulator_.model();
+        const auto& oldSol = model.solution(/*timeIdx=*/1);
+        const auto& newSol = model.solution(/*timeIdx=*/0);
+
+        Scalar result = 0.0;
+        for (unsigned dofIdx = 0; dofIdx < model.numGridDof(); ++dofIdx)
+            result = std::max(result, model.relativeDofError(dofIdx, oldSol[dofIdx], newSol[dofIdx]));
+
+        return simulator_.gridView().comm().max(result);
+    }
+
+    Simulator& simulator_;
+
+private:
+    // unlike NewtonMethod::numIterations(), this is not overwritten if the Newton
+    // method fails, so it also counts the iterations of a failed attempt
+    unsigned long newtonIterationsOfAttempt_() const
+    { return simulator_.model().newtonMethod().numAttemptedIterations(); }
+
+    Scalar cutFactor_;
+    Scalar maxGrowth_;
+    bool wasCut_;
+
+    unsigned long numTimeSteps_;
+    unsigned long numTimeStepCuts_;
+    unsigned long numNewtonIterations_;
+    unsigned long numFailedNewtonIterations_;
+    Scalar simulatedTime_;
+};
+
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief Adapts the time step size to the number of Newton iterations.
+ *
+ * This uses NewtonMethod::suggestTimeStepSize(), i.e., the time step size is scaled by
+ * the ratio between the NewtonTargetIterations parameter and the number of iterations
+ * the last time step required. The suggested time step sizes are not limited any
+ * further, i.e., this is the time stepping of previous versions.
+ */
+template <class TypeTag>
+class IterationCountTimeStepControl : public FvBaseTimeStepControl<TypeTag>
+{
+    typedef FvBaseTimeStepControl<TypeTag> ParentType;
+    typedef typename ParentType::Scalar Scalar;
+    typedef typename ParentType::Simulator Simulator;
+
+public:
+    IterationCountTimeStepControl(Simulator& simulator)
+        : ParentType(simulator)
+    {}
+
+    std::string name() const
+    { return "iterationcount"; }
+
+    bool limitsTimeStepSize() const
+    { return false; }
+
+protected:
+    Scalar suggest_(Scalar dt)
+    { return this->simulator_.model().newtonMethod().suggestTimeStepSize(dt); }
+};
+
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief A PID controller which keeps the relative change of the solution per time step
+ *        close to the TimeStepControlTargetChange parameter.
+ *
+ * The change of the solution is the maximum of the weighted relative changes of the
+ * primary variables, cf. FvBaseDiscretization::relativeDofError(), i.e., the pressures
+ * are considered relative to their values while saturations and mole fractions are
+ * considered in absolute terms. The controller follows
+ *
+ * G. Soederlind: "Digital filters in adaptive time-stepping", ACM Transactions on
+ * Mathematical Software, 29 (2003), pp 1-26.
+ *
+ * If the change exceeds the target, the time step size is reduced proportionally.
+ */
+template <class TypeTag>
+class PidTimeStepControl : public FvBaseTimeStepControl<TypeTag>
+{
+    typedef FvBaseTimeStepControl<TypeTag> ParentType;
+    typedef typename ParentType::Scalar Scalar;
+    typedef typename ParentType::Simulator Simulator;
+
+public:
+    PidTimeStepControl(Simulator& simulator)
+        : ParentType(simulator)
+    {
+        targetChange_ = EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepControlTargetChange);
+        for (unsigned i = 0; i < 3; ++i)
+            errors_[i] = targetChange_;
+    }
+
+    std::string name() const
+    { return "pid"; }
+
+protected:
+    void succeeded_(Scalar dt OPM_UNUSED)
+    {
+        errors_[0] = errors_[1];
+        errors_[1] = errors_[2];
+        errors_[2] = std::max(this->relativeSolutionChange_(), tiny_());
+    }
+
+    Scalar suggest_(Scalar dt)
+    {
+        if (errors_[2] > targetChange_)
+            return dt*targetChange_/errors_[2];
+
+        // the proportional, integral and derivative gains
+        const Scalar kP = 0.075;
+        const Scalar kI = 0.175;
+        const Scalar kD = 0.01;
+        return
+            dt
+            * std::pow(errors_[1]/errors_[2], kP)
+            * std::pow(targetChange_/errors_[2], kI)
+            * std::pow(errors_[0]*errors_[0]/(errors_[1]*errors_[2]), kD);
+    }
+
+private:
+    static Scalar tiny_()
+    { return 1e-10; }
+
+    Scalar targetChange_;
+
+    // the relative changes of the last three time steps, oldest first
+    Scalar errors_[3];
+};
+
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief Scales the time step size such that the relative change of the solution of
+ *        the last time step extrapolates to the TimeStepControlTargetChange parameter.
+ *
+ * The change of the solution is measured like for the PidTimeStepControl, but only the
+ * change of the last time step is considered.
+ */
+template <class TypeTag>
+class SolutionChangeTimeStepControl : public FvBaseTimeStepControl<TypeTag>
+{
+    typedef FvBaseTimeStepControl<TypeTag> ParentType;
+    typedef typename ParentType::Scalar Scalar;
+    typedef typename ParentType::Simulator Simulator;
+
+public:
+    SolutionChangeTimeStepControl(Simulator& simulator)
+        : ParentType(simulator)
+    {
+        targetChange_ = EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepControlTargetChange);
+        lastChange_ = targetChange_;
+    }
+
+    std::string name() const
+    { return "solutionchange"; }
+
+protected:
+    void succeeded_(Scalar dt OPM_UNUSED)
+    { lastChange_ = this->relativeSolutionChange_(); }
+
+    Scalar suggest_(Scalar dt)
+    {
+        // aim slightly below the target to make it less likely that the next time step
+        // overshoots it
+        const Scalar safetyFactor = 0.9;
+        if (lastChange_ <= 0.0)
+            return std::numeric_limits<Scalar>::infinity();
+        return dt*safetyFactor*targetChange_/lastChange_;
+    }
+
+private:
+    Scalar targetChange_;
+    Scalar lastChange_;
+};
+
+template <class TypeTag>
+std::unique_ptr<FvBaseTimeStepControl<TypeTag> >
+FvBaseTimeStepControl<TypeTag>::create(Simulator& simulator)
+{
+    const std::string& name = EWOMS_GET_PARAM(TypeTag, std::string, TimeStepControl);
+
+    std::unique_ptr<FvBaseTimeStepControl> result;
+    if (name == "iterationcount")
+        result.reset(new IterationCountTimeStepControl<TypeTag>(simulator));
+    else if (name == "pid")
+        result.reset(new PidTimeStepControl<TypeTag>(simulator));
+    else if (name == "solutionchange")
+        result.reset(new SolutionChangeTimeStepControl<TypeTag>(simulator));
+    else
+        throw std::invalid_argument("Unknown time step control '"+name+"'. Use one of "
+                                    "'iterationcount', 'pid' or 'solutionchange'");
+    return result;
+}
+} // namespace Ewoms
+
+#endif
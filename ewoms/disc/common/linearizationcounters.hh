@@ -0,0 +1,150 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::LinearizationCounters
+ */
+#ifndef EWOMS_LINEARIZATION_COUNTERS_HH
+#define EWOMS_LINEARIZATION_COUNTERS_HH
+
+namespace Ewoms {
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief Counts the work done and the cache efficiency while linearizing the spatial
+ *        domain.
+ *
+ * The counters are thread-local: each thread which linearizes elements only
+ * increments its own counters, so no atomic operations are required in the hot
+ * path. The linearizer collects the counters of all threads at the end of its
+ * parallel region.
+ */
+class LinearizationCounters
+{
+public:
+    /*!
+     * \brief The counter values of a single thread.
+     */
+    struct Counts
+    {
+        Counts()
+        { clear(); }
+
+        void clear()
+        {
+            numElements = 0;
+            numReusedElements = 0;
+            numDof = 0;
+            numFaces = 0;
+            intensiveQuantityCacheHits = 0;
+            intensiveQuantityCacheMisses = 0;
+            thermodynamicHints = 0;
+            storageCacheHits = 0;
+            storageCacheMisses = 0;
+            busyTime = 0.0;
+        }
+
+        Counts& operator+=(const Counts& other)
+        {
+            numElements += other.numElements;
+            numReusedElements += other.numReusedElements;
+            numDof += other.numDof;
+            numFaces += other.numFaces;
+            intensiveQuantityCacheHits += other.intensiveQuantityCacheHits;
+            intensiveQuantityCacheMisses += other.intensiveQuantityCacheMisses;
+            thermodynamicHints += other.thermodynamicHints;
+            storageCacheHits += other.storageCacheHits;
+            storageCacheMisses += other.storageCacheMisses;
+            busyTime += other.busyTime;
+            return *this;
+        }
+
+        /*!
+         * \brief Returns the fraction of intensive quantity updates which were served
+         *        by the cache.
+         */
+        double intensiveQuantityCacheHitRate() const
+        { return hitRate_(intensiveQuantityCacheHits, intensiveQuantityCacheMisses); }
+
+        /*!
+         * \brief Returns the fraction of storage terms of the previous time step which
+         *        were served by the cache.
+         */
+        double storageCacheHitRate() const
+        { return hitRate_(storageCacheHits, storageCacheMisses); }
+
+        //! The number of linearized elements
+        unsigned long numElements;
+        //! The number of elements for which a cached local linearization was used
+        unsigned long numReusedElements;
+        //! The number of primary degrees of freedom of the linearized elements
+        unsigned long numDof;
+        //! The number of interior faces of the linearized elements
+        unsigned long numFaces;
+        //! The number of intensive quantities copied from the cache
+        unsigned long intensiveQuantityCacheHits;
+        //! The number of intensive quantities which needed to be computed
+        unsigned long intensiveQuantityCacheMisses;
+        //! The number of intensive quantity updates which had a thermodynamic hint
+        unsigned long thermodynamicHints;
+        //! The number of storage terms of the previous time step taken from the cache
+        unsigned long storageCacheHits;
+        //! The number of storage terms of the previous time step which were computed
+        unsigned long storageCacheMisses;
+        //! The wall clock time in seconds the thread spent linearizing elements
+        double busyTime;
+
+    private:
+        static double hitRate_(unsigned long hits, unsigned long misses)
+        {
+            unsigned long total = hits + misses;
+            return total > 0 ? static_cast<double>(hits)/total : 0.0;
+        }
+    };
+
+    /*!
+     * \brief Returns the counters of the current thread.
+     */
+    static Counts& local()
+    {
+        static thread_local Counts counts;
+        return counts;
+    }
+
+    /*!
+     * \brief Reset the counters of the current thread.
+     *
+     * The values of the counters before the reset are returned.
+     */
+    static Counts reset()
+    {
+        Counts& counts = local();
+        Counts result = counts;
+        counts.clear();
+        return result;
+    }
+};
+} // namespace Ewoms
+
+#endif
@@ -41,6 +41,7 @@
 #include <sstream>
 #include <string>
 #include <array>
+#include <utility>
 
 #include <cstdio>
 
@@ -110,6 +111,7 @@ public:
 
     BaseOutputModule(const Simulator& simulator)
         : simulator_(simulator)
+        , selectionCacheFrozen_(true)
     {}
 
     virtual ~BaseOutputModule()
@@ -140,6 +142,26 @@ public:
      */
     virtual void commitBuffers(BaseOutputWriter& writer) = 0;
 
+    /*!
+     * \brief Start a new output step.
+     *
+     * This is called before allocBuffers(). The fields which are selected for the
+     * current output step are cached while the buffers get allocated, so checking
+     * them in processElement() is cheap and thread-safe.
+     */
+    void beginOutputStep()
+    {
+        selectionCache_.clear();
+        selectionCacheFrozen_ = false;
+    }
+
+    /*!
+     * \brief Called after the buffers of the current output step have been
+     *        allocated.
+     */
+    void endBufferAllocation()
+    { selectionCacheFrozen_ = true; }
+
     /*!
      * \brief Returns true iff the module needs to access the extensive quantities of a
      * context to do its job.
@@ -154,6 +176,29 @@ public:
     { return false; }
 
 protected:
+    /*!
+     * \brief Returns true if a field is part of the output selection for the current
+     *        output step.
+     *
+     * \param name The name of the field as passed to the output writer. This must be
+     *             a string literal because the result is cached based on its address.
+     */
+    bool fieldSelected_(const char *name) const
+    {
+        const auto& selection = simulator_.model().outputSelection();
+        if (selection.selectsAllFields())
+            return true;
+
+        for (const auto& entry : selectionCache_)
+            if (entry.first == name)
+                return entry.second;
+
+        bool selected = selection.fieldSelected(name);
+        if (!selectionCacheFrozen_)
+            selectionCache_.push_back(std::make_pair(name, selected));
+        return selected;
+    }
+
     enum BufferType {
         //! Buffer contains data associated with the degrees of freedom
         DofBuffer,
@@ -507,6 +552,9 @@ protected:
     { baseWriter.attachTensorVertexData(buffer, name); }
 
     const Simulator& simulator_;
+
+    mutable std::vector<std::pair<const char *, bool> > selectionCache_;
+    bool selectionCacheFrozen_;
 };
 
 #if __GNUC__ || __clang__
@@ -31,14 +31,15 @@
 #include <dune/common/dynvector.hh>
 #include <dune/common/dynmatrix.hh>
 
+#include <string>
 #include <vector>
 
 namespace Ewoms {
 /*!
  * \brief The base class for all output writers.
  *
- * The sole purpose of this class is to enable RTTI
- * (i.e. dynamic_cast) on writer objects.
+ * Besides defining the interface for attaching data, the purpose of this class is
+ * to enable RTTI (i.e. dynamic_cast) on writer objects.
  */
 class BaseOutputWriter
 {
@@ -56,6 +57,16 @@ public:
     virtual ~BaseOutputWriter()
     {}
 
+    /*!
+     * \brief Returns true if the writer can deal with the grid based fields which are
+     *        produced by the Vtk*Module output modules.
+     *
+     * These fields are vertex or element centered buffers of the size of the grid
+     * view's vertex or element mapper.
+     */
+    virtual bool acceptsGridFields() const
+    { return false; }
+
     /*!
      * \brief Called when ever a new time step or a new grid
      *        must be written.
@@ -32,12 +32,21 @@
 #include <ewoms/models/discretefracture/fracturemapper.hh>
 
 #include <ewoms/io/basevanguard.hh>
+#include <ewoms/io/gridcache.hh>
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
 
 
+#include <dune/common/parallel/mpihelper.hh>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
 #include <type_traits>
 #include <string>
+#include <utility>
+#include <vector>
 
 BEGIN_PROPERTIES
 
@@ -45,6 +54,7 @@ NEW_PROP_TAG(Grid);
 NEW_PROP_TAG(GridFile);
 NEW_PROP_TAG(Vanguard);
 NEW_PROP_TAG(GridGlobalRefinements);
+NEW_PROP_TAG(GridCacheDirectory);
 NEW_PROP_TAG(Scalar);
 NEW_PROP_TAG(Simulator);
 
@@ -66,6 +76,7 @@ class DgfVanguard : public BaseVanguard<TypeTag>
     typedef Ewoms::FractureMapper<TypeTag> FractureMapper;
 
     typedef std::unique_ptr< Grid > GridPointer;
+    typedef std::vector<std::pair<unsigned, unsigned> > FractureEdgeList;
 
 public:
     /*!
@@ -78,6 +89,9 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, unsigned, GridGlobalRefinements,
                              "The number of global refinements of the grid "
                              "executed after it was loaded");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, GridCacheDirectory,
+                             "The directory in which the refined grid is cached in a binary "
+                             "format for subsequent runs. If empty, no cache is used");
     }
 
     /*!
@@ -88,13 +102,38 @@ public:
     {
         const std::string dgfFileName = EWOMS_GET_PARAM(TypeTag, std::string, GridFile);
         unsigned numRefinments = EWOMS_GET_PARAM(TypeTag, unsigned, GridGlobalRefinements);
+        const std::string cacheDir = EWOMS_GET_PARAM(TypeTag, std::string, GridCacheDirectory);
+
+        GridCache<Grid> gridCache;
+        bool useCache = !cacheDir.empty() && GridCacheSupported<Grid>::value;
+
+        // the grid cache does not store boundary ids, so grids which assign them to
+        // parts of the boundary must always be read from the DGF file
+        if (useCache && definesBoundaryIds_(dgfFileName)) {
+            if (Dune::MPIHelper::getCollectiveCommunication().rank() == 0)
+                std::cout << "The DGF file '" << dgfFileName << "' defines boundary ids "
+                          << "which cannot be cached. Not using the grid cache.\n"
+                          << std::flush;
+            useCache = false;
+        }
+
+        if (useCache) {
+            gridCache.addFileToKey(dgfFileName);
+            gridCache.addToKey("refinements="+std::to_string(numRefinments));
+
+            if (loadFromCache_(gridCache, gridCache.fileName(cacheDir))) {
+                this->finalizeInit_();
+                return;
+            }
+        }
 
+        FractureEdgeList fractureEdges;
         {
             // create DGF GridPtr from a dgf file
             Dune::GridPtr< Grid > dgfPointer( dgfFileName );
 
             // this is only implemented for 2d currently
-            addFractures_( dgfPointer );
+            addFractures_( dgfPointer, fractureEdges );
 
             // store pointer to dune grid
             gridPtr_.reset( dgfPointer.release() );
@@ -103,6 +142,11 @@ public:
         if (numRefinments > 0)
             gridPtr_->globalRefine(static_cast<int>(numRefinments));
 
+        // the cache can only be written if the whole grid is available on a single
+        // process
+        if (useCache && Dune::MPIHelper::getCollectiveCommunication().size() == 1)
+            gridCache.store(gridCache.fileName(cacheDir), *gridPtr_, fractureEdges);
+
         this->finalizeInit_();
     }
 
@@ -145,7 +189,55 @@ public:
     { return fractureMapper_; }
 
 protected:
-    void addFractures_(Dune::GridPtr<Grid>& dgfPointer)
+    bool loadFromCache_(GridCache<Grid>& gridCache, const std::string& cacheFileName)
+    {
+        // only the first process reads the cache file and creates the whole grid. it
+        // gets distributed by loadBalance() afterwards.
+        const auto& comm = Dune::MPIHelper::getCollectiveCommunication();
+        int cacheValid = 0;
+        if (comm.rank() == 0)
+            cacheValid = gridCache.load(cacheFileName) ? 1 : 0;
+        comm.broadcast(&cacheValid, /*count=*/1, /*root=*/0);
+        if (!cacheValid)
+            return false;
+
+        gridPtr_ = gridCache.createGrid(/*insertEntities=*/comm.rank() == 0);
+        for (const auto& edge : gridCache.fractureEdges())
+            fractureMapper_.addFractureEdge(edge.first, edge.second);
+
+        return true;
+    }
+
+    // returns true if a DGF file assigns boundary ids to individual parts of the
+    // boundary. blocks which only specify a default id for the whole boundary are fine
+    // because all boundary segments are equivalent for them.
+    static bool definesBoundaryIds_(const std::string& dgfFileName)
+    {
+        std::ifstream is(dgfFileName);
+        std::string line;
+        bool inBoundaryBlock = false;
+        while (std::getline(is, line)) {
+            line = line.substr(0, line.find('%'));
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos)
+                continue;
+
+            std::string statement = line.substr(first);
+            std::transform(statement.begin(), statement.end(), statement.begin(),
+                           [](char c) { return static_cast<char>(std::toupper(c)); });
+            if (statement.compare(0, 14, "BOUNDARYDOMAIN") == 0
+                || statement.compare(0, 16, "BOUNDARYSEGMENTS") == 0)
+                inBoundaryBlock = true;
+            else if (statement[0] == '#')
+                inBoundaryBlock = false;
+            else if (inBoundaryBlock && statement.compare(0, 7, "DEFAULT") != 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    void addFractures_(Dune::GridPtr<Grid>& dgfPointer, FractureEdgeList& fractureEdges)
     {
         typedef typename Grid::LevelGridView LevelGridView;
 
@@ -192,8 +284,10 @@ protected:
                                                                         Grid::dimension)));
                 }
                 // if 2 vertices have been found with flag 1 insert a fracture edge
-                if (static_cast<int>(vertexIndices.size()) == Grid::dimension)
+                if (static_cast<int>(vertexIndices.size()) == Grid::dimension) {
                     fractureMapper_.addFractureEdge(vertexIndices[0], vertexIndices[1]);
+                    fractureEdges.push_back(std::make_pair(vertexIndices[0], vertexIndices[1]));
+                }
             }
         }
     }
@@ -0,0 +1,437 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::GridCache
+ */
+#ifndef EWOMS_GRID_CACHE_HH
+#define EWOMS_GRID_CACHE_HH
+
+#include <dune/grid/common/gridfactory.hh>
+#include <dune/grid/common/mcmgmapper.hh>
+#include <dune/grid/yaspgrid.hh>
+#include <dune/geometry/referenceelements.hh>
+#include <dune/geometry/type.hh>
+#include <dune/common/classname.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/version.hh>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Ewoms {
+
+/*!
+ * \brief Specifies whether a grid can be restored from the grid cache.
+ *
+ * This requires that the grid can be created using Dune::GridFactory.
+ */
+template <class Grid>
+struct GridCacheSupported
+{ static const bool value = true; };
+
+template <int dim, class Coordinates>
+struct GridCacheSupported<Dune::YaspGrid<dim, Coordinates> >
+{ static const bool value = false; };
+
+/*!
+ * \brief Stores the leaf level of an unstructured grid in a binary file so that it does
+ *        not need to be parsed and refined again by subsequent simulation runs.
+ *
+ * The file contains the vertex coordinates, the element connectivity, the boundary
+ * segments and the edges of fractures. The grid is restored using Dune::GridFactory,
+ * i.e., the leaf level of the cached grid becomes the macro level of the restored one.
+ * Boundary ids (e.g., those of the BoundaryDomain and BoundarySegments blocks of DGF
+ * files) are not stored, so grids which assign them to parts of the boundary must not
+ * be cached.
+ *
+ * A cache file is identified by a key which is a hash of everything which determines
+ * the grid, i.e., usually the contents of the grid file, the number of refinements and
+ * the type of the grid. If the input changes, the key changes as well and the grid is
+ * created from scratch.
+ */
+template <class Grid>
+class GridCache
+{
+    enum { dim = Grid::dimension };
+    enum { dimWorld = Grid::dimensionworld };
+
+    typedef typename Grid::ctype CoordScalar;
+    typedef Dune::FieldVector<CoordScalar, dimWorld> GlobalPosition;
+    typedef std::pair<unsigned, unsigned> Edge;
+
+    static const char* magic_()
+    { return "EWOMSGC1"; }
+
+public:
+    /*!
+     * \brief Start computing a cache key.
+     *
+     * The key depends on the type of the grid. Further data is added by calling
+     * addToKey().
+     */
+    GridCache()
+        : key_(14695981039346656037ULL)
+    {
+        addToKey(Dune::className<Grid>());
+    }
+
+    /*!
+     * \brief Add a string to the data which determines the cache key.
+     */
+    void addToKey(const std::string& data)
+    {
+        // 64 bit FNV-1a
+        for (size_t i = 0; i < data.size(); ++i) {
+            key_ ^= static_cast<unsigned char>(data[i]);
+            key_ *= 1099511628211ULL;
+        }
+    }
+
+    /*!
+     * \brief Add the contents of a file to the data which determines the cache key.
+     */
+    void addFileToKey(const std::string& fileName)
+    {
+        std::ifstream is(fileName, std::ios::binary);
+        if (!is)
+            throw std::runtime_error("Could not open file '"+fileName+"'");
+
+        std::stringstream content;
+        content << is.rdbuf();
+        addToKey(content.str());
+    }
+
+    /*!
+     * \brief Returns the name of the cache file within a directory.
+     */
+    std::string fileName(const std::string& cacheDir) const
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(key_));
+        return cacheDir+"/grid-"+buf+".egc";
+    }
+
+    /*!
+     * \brief Read a cache file.
+     *
+     * This returns false if the file does not exist or if it does not match the current
+     * key.
+     */
+    bool load(const std::string& fileName)
+    {
+        std::ifstream is(fileName, std::ios::binary);
+        if (!is)
+            return false;
+
+        char fileMagic[8];
+        std::uint64_t fileKey;
+        std::uint32_t fileDim, fileDimWorld;
+        is.read(fileMagic, sizeof(fileMagic));
+        read_(is, fileKey);
+        read_(is, fileDim);
+        read_(is, fileDimWorld);
+        if (!is
+            || std::memcmp(fileMagic, magic_(), sizeof(fileMagic)) != 0
+            || fileKey != key_
+            || fileDim != dim
+            || fileDimWorld != dimWorld)
+            return false;
+
+        std::uint64_t n = 0;
+        read_(is, n);
+        if (!is)
+            return false;
+        vertices_.resize(n);
+        for (auto& pos : vertices_)
+            for (unsigned i = 0; i < dimWorld; ++i)
+                read_(is, pos[i]);
+
+        read_(is, n);
+        if (!is)
+            return false;
+        elementTypes_.resize(n);
+        elementCorners_.resize(n);
+        for (size_t elemIdx = 0; elemIdx < n; ++elemIdx) {
+            std::uint32_t topologyId;
+            read_(is, topologyId);
+            elementTypes_[elemIdx] = Dune::GeometryType(topologyId, dim);
+            readIndices_(is, elementCorners_[elemIdx]);
+        }
+
+        read_(is, n);
+        if (!is)
+            return false;
+        boundarySegments_.resize(n);
+        for (auto& segment : boundarySegments_)
+            readIndices_(is, segment);
+
+        read_(is, n);
+        if (!is)
+            return false;
+        fractureEdges_.resize(n);
+        for (auto& edge : fractureEdges_) {
+            read_(is, edge.first);
+            read_(is, edge.second);
+        }
+
+        return static_cast<bool>(is);
+    }
+
+    /*!
+     * \brief Create the grid from the data of a cache file.
+     *
+     * In parallel runs, only the process with rank zero inserts the entities into the
+     * grid factory, so the grid needs to be load balanced afterwards.
+     */
+    std::unique_ptr<Grid> createGrid(bool insertEntities = true)
+    {
+        Dune::GridFactory<Grid> factory;
+        if (insertEntities) {
+            for (const auto& pos : vertices_)
+                factory.insertVertex(pos);
+            for (size_t elemIdx = 0; elemIdx < elementTypes_.size(); ++elemIdx)
+                factory.insertElement(elementTypes_[elemIdx], elementCorners_[elemIdx]);
+            for (const auto& segment : boundarySegments_)
+                factory.insertBoundarySegment(segment);
+        }
+
+        std::unique_ptr<Grid> grid(factory.createGrid());
+
+        // translate the fracture edges from the indices in the cache file to the ones
+        // of the vertex mapper of the new grid
+        std::vector<Edge> fractureEdges;
+        if (insertEntities && !fractureEdges_.empty()) {
+            typedef typename Grid::LevelGridView LevelGridView;
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+            typedef Dune::MultipleCodimMultipleGeomTypeMapper<LevelGridView> VertexMapper;
+            LevelGridView gridView = grid->levelGridView(/*level=*/0);
+            VertexMapper vertexMapper(gridView, Dune::mcmgVertexLayout());
+#else
+            typedef Dune::MultipleCodimMultipleGeomTypeMapper<LevelGridView, Dune::MCMGVertexLayout> VertexMapper;
+            LevelGridView gridView = grid->levelGridView(/*level=*/0);
+            VertexMapper vertexMapper(gridView);
+#endif
+
+            std::vector<unsigned> newIndex(vertices_.size());
+            auto vIt = gridView.template begin</*codim=*/dim>();
+            const auto& vEndIt = gridView.template end</*codim=*/dim>();
+            for (; vIt != vEndIt; ++vIt)
+                newIndex[factory.insertionIndex(*vIt)] =
+                    static_cast<unsigned>(vertexMapper.index(*vIt));
+
+            for (const auto& edge : fractureEdges_)
+                fractureEdges.push_back(Edge(newIndex[edge.first], newIndex[edge.second]));
+        }
+        fractureEdges_.swap(fractureEdges);
+
+        return grid;
+    }
+
+    /*!
+     * \brief Returns the edges of the fractures after the grid was created.
+     *
+     * The vertex indices are the ones of the vertex mapper of the macro grid.
+     */
+    const std::vector<Edge>& fractureEdges() const
+    { return fractureEdges_; }
+
+    /*!
+     * \brief Write the leaf level of a grid to a cache file.
+     *
+     * \param fileName The name of the cache file
+     * \param grid The grid which is to be stored. It must not be distributed.
+     * \param fractureEdges The fracture edges given by the indices of the vertex mapper
+     *                      of the macro grid
+     */
+    void store(const std::string& fileName,
+               const Grid& grid,
+               const std::vector<Edge>& fractureEdges = std::vector<Edge>())
+    {
+        typedef typename Grid::LeafGridView LeafGridView;
+        typedef typename Grid::LevelGridView LevelGridView;
+        typedef typename Grid::LocalIdSet::IdType IdType;
+
+        const LeafGridView& gridView = grid.leafGridView();
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+        Dune::MultipleCodimMultipleGeomTypeMapper<LeafGridView>
+            vertexMapper(gridView, Dune::mcmgVertexLayout());
+#else
+        Dune::MultipleCodimMultipleGeomTypeMapper<LeafGridView, Dune::MCMGVertexLayout>
+            vertexMapper(gridView);
+#endif
+
+        vertices_.resize(static_cast<size_t>(gridView.size(dim)));
+        std::map<IdType, unsigned> leafVertexIndex;
+        auto vIt = gridView.template begin</*codim=*/dim>();
+        const auto& vEndIt = gridView.template end</*codim=*/dim>();
+        for (; vIt != vEndIt; ++vIt) {
+            unsigned vertexIdx = static_cast<unsigned>(vertexMapper.index(*vIt));
+            vertices_[vertexIdx] = vIt->geometry().corner(0);
+            leafVertexIndex[grid.localIdSet().id(*vIt)] = vertexIdx;
+        }
+
+        elementTypes_.clear();
+        elementCorners_.clear();
+        boundarySegments_.clear();
+        auto eIt = gridView.template begin</*codim=*/0>();
+        const auto& eEndIt = gridView.template end</*codim=*/0>();
+        for (; eIt != eEndIt; ++eIt) {
+            const auto& elem = *eIt;
+            const auto& refElem =
+                Dune::ReferenceElements<CoordScalar, dim>::general(elem.type());
+
+            std::vector<unsigned> corners(static_cast<size_t>(refElem.size(dim)));
+            for (unsigned i = 0; i < corners.size(); ++i)
+                corners[i] = static_cast<unsigned>(vertexMapper.subIndex(elem, static_cast<int>(i), dim));
+            elementTypes_.push_back(elem.type());
+            elementCorners_.push_back(corners);
+
+            auto isIt = gridView.ibegin(elem);
+            const auto& isEndIt = gridView.iend(elem);
+            for (; isIt != isEndIt; ++isIt) {
+                if (!isIt->boundary())
+                    continue;
+
+                int faceIdx = isIt->indexInInside();
+                std::vector<unsigned> segment(static_cast<size_t>(refElem.size(faceIdx, 1, dim)));
+                for (unsigned i = 0; i < segment.size(); ++i) {
+                    int localVertexIdx = refElem.subEntity(faceIdx, 1, static_cast<int>(i), dim);
+                    segment[i] = static_cast<unsigned>(vertexMapper.subIndex(elem, localVertexIdx, dim));
+                }
+                boundarySegments_.push_back(segment);
+            }
+        }
+
+        // the fracture edges are specified using the vertex indices of the macro grid.
+        // vertices which are copies of each other have the same ID on all levels.
+        fractureEdges_.clear();
+        if (!fractureEdges.empty()) {
+            LevelGridView macroView = grid.levelGridView(/*level=*/0);
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+            Dune::MultipleCodimMultipleGeomTypeMapper<LevelGridView>
+                macroVertexMapper(macroView, Dune::mcmgVertexLayout());
+#else
+            Dune::MultipleCodimMultipleGeomTypeMapper<LevelGridView, Dune::MCMGVertexLayout>
+                macroVertexMapper(macroView);
+#endif
+
+            std::vector<unsigned> leafIndex(static_cast<size_t>(macroView.size(dim)));
+            auto mvIt = macroView.template begin</*codim=*/dim>();
+            const auto& mvEndIt = macroView.template end</*codim=*/dim>();
+            for (; mvIt != mvEndIt; ++mvIt)
+                leafIndex[static_cast<size_t>(macroVertexMapper.index(*mvIt))] =
+                    leafVertexIndex.at(grid.localIdSet().id(*mvIt));
+
+            for (const auto& edge : fractureEdges)
+                fractureEdges_.push_back(Edge(leafIndex[edge.first], leafIndex[edge.second]));
+        }
+
+        // write the data to a temporary file first and rename it afterwards, so that
+        // concurrent runs never see partially written cache files
+        std::string tmpFileName = fileName+".tmp";
+        {
+            std::ofstream os(tmpFileName, std::ios::binary);
+            if (!os)
+                throw std::runtime_error("Could not create grid cache file '"+tmpFileName+"'");
+
+            os.write(magic_(), 8);
+            write_(os, key_);
+            write_(os, static_cast<std::uint32_t>(dim));
+            write_(os, static_cast<std::uint32_t>(dimWorld));
+
+            write_(os, static_cast<std::uint64_t>(vertices_.size()));
+            for (const auto& pos : vertices_)
+                for (unsigned i = 0; i < dimWorld; ++i)
+                    write_(os, pos[i]);
+
+            write_(os, static_cast<std::uint64_t>(elementTypes_.size()));
+            for (size_t elemIdx = 0; elemIdx < elementTypes_.size(); ++elemIdx) {
+                write_(os, static_cast<std::uint32_t>(elementTypes_[elemIdx].id()));
+                writeIndices_(os, elementCorners_[elemIdx]);
+            }
+
+            write_(os, static_cast<std::uint64_t>(boundarySegments_.size()));
+            for (const auto& segment : boundarySegments_)
+                writeIndices_(os, segment);
+
+            write_(os, static_cast<std::uint64_t>(fractureEdges_.size()));
+            for (const auto& edge : fractureEdges_) {
+                write_(os, edge.first);
+                write_(os, edge.second);
+            }
+
+            if (!os)
+                throw std::runtime_error("Could not write grid cache file '"+tmpFileName+"'");
+        }
+
+        if (std::rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+            throw std::runtime_error("Could not rename grid cache file '"+tmpFileName+"'");
+    }
+
+private:
+    template <class T>
+    static void read_(std::istream& is, T& value)
+    { is.read(reinterpret_cast<char*>(&value), sizeof(T)); }
+
+    template <class T>
+    static void write_(std::ostream& os, const T& value)
+    { os.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    static void readIndices_(std::istream& is, std::vector<unsigned>& indices)
+    {
+        std::uint32_t n = 0;
+        read_(is, n);
+        indices.resize(is ? n : 0);
+        for (auto& idx : indices)
+            read_(is, idx);
+    }
+
+    static void writeIndices_(std::ostream& os, const std::vector<unsigned>& indices)
+    {
+        write_(os, static_cast<std::uint32_t>(indices.size()));
+        for (const auto& idx : indices)
+            write_(os, idx);
+    }
+
+    std::uint64_t key_;
+
+    std::vector<GlobalPosition> vertices_;
+    std::vector<Dune::GeometryType> elementTypes_;
+    std::vector<std::vector<unsigned> > elementCorners_;
+    std::vector<std::vector<unsigned> > boundarySegments_;
+    std::vector<Edge> fractureEdges_;
+};
+
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,149 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::OutputBufferLimiter
+ */
+#ifndef EWOMS_OUTPUT_BUFFER_LIMITER_HH
+#define EWOMS_OUTPUT_BUFFER_LIMITER_HH
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace Ewoms {
+/*!
+ * \brief Limits the number and the memory of the buffer sets which are handed over to
+ *        an asynchronous output writer.
+ *
+ * The writers copy the data of each time step into a separate set of buffers, so the
+ * simulation can fill the next set while older ones are still written to disk. The
+ * "depth" is the number of buffer sets which may exist at the same time, i.e., the one
+ * which is currently filled plus the ones which wait to be written. A depth of one thus
+ * corresponds to fully synchronized output, a depth of two to double buffering.
+ *
+ * If the memory occupied by the pending buffer sets would exceed a given limit, the
+ * writer waits until the data of all previous time steps has been written.
+ */
+class OutputBufferLimiter
+{
+public:
+    OutputBufferLimiter(unsigned depth, size_t maxBytes)
+        : maxPending_(std::max(depth, 1u) - 1)
+        , maxBytes_(maxBytes)
+        , numPending_(0)
+        , numPendingBytes_(0)
+        , peakPendingBytes_(0)
+        , lastBytes_(0)
+    { }
+
+    /*!
+     * \brief Block until a new buffer set may be filled.
+     *
+     * The size of the new set is assumed to be the same as the one of the previous set.
+     */
+    void waitForFreeSlot()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        const auto& slotIsFree =
+            [this]() -> bool
+            {
+                if (numPending_ == 0)
+                    return true;
+
+                return
+                    numPending_ <= maxPending_
+                    && numPendingBytes_ + lastBytes_ <= maxBytes_;
+            };
+
+        slotCondition_.wait(lock, /*predicate=*/slotIsFree);
+    }
+
+    /*!
+     * \brief Mark a buffer set as filled and waiting to be written.
+     */
+    void acquire(size_t numBytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        ++numPending_;
+        numPendingBytes_ += numBytes;
+        peakPendingBytes_ = std::max(peakPendingBytes_, numPendingBytes_);
+        lastBytes_ = numBytes;
+    }
+
+    /*!
+     * \brief Mark a buffer set as written.
+     *
+     * This is called by the thread which does the writing after the buffers have been
+     * deallocated.
+     */
+    void release(size_t numBytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            --numPending_;
+            numPendingBytes_ -= numBytes;
+        }
+
+        slotCondition_.notify_all();
+    }
+
+    /*!
+     * \brief Returns the number of buffer sets which wait to be written.
+     */
+    unsigned numPending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return numPending_;
+    }
+
+    /*!
+     * \brief Returns the maximum memory which was occupied by the buffer sets at the
+     *        same time so far [bytes].
+     */
+    size_t peakPendingBytes() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return peakPendingBytes_;
+    }
+
+private:
+    unsigned maxPending_;
+    size_t maxBytes_;
+
+    unsigned numPending_;
+    size_t numPendingBytes_;
+    size_t peakPendingBytes_;
+    size_t lastBytes_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable slotCondition_;
+};
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,424 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::OutputSelection
+ */
+#ifndef EWOMS_OUTPUT_SELECTION_HH
+#define EWOMS_OUTPUT_SELECTION_HH
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief Specifies which output fields are written, for which region of the spatial
+ *        domain and how often.
+ *
+ * A selection consists of statements which are separated by semicolons or line
+ * breaks. Everything after a '#' character is ignored. The following statements are
+ * understood:
+ *
+ * - <tt>fields = PATTERN, PATTERN, ...</tt>: Only write the fields whose name matches
+ *   one of the patterns. If no such statement is given, all fields are written which
+ *   are enabled by the respective <tt>VtkWrite*</tt> parameters.
+ * - <tt>interval = N</tt>: Only write the fields every N-th output step.
+ * - <tt>interval PATTERN = N</tt>: Only write the fields matching the pattern every N-th
+ *   output step. This overwrites the global interval for these fields. If more than
+ *   one pattern matches, the first statement wins.
+ * - <tt>box = XMIN YMIN [ZMIN] XMAX YMAX [ZMAX]</tt>: Add the elements whose centroid
+ *   lies within an axis-aligned box to the region of interest.
+ * - <tt>elements = IDX, FIRST-LAST, ...</tt>: Add elements given by their process-local
+ *   index to the region of interest. Since these indices differ between the processes,
+ *   element ranges can only be used for sequential runs.
+ *
+ * Patterns may contain the wildcards '*' and '?'. They are matched against the name
+ * of a field without the suffixes for the phase and component names, e.g., the
+ * pattern "pressure" selects "pressure_w" and "pressure_n". If a region of interest is
+ * specified, the quantities are only computed for the elements in the region. The
+ * entries of all other elements are zero (or NaN for quantities which are averaged
+ * over faces like velocities). The first output step of a run has index 0, i.e., all
+ * fields are written for it. Output steps are only counted for the regular output of
+ * time steps, i.e., writing the convergence of the Newton method does not advance them.
+ *
+ * Example:
+ * \code
+ * fields = pressure, saturation, temperature
+ * interval temperature = 10
+ * box = 0 0 0 100 100 10
+ * \endcode
+ */
+class OutputSelection
+{
+    struct FieldInterval
+    {
+        std::string pattern;
+        unsigned interval;
+    };
+
+    struct Box
+    {
+        std::vector<double> min;
+        std::vector<double> max;
+    };
+
+public:
+    OutputSelection()
+        : defaultInterval_(1)
+        , outputStepIdx_(0)
+        , numOutputSteps_(0)
+    { }
+
+    /*!
+     * \brief Add the statements of a string to the selection.
+     *
+     * \param spec The statements
+     * \param origin Where the statements come from (used for error messages)
+     */
+    void parse(const std::string& spec, const std::string& origin = "output selection")
+    {
+        std::string statement;
+        unsigned lineIdx = 1;
+        for (size_t i = 0; i <= spec.size(); ++i) {
+            char c = (i < spec.size()) ? spec[i] : '\n';
+            if (c == ';' || c == '\n') {
+                parseStatement_(statement, origin, lineIdx);
+                statement.clear();
+                if (c == '\n')
+                    ++ lineIdx;
+            }
+            else
+                statement += c;
+        }
+    }
+
+    /*!
+     * \brief Add the statements of a file to the selection.
+     */
+    void parseFile(const std::string& fileName)
+    {
+        std::ifstream is(fileName);
+        if (!is)
+            throw std::runtime_error("Could not open output selection file '"+fileName+"'");
+
+        std::stringstream content;
+        content << is.rdbuf();
+        parse(content.str(), fileName);
+    }
+
+    /*!
+     * \brief Check whether the selection can be applied to a given grid.
+     *
+     * This throws if the dimension of a box does not match the one of the world or if
+     * element ranges are used in a parallel run.
+     *
+     * \param dimWorld The dimension of the world in which the grid is embedded
+     * \param commSize The number of processes of the simulation
+     */
+    void validate(unsigned dimWorld, int commSize) const
+    {
+        for (const auto& box : boxes_)
+            if (box.min.size() != dimWorld)
+                throw std::runtime_error("The dimension of the boxes of the output selection "
+                                         "does not match the one of the grid");
+
+        if (!elementRanges_.empty() && commSize > 1)
+            throw std::runtime_error("Element ranges of the output selection refer to "
+                                     "process-local indices and cannot be used for "
+                                     "parallel runs");
+    }
+
+    /*!
+     * \brief Returns true if all fields are written for all output steps.
+     */
+    bool selectsAllFields() const
+    { return fieldPatterns_.empty() && fieldIntervals_.empty() && defaultInterval_ == 1; }
+
+    /*!
+     * \brief Returns true if the output is restricted to a part of the spatial domain.
+     */
+    bool hasRegion() const
+    { return !boxes_.empty() || !elementRanges_.empty(); }
+
+    /*!
+     * \brief Start the next output step.
+     *
+     * This needs to be called once before the output fields of a time step are
+     * computed. Output which is not associated with a time step (e.g., the one for the
+     * convergence of the Newton method) uses the current output step.
+     */
+    void beginOutputStep()
+    { outputStepIdx_ = numOutputSteps_++; }
+
+    /*!
+     * \brief Returns the index of the current output step.
+     */
+    unsigned outputStepIdx() const
+    { return outputStepIdx_; }
+
+    /*!
+     * \brief Returns true if a field is written for the current output step.
+     *
+     * \param name The name of the field as passed to the output writer. Placeholders for
+     *             phase and component names (starting with "_%" or "^%") and everything
+     *             after them are ignored.
+     */
+    bool fieldSelected(const std::string& name) const
+    {
+        if (selectsAllFields())
+            return true;
+
+        std::string key = fieldKey_(name);
+        if (!fieldPatterns_.empty()) {
+            bool matches = false;
+            for (const auto& pattern : fieldPatterns_) {
+                if (globMatch_(pattern, key)) {
+                    matches = true;
+                    break;
+                }
+            }
+
+            if (!matches)
+                return false;
+        }
+
+        unsigned interval = defaultInterval_;
+        for (const auto& fieldInterval : fieldIntervals_) {
+            if (globMatch_(fieldInterval.pattern, key)) {
+                interval = fieldInterval.interval;
+                break;
+            }
+        }
+
+        return outputStepIdx_%interval == 0;
+    }
+
+    /*!
+     * \brief Returns true if an element is part of the region of interest.
+     *
+     * \param elemIdx The process-local index of the element
+     * \param centroid The centroid of the element
+     *
+     * The selection must have been checked using validate() before.
+     */
+    template <class GlobalPosition>
+    bool elementSelected(size_t elemIdx, const GlobalPosition& centroid) const
+    {
+        if (!hasRegion())
+            return true;
+
+        for (const auto& range : elementRanges_)
+            if (range.first <= elemIdx && elemIdx <= range.second)
+                return true;
+
+        for (const auto& box : boxes_) {
+            bool inside = true;
+            for (unsigned i = 0; i < centroid.size() && inside; ++i)
+                inside = box.min[i] <= centroid[i] && centroid[i] <= box.max[i];
+            if (inside)
+                return true;
+        }
+
+        return false;
+    }
+
+    /*!
+     * \brief Write the number of output steps to a restart file.
+     */
+    template <class Restarter>
+    void serialize(Restarter& res) const
+    {
+        res.serializeSectionBegin("OutputSelection");
+        res.serializeStream() << numOutputSteps_ << "\n";
+        res.serializeSectionEnd();
+    }
+
+    /*!
+     * \brief Read the number of output steps from a restart file.
+     */
+    template <class Restarter>
+    void deserialize(Restarter& res)
+    {
+        res.deserializeSectionBegin("OutputSelection");
+        res.deserializeStream() >> numOutputSteps_;
+        std::string dummy;
+        std::getline(res.deserializeStream(), dummy);
+        res.deserializeSectionEnd();
+
+        outputStepIdx_ = (numOutputSteps_ > 0) ? numOutputSteps_ - 1 : 0;
+    }
+
+private:
+    void parseStatement_(std::string statement, const std::string& origin, unsigned lineIdx)
+    {
+        size_t commentPos = statement.find('#');
+        if (commentPos != std::string::npos)
+            statement.erase(commentPos);
+        statement = trim_(statement);
+        if (statement.empty())
+            return;
+
+        size_t eqPos = statement.find('=');
+        if (eqPos == std::string::npos)
+            throw std::runtime_error(errorPrefix_(origin, lineIdx)+"Missing '=' in statement '"+statement+"'");
+
+        std::string lhs = trim_(statement.substr(0, eqPos));
+        std::string rhs = trim_(statement.substr(eqPos + 1));
+
+        std::string keyword = lhs.substr(0, lhs.find_first_of(" \t"));
+        std::string argument = trim_(lhs.substr(keyword.size()));
+
+        if (keyword == "fields" && argument.empty()) {
+            for (const auto& pattern : splitList_(rhs))
+                fieldPatterns_.push_back(pattern);
+        }
+        else if (keyword == "interval") {
+            unsigned interval = parseUnsigned_(rhs, origin, lineIdx);
+            if (interval == 0)
+                throw std::runtime_error(errorPrefix_(origin, lineIdx)+"Output intervals must be positive");
+
+            if (argument.empty())
+                defaultInterval_ = interval;
+            else
+                fieldIntervals_.push_back(FieldInterval{argument, interval});
+        }
+        else if (keyword == "box" && argument.empty()) {
+            std::istringstream iss(rhs);
+            std::vector<double> coords;
+            double x;
+            while (iss >> x)
+                coords.push_back(x);
+            if (!iss.eof() || coords.empty() || coords.size() > 6 || coords.size()%2 != 0)
+                throw std::runtime_error(errorPrefix_(origin, lineIdx)+"Invalid box '"+rhs+"'");
+
+            size_t dim = coords.size()/2;
+            Box box;
+            box.min.assign(coords.begin(), coords.begin() + static_cast<long>(dim));
+            box.max.assign(coords.begin() + static_cast<long>(dim), coords.end());
+            boxes_.push_back(box);
+        }
+        else if (keyword == "elements" && argument.empty()) {
+            for (const auto& item : splitList_(rhs)) {
+                size_t dashPos = item.find('-');
+                size_t first, last;
+                if (dashPos == std::string::npos)
+                    first = last = parseUnsigned_(item, origin, lineIdx);
+                else {
+                    first = parseUnsigned_(trim_(item.substr(0, dashPos)), origin, lineIdx);
+                    last = parseUnsigned_(trim_(item.substr(dashPos + 1)), origin, lineIdx);
+                }
+                elementRanges_.push_back(std::make_pair(first, last));
+            }
+        }
+        else
+            throw std::runtime_error(errorPrefix_(origin, lineIdx)+"Unknown statement '"+statement+"'");
+    }
+
+    static std::string fieldKey_(const std::string& name)
+    {
+        size_t pos = std::min(name.find("_%"), name.find("^%"));
+        return name.substr(0, pos);
+    }
+
+    // returns true if a string matches a pattern with the wildcards '*' and '?'
+    static bool globMatch_(const std::string& pattern, const std::string& str)
+    {
+        size_t p = 0, s = 0;
+        size_t starP = std::string::npos, starS = 0;
+        while (s < str.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s])) {
+                ++p;
+                ++s;
+            }
+            else if (p < pattern.size() && pattern[p] == '*') {
+                starP = p++;
+                starS = s;
+            }
+            else if (starP != std::string::npos) {
+                p = starP + 1;
+                s = ++starS;
+            }
+            else
+                return false;
+        }
+
+        while (p < pattern.size() && pattern[p] == '*')
+            ++p;
+        return p == pattern.size();
+    }
+
+    static std::vector<std::string> splitList_(const std::string& list)
+    {
+        std::vector<std::string> result;
+        std::istringstream iss(list);
+        std::string item;
+        while (std::getline(iss, item, ',')) {
+            item = trim_(item);
+            if (!item.empty())
+                result.push_back(item);
+        }
+        return result;
+    }
+
+    static std::string trim_(const std::string& str)
+    {
+        const char* whitespace = " \t\r";
+        size_t first = str.find_first_not_of(whitespace);
+        if (first == std::string::npos)
+            return "";
+        size_t last = str.find_last_not_of(whitespace);
+        return str.substr(first, last - first + 1);
+    }
+
+    static unsigned parseUnsigned_(const std::string& str, const std::string& origin, unsigned lineIdx)
+    {
+        char* end;
+        unsigned long value = std::strtoul(str.c_str(), &end, 10);
+        if (str.empty() || *end != '\0' || str[0] == '-')
+            throw std::runtime_error(errorPrefix_(origin, lineIdx)+"'"+str+"' is not a non-negative integer");
+        return static_cast<unsigned>(value);
+    }
+
+    static std::string errorPrefix_(const std::string& origin, unsigned lineIdx)
+    { return origin+":"+std::to_string(lineIdx)+": "; }
+
+    std::vector<std::string> fieldPatterns_;
+    std::vector<FieldInterval> fieldIntervals_;
+    unsigned defaultInterval_;
+
+    std::vector<Box> boxes_;
+    std::vector<std::pair<size_t, size_t> > elementRanges_;
+
+    unsigned outputStepIdx_;
+    unsigned numOutputSteps_;
+};
+} // namespace Ewoms
+
+#endif
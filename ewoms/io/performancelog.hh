@@ -0,0 +1,246 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::PerformanceLog
+ */
+#ifndef EWOMS_PERFORMANCE_LOG_HH
+#define EWOMS_PERFORMANCE_LOG_HH
+
+#include "timingreceipt.hh"
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief The performance figures of a single time step.
+ *
+ * All times are wall clock times in seconds which the first process spent on the time
+ * step. The total wall time includes the attempts which failed and caused the step size
+ * to be cut, whereas the times of the individual phases only refer to the successful
+ * attempt.
+ */
+struct TimeStepPerformance
+{
+    int timeStepIdx = 0;
+
+    //! The simulated time at the end of the time step
+    double time = 0.0;
+    double timeStepSize = 0.0;
+
+    //! The number of times the step size was cut before the time integration succeeded
+    unsigned numTimeStepCuts = 0;
+
+    //! The number of Newton iterations of the successful attempt
+    unsigned numNewtonIterations = 0;
+
+    //! The number of Newton iterations which reused the Jacobian of a previous one
+    unsigned numReusedJacobians = 0;
+
+    //! The number of linear solver iterations for each Newton iteration
+    std::vector<unsigned> linearIterations;
+
+    //! The step length accepted by the line search for each Newton iteration (empty if
+    //! the line search is disabled)
+    std::vector<double> stepLengths;
+
+    double wallTime = 0.0;
+    double linearizeTime = 0.0;
+    double solveTime = 0.0;
+    double linearSolverSetupTime = 0.0;
+    double linearSolverIterationTime = 0.0;
+    double overlapSyncTime = 0.0;
+    double updateTime = 0.0;
+    double prePostProcessTime = 0.0;
+    double writeTime = 0.0;
+
+    //! The total number of degrees of freedom of all processes
+    unsigned long numDof = 0;
+
+    //! The maximum and average weighted residual of the solution
+    double maxResidual = 0.0;
+    double avgResidual = 0.0;
+
+    /*!
+     * \brief Returns the number of degrees of freedom which were advanced by one time
+     *        step per second of wall clock time.
+     */
+    double dofsPerSecond() const
+    { return (wallTime > 0.0) ? numDof/wallTime : 0.0; }
+};
+
+/*!
+ * \brief Writes a structured log of the performance of a simulation.
+ *
+ * The log contains one record for each time step and a summary which holds the figures
+ * of the timing receipt. If the name of the file ends with ".csv", the log is written as
+ * comma separated values with a header line, the linear iterations of the Newton
+ * iterations of a time step are separated by semicolons and the summary is appended as
+ * a JSON object in a line starting with "# summary: ". Otherwise, the log is written in
+ * the JSON Lines format, i.e., each time step and the summary are a single JSON object
+ * per line which are distinguished by their "type" member.
+ *
+ * Only the process which opened the log writes anything.
+ */
+class PerformanceLog
+{
+public:
+    PerformanceLog()
+        : csv_(false)
+    { }
+
+    /*!
+     * \brief Open the log file.
+     *
+     * This must only be called by a single process.
+     */
+    void open(const std::string& fileName)
+    {
+        const std::string csvExt(".csv");
+        csv_ =
+            fileName.size() >= csvExt.size()
+            && fileName.compare(fileName.size() - csvExt.size(), csvExt.size(), csvExt) == 0;
+
+        os_.open(fileName);
+        if (!os_)
+            throw std::runtime_error("Could not open file '"+fileName+"' for writing the performance log");
+        os_ << std::setprecision(std::numeric_limits<double>::digits10 + 1);
+
+        if (csv_)
+            os_ << "timeStepIdx,time,timeStepSize,numTimeStepCuts,numNewtonIterations,"
+                << "numReusedJacobians,linearIterations,stepLengths,wallTime,linearizeTime,solveTime,linearSolverSetupTime,"
+                << "linearSolverIterationTime,overlapSyncTime,updateTime,prePostProcessTime,"
+                << "writeTime,numDof,dofsPerSecond,maxResidual,avgResidual\n";
+    }
+
+    /*!
+     * \brief Returns true iff the log is written by the current process.
+     */
+    bool isOpen() const
+    { return os_.is_open(); }
+
+    /*!
+     * \brief Append the record of a time step to the log.
+     */
+    void writeTimeStep(const TimeStepPerformance& step)
+    {
+        if (!isOpen())
+            return;
+
+        if (csv_) {
+            os_ << step.timeStepIdx
+                << "," << step.time
+                << "," << step.timeStepSize
+                << "," << step.numTimeStepCuts
+                << "," << step.numNewtonIterations
+                << "," << step.numReusedJacobians
+                << ",";
+            for (size_t i = 0; i < step.linearIterations.size(); ++i)
+                os_ << ((i > 0) ? ";" : "") << step.linearIterations[i];
+            os_ << ",";
+            for (size_t i = 0; i < step.stepLengths.size(); ++i)
+                os_ << ((i > 0) ? ";" : "") << step.stepLengths[i];
+            os_ << "," << step.wallTime
+                << "," << step.linearizeTime
+                << "," << step.solveTime
+                << "," << step.linearSolverSetupTime
+                << "," << step.linearSolverIterationTime
+                << "," << step.overlapSyncTime
+                << "," << step.updateTime
+                << "," << step.prePostProcessTime
+                << "," << step.writeTime
+                << "," << step.numDof
+                << "," << step.dofsPerSecond()
+                << "," << step.maxResidual
+                << "," << step.avgResidual
+                << "\n";
+        }
+        else {
+            os_ << "{\"type\": \"timeStep\""
+                << ", \"timeStepIdx\": " << step.timeStepIdx
+                << ", \"time\": " << step.time
+                << ", \"timeStepSize\": " << step.timeStepSize
+                << ", \"numTimeStepCuts\": " << step.numTimeStepCuts
+                << ", \"numNewtonIterations\": " << step.numNewtonIterations
+                << ", \"numReusedJacobians\": " << step.numReusedJacobians
+                << ", \"linearIterations\": [";
+            for (size_t i = 0; i < step.linearIterations.size(); ++i)
+                os_ << ((i > 0) ? ", " : "") << step.linearIterations[i];
+            os_ << "]"
+                << ", \"stepLengths\": [";
+            for (size_t i = 0; i < step.stepLengths.size(); ++i)
+                os_ << ((i > 0) ? ", " : "") << step.stepLengths[i];
+            os_ << "]"
+                << ", \"wallTime\": " << step.wallTime
+                << ", \"linearizeTime\": " << step.linearizeTime
+                << ", \"solveTime\": " << step.solveTime
+                << ", \"linearSolverSetupTime\": " << step.linearSolverSetupTime
+                << ", \"linearSolverIterationTime\": " << step.linearSolverIterationTime
+                << ", \"overlapSyncTime\": " << step.overlapSyncTime
+                << ", \"updateTime\": " << step.updateTime
+                << ", \"prePostProcessTime\": " << step.prePostProcessTime
+                << ", \"writeTime\": " << step.writeTime
+                << ", \"numDof\": " << step.numDof
+                << ", \"dofsPerSecond\": " << step.dofsPerSecond()
+                << ", \"maxResidual\": " << step.maxResidual
+                << ", \"avgResidual\": " << step.avgResidual
+                << "}\n";
+        }
+
+        // make sure that the log is useful even if the simulation crashes later
+        os_.flush();
+    }
+
+    /*!
+     * \brief Append the summary of the simulation to the log.
+     */
+    void writeSummary(const TimingReceipt& receipt)
+    {
+        if (!isOpen())
+            return;
+
+        if (csv_) {
+            os_ << "# summary: ";
+            receipt.writeJson(os_);
+        }
+        else {
+            os_ << "{\"type\": \"summary\", ";
+            receipt.writeJsonMembers(os_);
+            os_ << "}\n";
+        }
+        os_.flush();
+    }
+
+private:
+    std::ofstream os_;
+    bool csv_;
+};
+} // namespace Ewoms
+
+#endif
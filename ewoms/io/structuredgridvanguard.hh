@@ -28,6 +28,7 @@
 #define EWOMS_STRUCTURED_GRID_VANGUARD_HH
 
 #include <ewoms/io/basevanguard.hh>
+#include <ewoms/io/gridcache.hh>
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
 
@@ -41,9 +42,12 @@
 
 #include <dune/common/fvector.hh>
 #include <dune/common/version.hh>
+#include <dune/common/parallel/mpihelper.hh>
 
 #include <vector>
 #include <memory>
+#include <sstream>
+#include <string>
 
 namespace Ewoms {
 
@@ -69,6 +73,7 @@ NEW_PROP_TAG(CellsY);
 NEW_PROP_TAG(CellsZ);
 
 NEW_PROP_TAG(GridGlobalRefinements);
+NEW_PROP_TAG(GridCacheDirectory);
 
 // GRIDDIM is only set by the finger problem
 #ifndef GRIDDIM
@@ -116,6 +121,9 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, unsigned, GridGlobalRefinements,
                              "The number of global refinements of the grid "
                              "executed after it was loaded");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, GridCacheDirectory,
+                             "The directory in which the refined grid is cached in a binary "
+                             "format for subsequent runs. If empty, no cache is used");
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, DomainSizeX,
                              "The size of the domain in x direction");
         EWOMS_REGISTER_PARAM(TypeTag, unsigned, CellsX,
@@ -169,12 +177,37 @@ public:
         dgffile << "Simplex" << std::endl;
         dgffile << "#" << std::endl;
 
+        unsigned numRefinements = EWOMS_GET_PARAM(TypeTag, unsigned, GridGlobalRefinements);
+
+        // the grid cache is only beneficial for unstructured grids. (YaspGrid is not
+        // supported by the cache but it can be created quickly anyway.)
+        const std::string cacheDir = EWOMS_GET_PARAM(TypeTag, std::string, GridCacheDirectory);
+        const auto& comm = Dune::MPIHelper::getCollectiveCommunication();
+        GridCache<Grid> gridCache;
+        bool useCache = !cacheDir.empty() && GridCacheSupported<Grid>::value;
+        if (useCache) {
+            gridCache.addToKey(dgffile.str());
+            gridCache.addToKey("refinements="+std::to_string(numRefinements));
+
+            int cacheValid = 0;
+            if (comm.rank() == 0)
+                cacheValid = gridCache.load(gridCache.fileName(cacheDir)) ? 1 : 0;
+            comm.broadcast(&cacheValid, /*count=*/1, /*root=*/0);
+            if (cacheValid) {
+                gridPtr_ = gridCache.createGrid(/*insertEntities=*/comm.rank() == 0);
+                this->finalizeInit_();
+                return;
+            }
+        }
+
         // use DGF parser to create a grid from interval block
         gridPtr_.reset( Dune::GridPtr< Grid >( dgffile ).release() );
 
-        unsigned numRefinements = EWOMS_GET_PARAM(TypeTag, unsigned, GridGlobalRefinements);
         gridPtr_->globalRefine(static_cast<int>(numRefinements));
 
+        if (useCache && comm.size() == 1)
+            gridCache.store(gridCache.fileName(cacheDir), *gridPtr_);
+
         this->finalizeInit_();
     }
 
@@ -0,0 +1,400 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::TimeSeriesReader
+ */
+#ifndef EWOMS_TIME_SERIES_READER_HH
+#define EWOMS_TIME_SERIES_READER_HH
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Ewoms {
+/*!
+ * \brief Describes the on-disk layout of the files written by TimeSeriesWriter.
+ *
+ * A file consists of a fixed size header followed by the data of the time steps. The
+ * data of a time step is a sequence of columns, one for each field, followed by a
+ * record which describes the columns:
+ *
+ * - Header (64 bytes): magic[8], version (uint32), byte order mark (uint32), number of
+ *   time steps (uint64), offset of the record of the last time step (uint64), 32 bytes
+ *   of padding.
+ * - Column: numEntities*numComponents values of type double. The components of an
+ *   entity are stored consecutively, tensors are stored row by row.
+ * - Record: size of the record (uint64), offset of the record of the previous time step
+ *   or 0 (uint64), time (double), number of fields (uint64) and for each field: offset
+ *   of the column (uint64), number of entities (uint64), entity kind (uint32), number of
+ *   components (uint32), length of the name (uint32) and the name, padded to a multiple
+ *   of eight bytes.
+ *
+ * The header is updated after the record of a time step has been written, so the file
+ * stays consistent if a simulation is aborted.
+ */
+struct TimeSeriesFormat
+{
+    enum EntityKind {
+        VertexEntity = 0,
+        ElementEntity = 1
+    };
+
+    static const char* magic()
+    { return "EWOMSTSF"; }
+
+    static std::uint32_t version()
+    { return 1; }
+
+    static std::uint32_t byteOrderMark()
+    { return 0x01020304; }
+
+    static size_t headerSize()
+    { return 64; }
+
+    static size_t paddedSize(size_t numBytes)
+    { return (numBytes + 7)/8*8; }
+};
+
+/*!
+ * \brief Provides access to the files written by TimeSeriesWriter.
+ *
+ * The file is mapped into memory, so the column of a field for a given time step can be
+ * accessed without copying the data and the time history of a single entity only
+ * touches the pages which contain its values.
+ */
+class TimeSeriesReader
+{
+public:
+    typedef TimeSeriesFormat::EntityKind EntityKind;
+
+    struct FieldInfo
+    {
+        std::string name;
+        EntityKind kind;
+        unsigned numComponents;
+    };
+
+    /*!
+     * \brief Open a time series file.
+     *
+     * An exception is thrown if the file cannot be opened or if it is not valid.
+     */
+    explicit TimeSeriesReader(const std::string& fileName)
+        : fileName_(fileName)
+        , data_(nullptr)
+        , size_(0)
+    {
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Could not open time series file '"+fileName+"'");
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0) {
+            close(fd);
+            throw std::runtime_error("Could not determine the size of the time series file '"+fileName+"'");
+        }
+        size_ = static_cast<size_t>(fileStat.st_size);
+
+        if (size_ > 0) {
+            void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Could not map the time series file '"+fileName+"' into memory");
+            }
+            data_ = static_cast<const char*>(addr);
+        }
+        close(fd);
+
+        try {
+            readIndex_();
+        }
+        catch (...) {
+            unmap_();
+            throw;
+        }
+    }
+
+    ~TimeSeriesReader()
+    { unmap_(); }
+
+    TimeSeriesReader(const TimeSeriesReader&) = delete;
+    TimeSeriesReader& operator=(const TimeSeriesReader&) = delete;
+
+    /*!
+     * \brief Returns the number of time steps stored in the file.
+     */
+    size_t numTimeSteps() const
+    { return steps_.size(); }
+
+    /*!
+     * \brief Returns the time [s] of a time step.
+     */
+    double time(size_t stepIdx) const
+    { return steps_.at(stepIdx).time; }
+
+    /*!
+     * \brief Returns the number of fields which occur in at least one time step.
+     */
+    size_t numFields() const
+    { return fields_.size(); }
+
+    /*!
+     * \brief Returns the name, the entity kind and the number of components of a field.
+     */
+    const FieldInfo& field(size_t fieldIdx) const
+    { return fields_.at(fieldIdx); }
+
+    /*!
+     * \brief Returns the index of a field given its name or -1 if the field does not
+     *        exist.
+     */
+    int fieldIndex(const std::string& name) const
+    {
+        auto it = fieldIndices_.find(name);
+        if (it == fieldIndices_.end())
+            return -1;
+        return static_cast<int>(it->second);
+    }
+
+    /*!
+     * \brief Returns true if a field was written for a given time step.
+     */
+    bool hasData(size_t fieldIdx, size_t stepIdx) const
+    { return column_(fieldIdx, stepIdx).offset != 0; }
+
+    /*!
+     * \brief Returns the number of entities of a field for a given time step.
+     */
+    size_t numEntities(size_t fieldIdx, size_t stepIdx) const
+    { return column_(fieldIdx, stepIdx).numEntities; }
+
+    /*!
+     * \brief Returns a pointer to the values of a field for a given time step.
+     *
+     * The components of an entity are stored consecutively. If the field was not
+     * written for the time step, a null pointer is returned.
+     */
+    const double* data(size_t fieldIdx, size_t stepIdx) const
+    {
+        const Column& col = column_(fieldIdx, stepIdx);
+        if (col.offset == 0)
+            return nullptr;
+        return reinterpret_cast<const double*>(data_ + col.offset);
+    }
+
+    /*!
+     * \brief Returns the values of a component of a field for a single entity over all
+     *        time steps.
+     *
+     * For time steps for which the field was not written or which have fewer entities,
+     * NaN is returned.
+     */
+    std::vector<double> timeHistory(size_t fieldIdx, size_t entityIdx, unsigned compIdx = 0) const
+    {
+        unsigned numComponents = field(fieldIdx).numComponents;
+        if (compIdx >= numComponents)
+            throw std::out_of_range("Invalid component index for field '"+field(fieldIdx).name+"'");
+
+        std::vector<double> result(numTimeSteps(), std::numeric_limits<double>::quiet_NaN());
+        for (size_t stepIdx = 0; stepIdx < numTimeSteps(); ++stepIdx) {
+            const double* values = data(fieldIdx, stepIdx);
+            if (values && entityIdx < numEntities(fieldIdx, stepIdx))
+                result[stepIdx] = values[entityIdx*numComponents + compIdx];
+        }
+
+        return result;
+    }
+
+    /*!
+     * \brief Returns the position of the record which describes a time step.
+     *
+     * This is used to continue writing a file after a restart.
+     */
+    size_t recordOffset(size_t stepIdx) const
+    { return steps_.at(stepIdx).recordOffset; }
+
+    /*!
+     * \brief Returns the position in the file directly after the data of a time step.
+     *
+     * This is used to continue writing a file after a restart.
+     */
+    size_t stepEndOffset(size_t stepIdx) const
+    { return steps_.at(stepIdx).endOffset; }
+
+private:
+    struct Column
+    {
+        std::uint64_t offset;
+        std::uint64_t numEntities;
+    };
+
+    struct Step
+    {
+        double time;
+        size_t recordOffset;
+        size_t endOffset;
+
+        // the columns of all fields, indexed by the field index
+        std::vector<Column> columns;
+    };
+
+    const Column& column_(size_t fieldIdx, size_t stepIdx) const
+    {
+        static const Column noColumn = { 0, 0 };
+
+        const Step& step = steps_.at(stepIdx);
+        if (fieldIdx >= fields_.size())
+            throw std::out_of_range("Invalid field index");
+        if (fieldIdx >= step.columns.size())
+            return noColumn;
+        return step.columns[fieldIdx];
+    }
+
+    template <class T>
+    T read_(size_t& pos) const
+    {
+        if (pos + sizeof(T) > size_)
+            throw std::runtime_error("Time series file '"+fileName_+"' is truncated");
+
+        T value;
+        std::memcpy(&value, data_ + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    void readIndex_()
+    {
+        if (size_ < TimeSeriesFormat::headerSize()
+            || std::memcmp(data_, TimeSeriesFormat::magic(), 8) != 0)
+            throw std::runtime_error("'"+fileName_+"' is not a time series file");
+
+        size_t pos = 8;
+        std::uint32_t version = read_<std::uint32_t>(pos);
+        std::uint32_t byteOrderMark = read_<std::uint32_t>(pos);
+        if (version != TimeSeriesFormat::version())
+            throw std::runtime_error("Unsupported version of the time series file '"+fileName_+"'");
+        if (byteOrderMark != TimeSeriesFormat::byteOrderMark())
+            throw std::runtime_error("The time series file '"+fileName_+"' was written on a "
+                                     "machine with a different byte order");
+
+        std::uint64_t numSteps = read_<std::uint64_t>(pos);
+        std::uint64_t recordOffset = read_<std::uint64_t>(pos);
+
+        // the records of the time steps form a list which starts at the last step
+        std::vector<std::uint64_t> recordOffsets(numSteps);
+        for (size_t i = 0; i < numSteps; ++i) {
+            if (recordOffset < TimeSeriesFormat::headerSize())
+                throw std::runtime_error("Invalid index in time series file '"+fileName_+"'");
+
+            recordOffsets[numSteps - 1 - i] = recordOffset;
+            pos = recordOffset + sizeof(std::uint64_t);
+            recordOffset = read_<std::uint64_t>(pos);
+        }
+
+        // read the records in chronological order so that the fields are numbered in
+        // the order of their first appearance
+        steps_.resize(numSteps);
+        for (size_t stepIdx = 0; stepIdx < numSteps; ++stepIdx) {
+            Step& step = steps_[stepIdx];
+            pos = recordOffsets[stepIdx];
+            std::uint64_t recordSize = read_<std::uint64_t>(pos);
+            read_<std::uint64_t>(pos); // offset of the previous record
+            step.time = read_<double>(pos);
+            step.recordOffset = recordOffsets[stepIdx];
+            step.endOffset = recordOffsets[stepIdx] + recordSize;
+
+            std::uint64_t numStepFields = read_<std::uint64_t>(pos);
+            for (size_t i = 0; i < numStepFields; ++i) {
+                Column col;
+                col.offset = read_<std::uint64_t>(pos);
+                col.numEntities = read_<std::uint64_t>(pos);
+                EntityKind kind = static_cast<EntityKind>(read_<std::uint32_t>(pos));
+                unsigned numComponents = read_<std::uint32_t>(pos);
+                std::uint32_t nameLength = read_<std::uint32_t>(pos);
+                if (pos + nameLength > size_)
+                    throw std::runtime_error("Time series file '"+fileName_+"' is truncated");
+                std::string name(data_ + pos, nameLength);
+                pos = TimeSeriesFormat::paddedSize(pos + nameLength);
+
+                if (col.offset + col.numEntities*numComponents*sizeof(double) > size_)
+                    throw std::runtime_error("Time series file '"+fileName_+"' is truncated");
+
+                size_t fieldIdx = fieldIndex_(name, kind, numComponents);
+                if (step.columns.size() <= fieldIdx)
+                    step.columns.resize(fieldIdx + 1, Column{0, 0});
+                step.columns[fieldIdx] = col;
+            }
+        }
+    }
+
+    // returns the index of a field. fields which have not been seen so far are added
+    size_t fieldIndex_(const std::string& name, EntityKind kind, unsigned numComponents)
+    {
+        auto it = fieldIndices_.find(name);
+        if (it != fieldIndices_.end()) {
+            const FieldInfo& info = fields_[it->second];
+            if (info.kind != kind || info.numComponents != numComponents)
+                throw std::runtime_error("Inconsistent definitions of field '"+name+"' in "
+                                         "time series file '"+fileName_+"'");
+            return it->second;
+        }
+
+        FieldInfo info;
+        info.name = name;
+        info.kind = kind;
+        info.numComponents = numComponents;
+        fields_.push_back(info);
+        fieldIndices_[name] = fields_.size() - 1;
+        return fields_.size() - 1;
+    }
+
+    void unmap_()
+    {
+        if (data_)
+            munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+    }
+
+    std::string fileName_;
+    const char* data_;
+    size_t size_;
+
+    std::vector<FieldInfo> fields_;
+    std::map<std::string, size_t> fieldIndices_;
+    std::vector<Step> steps_;
+};
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,397 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::TimeSeriesWriter
+ */
+#ifndef EWOMS_TIME_SERIES_WRITER_HH
+#define EWOMS_TIME_SERIES_WRITER_HH
+
+#include <ewoms/io/baseoutputwriter.hh>
+#include <ewoms/io/timeseriesreader.hh>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief Writes the fields of all time steps of a simulation into a single file per
+ *        process.
+ *
+ * Each field is stored as a column of double precision values, the layout of the file
+ * is described in Ewoms::TimeSeriesFormat. Use Ewoms::TimeSeriesReader to access the
+ * data.
+ *
+ * In contrast to the VTK writers, this writer does not store any geometry: vertex and
+ * element centered fields are stored in the order of the vertex and element mappers of
+ * the grid view.
+ */
+class TimeSeriesWriter : public BaseOutputWriter
+{
+    typedef TimeSeriesFormat::EntityKind EntityKind;
+
+    struct Column
+    {
+        std::string name;
+        EntityKind kind;
+        unsigned numComponents;
+        std::uint64_t numEntities;
+        std::uint64_t offset;
+    };
+
+public:
+    /*!
+     * \brief Create a writer.
+     *
+     * \param outputDir The directory to which the file is written
+     * \param simName The prefix of the file name
+     * \param commRank The rank of the current process
+     * \param commSize The number of processes of the simulation
+     */
+    TimeSeriesWriter(const std::string& outputDir,
+                     const std::string& simName,
+                     int commRank = 0,
+                     int commSize = 1)
+        : fileName_(fileName(outputDir, simName, commRank, commSize))
+        , numSteps_(0)
+        , lastRecordOffset_(0)
+        , dataEnd_(TimeSeriesFormat::headerSize())
+        , stepBegin_(0)
+        , curTime_(0.0)
+        , isWriting_(false)
+    { }
+
+    ~TimeSeriesWriter()
+    {
+        if (file_.is_open())
+            file_.close();
+    }
+
+    /*!
+     * \brief Returns the name of the file written by a given process.
+     */
+    static std::string fileName(const std::string& outputDir,
+                                const std::string& simName,
+                                int commRank,
+                                int commSize)
+    {
+        std::ostringstream oss;
+        oss << (outputDir.empty() ? std::string(".") : outputDir) << "/";
+        if (commSize > 1)
+            oss << "s" << std::setw(4) << std::setfill('0') << commSize << "-"
+                << "p" << std::setw(4) << std::setfill('0') << commRank << "-";
+        oss << (simName.empty() ? std::string("sim") : simName) << ".ets";
+        return oss.str();
+    }
+
+    /*!
+     * \brief Returns the name of the file written by the local process.
+     */
+    const std::string& fileName() const
+    { return fileName_; }
+
+    /*!
+     * \brief Returns the number of time steps which have been written so far.
+     */
+    size_t numTimeSteps() const
+    { return numSteps_; }
+
+    /*!
+     * \copydoc BaseOutputWriter::acceptsGridFields
+     */
+    bool acceptsGridFields() const override
+    { return true; }
+
+    /*!
+     * \brief Called whenever a new time step must be written.
+     */
+    void beginWrite(double t) override
+    {
+        if (!file_.is_open())
+            create_();
+
+        curTime_ = t;
+        columns_.clear();
+        stepBegin_ = dataEnd_;
+        isWriting_ = true;
+    }
+
+    /*!
+     * \brief Add a vertex centered scalar field to the output.
+     *
+     * The data is written immediately.
+     */
+    void attachScalarVertexData(ScalarBuffer& buf, std::string name) override
+    { writeColumn_(name, TimeSeriesFormat::VertexEntity, /*numComponents=*/1, buf.size(), buf.data()); }
+
+    /*!
+     * \brief Add an element centered scalar field to the output.
+     *
+     * The data is written immediately.
+     */
+    void attachScalarElementData(ScalarBuffer& buf, std::string name) override
+    { writeColumn_(name, TimeSeriesFormat::ElementEntity, /*numComponents=*/1, buf.size(), buf.data()); }
+
+    /*!
+     * \brief Add a vertex centered vector field to the output.
+     *
+     * The data is written immediately.
+     */
+    void attachVectorVertexData(VectorBuffer& buf, std::string name) override
+    { writeVectorColumn_(name, TimeSeriesFormat::VertexEntity, buf); }
+
+    /*!
+     * \brief Add an element centered vector field to the output.
+     *
+     * The data is written immediately.
+     */
+    void attachVectorElementData(VectorBuffer& buf, std::string name) override
+    { writeVectorColumn_(name, TimeSeriesFormat::ElementEntity, buf); }
+
+    /*!
+     * \brief Add a vertex centered tensor field to the output.
+     *
+     * The data is written immediately.
+     */
+    void attachTensorVertexData(TensorBuffer& buf, std::string name) override
+    { writeTensorColumn_(name, TimeSeriesFormat::VertexEntity, buf); }
+
+    /*!
+     * \brief Add an element centered tensor field to the output.
+     *
+     * The data is written immediately.
+     */
+    void attachTensorElementData(TensorBuffer& buf, std::string name) override
+    { writeTensorColumn_(name, TimeSeriesFormat::ElementEntity, buf); }
+
+    /*!
+     * \brief Finalizes the current time step.
+     *
+     * This writes the record which describes the columns of the time step and makes it
+     * visible to readers. If the onlyDiscard argument is true, the columns of the time
+     * step are discarded instead.
+     */
+    void endWrite(bool onlyDiscard = false) override
+    {
+        isWriting_ = false;
+        if (onlyDiscard) {
+            dataEnd_ = stepBegin_;
+            columns_.clear();
+            return;
+        }
+
+        // assemble the record for the time step
+        std::vector<char> record;
+        append_(record, std::uint64_t(0)); // size of the record, set below
+        append_(record, lastRecordOffset_);
+        append_(record, curTime_);
+        append_(record, std::uint64_t(columns_.size()));
+        for (const auto& col : columns_) {
+            append_(record, col.offset);
+            append_(record, col.numEntities);
+            append_(record, std::uint32_t(col.kind));
+            append_(record, std::uint32_t(col.numComponents));
+            append_(record, std::uint32_t(col.name.size()));
+            record.insert(record.end(), col.name.begin(), col.name.end());
+            record.resize(TimeSeriesFormat::paddedSize(record.size()), 0);
+        }
+        std::uint64_t recordSize = record.size();
+        std::memcpy(record.data(), &recordSize, sizeof(recordSize));
+
+        std::uint64_t recordOffset = dataEnd_;
+        file_.seekp(static_cast<std::streamoff>(recordOffset));
+        file_.write(record.data(), static_cast<std::streamsize>(record.size()));
+        dataEnd_ += record.size();
+
+        // the data and the record are in place: publish the time step
+        lastRecordOffset_ = recordOffset;
+        ++numSteps_;
+        writeHeader_();
+        file_.flush();
+
+        if (!file_.good())
+            throw std::runtime_error("Could not write time series file '"+fileName_+"'");
+
+        columns_.clear();
+    }
+
+    /*!
+     * \brief Write the writer's state to a restart file.
+     */
+    template <class Restarter>
+    void serialize(Restarter& res)
+    {
+        res.serializeSectionBegin("TimeSeriesWriter");
+        res.serializeStream() << numSteps_ << "\n";
+        res.serializeSectionEnd();
+    }
+
+    /*!
+     * \brief Read the writer's state from a restart file.
+     *
+     * This reopens the file of the previous run and discards all time steps which were
+     * written after the restart file.
+     */
+    template <class Restarter>
+    void deserialize(Restarter& res)
+    {
+        res.deserializeSectionBegin("TimeSeriesWriter");
+        size_t numSteps;
+        res.deserializeStream() >> numSteps;
+        std::string dummy;
+        std::getline(res.deserializeStream(), dummy);
+        res.deserializeSectionEnd();
+
+        if (file_.is_open())
+            file_.close();
+
+        if (numSteps == 0) {
+            create_();
+            return;
+        }
+
+        // continue directly after the record of the last time step which is kept
+        TimeSeriesReader reader(fileName_);
+        if (reader.numTimeSteps() < numSteps)
+            throw std::runtime_error("The time series file '"+fileName_+"' contains fewer "
+                                     "time steps than expected by the restart file");
+        numSteps_ = numSteps;
+        lastRecordOffset_ = reader.recordOffset(numSteps - 1);
+        dataEnd_ = reader.stepEndOffset(numSteps - 1);
+
+        file_.open(fileName_.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        if (!file_.is_open())
+            throw std::runtime_error("Could not open time series file '"+fileName_+"'");
+        writeHeader_();
+        file_.flush();
+    }
+
+private:
+    template <class T>
+    static void append_(std::vector<char>& buf, const T& value)
+    {
+        const char* begin = reinterpret_cast<const char*>(&value);
+        buf.insert(buf.end(), begin, begin + sizeof(T));
+    }
+
+    void create_()
+    {
+        // create an empty file and open it for reading and writing, which is required
+        // to update the header
+        { std::ofstream tmp(fileName_.c_str(), std::ios::binary | std::ios::trunc); }
+        file_.open(fileName_.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        if (!file_.is_open())
+            throw std::runtime_error("Could not create time series file '"+fileName_+"'");
+
+        numSteps_ = 0;
+        lastRecordOffset_ = 0;
+        dataEnd_ = TimeSeriesFormat::headerSize();
+        writeHeader_();
+    }
+
+    void writeHeader_()
+    {
+        std::vector<char> header;
+        header.insert(header.end(), TimeSeriesFormat::magic(), TimeSeriesFormat::magic() + 8);
+        append_(header, TimeSeriesFormat::version());
+        append_(header, TimeSeriesFormat::byteOrderMark());
+        append_(header, std::uint64_t(numSteps_));
+        append_(header, lastRecordOffset_);
+        header.resize(TimeSeriesFormat::headerSize(), 0);
+
+        file_.seekp(0);
+        file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    }
+
+    void writeColumn_(const std::string& name,
+                      EntityKind kind,
+                      unsigned numComponents,
+                      size_t numEntities,
+                      const double* values)
+    {
+        if (!isWriting_)
+            throw std::logic_error("TimeSeriesWriter: Fields can only be attached between "
+                                   "beginWrite() and endWrite()");
+
+        Column col;
+        col.name = name;
+        col.kind = kind;
+        col.numComponents = numComponents;
+        col.numEntities = numEntities;
+        col.offset = dataEnd_;
+        columns_.push_back(col);
+
+        size_t numBytes = numEntities*numComponents*sizeof(double);
+        file_.seekp(static_cast<std::streamoff>(dataEnd_));
+        file_.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(numBytes));
+        dataEnd_ += numBytes;
+    }
+
+    void writeVectorColumn_(const std::string& name, EntityKind kind, const VectorBuffer& buf)
+    {
+        unsigned numComponents = buf.empty() ? 1 : static_cast<unsigned>(buf[0].size());
+        flatBuffer_.resize(buf.size()*numComponents);
+        for (size_t i = 0; i < buf.size(); ++i)
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                flatBuffer_[i*numComponents + compIdx] = buf[i][compIdx];
+
+        writeColumn_(name, kind, numComponents, buf.size(), flatBuffer_.data());
+    }
+
+    void writeTensorColumn_(const std::string& name, EntityKind kind, const TensorBuffer& buf)
+    {
+        unsigned numRows = buf.empty() ? 1 : static_cast<unsigned>(buf[0].N());
+        unsigned numCols = buf.empty() ? 1 : static_cast<unsigned>(buf[0].M());
+        unsigned numComponents = numRows*numCols;
+        flatBuffer_.resize(buf.size()*numComponents);
+        for (size_t i = 0; i < buf.size(); ++i)
+            for (unsigned rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                for (unsigned colIdx = 0; colIdx < numCols; ++colIdx)
+                    flatBuffer_[i*numComponents + rowIdx*numCols + colIdx] = buf[i][rowIdx][colIdx];
+
+        writeColumn_(name, kind, numComponents, buf.size(), flatBuffer_.data());
+    }
+
+    std::string fileName_;
+    std::fstream file_;
+
+    size_t numSteps_;
+    std::uint64_t lastRecordOffset_;
+    std::uint64_t dataEnd_;
+    std::uint64_t stepBegin_;
+
+    double curTime_;
+    bool isWriting_;
+    std::vector<Column> columns_;
+    std::vector<double> flatBuffer_;
+};
+} // namespace Ewoms
+
+#endif
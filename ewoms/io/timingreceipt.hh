@@ -0,0 +1,240 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::TimingReceipt
+ */
+#ifndef EWOMS_TIMING_RECEIPT_HH
+#define EWOMS_TIMING_RECEIPT_HH
+
+#include <ewoms/parallel/loadimbalancereport.hh>
+#include <ewoms/common/perfcounters.hh>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief The figures of the timing receipt printed at the end of a simulation in a
+ *        machine-readable form.
+ *
+ * All times are wall clock times in seconds unless stated otherwise. The receipt can be
+ * written as a single JSON object, which allows scripts to evaluate the performance of
+ * a simulation without having to parse its human-readable output.
+ */
+struct TimingReceipt
+{
+    std::string problemName;
+
+    unsigned numProcesses = 1;
+    unsigned threadsPerProcess = 1;
+    unsigned numTimeSteps = 0;
+    unsigned long numDof = 0;
+
+    //! The number of times the time step size was cut
+    unsigned long numTimeStepCuts = 0;
+    //! The number of Newton iterations of the accepted time steps
+    unsigned long numNewtonIterations = 0;
+    //! The number of Newton iterations of the failed attempts of time integrations
+    unsigned long numFailedNewtonIterations = 0;
+    //! The number of iterations of the linear solver
+    unsigned long numLinearIterations = 0;
+    //! The estimated number of linear iterations saved by the adaptive linear tolerance
+    double numSavedLinearIterations = 0.0;
+
+    double setupTime = 0.0;
+    double executionTime = 0.0;
+    double linearizeTime = 0.0;
+    double solveTime = 0.0;
+    double linearSolverSetupTime = 0.0;
+    double linearSolverIterationTime = 0.0;
+    double overlapSyncTime = 0.0;
+    double updateTime = 0.0;
+    double prePostProcessTime = 0.0;
+    double writeTime = 0.0;
+
+    //! The CPU time of the first process
+    double localCpuTime = 0.0;
+
+    //! The CPU time of all processes
+    double globalCpuTime = 0.0;
+
+    //! The number of bytes written by the VTK output
+    double outputBytes = 0.0;
+
+    //! The time spent encoding and writing the VTK output
+    double outputIoTime = 0.0;
+
+    //! The distribution of the solver phases across the processes
+    LoadImbalanceReport loadImbalance;
+
+    //! The hardware performance counters of the first process (empty if not enabled)
+    std::vector<PerfCounters::RegionStatistics> perfCounters;
+
+    //! The peak resident set size of each process [bytes]
+    std::vector<double> peakRss;
+
+    /*!
+     * \brief Returns the maximum of the peak resident set sizes of all processes.
+     */
+    double maxPeakRss() const
+    {
+        double result = 0.0;
+        for (double value : peakRss)
+            result = std::max(result, value);
+        return result;
+    }
+
+    /*!
+     * \brief Returns the average of the peak resident set sizes of all processes.
+     */
+    double avgPeakRss() const
+    {
+        if (peakRss.empty())
+            return 0.0;
+
+        double result = 0.0;
+        for (double value : peakRss)
+            result += value;
+        return result/peakRss.size();
+    }
+
+    /*!
+     * \brief Returns the time which is not attributed to any of the phases.
+     */
+    double overheadTime() const
+    {
+        return executionTime
+            - (linearizeTime + solveTime + updateTime + prePostProcessTime + writeTime);
+    }
+
+    /*!
+     * \brief Write the members of the receipt as JSON name/value pairs.
+     *
+     * The pairs are separated by commas, but they are not enclosed by braces. This
+     * allows to embed them into objects which contain additional members.
+     */
+    void writeJsonMembers(std::ostream& os) const
+    {
+        os << std::setprecision(std::numeric_limits<double>::digits10 + 1)
+           << "\"problem\": \"" << problemName << "\""
+           << ", \"numProcesses\": " << numProcesses
+           << ", \"threadsPerProcess\": " << threadsPerProcess
+           << ", \"numTimeSteps\": " << numTimeSteps
+           << ", \"numDof\": " << numDof
+           << ", \"numTimeStepCuts\": " << numTimeStepCuts
+           << ", \"numNewtonIterations\": " << numNewtonIterations
+           << ", \"numFailedNewtonIterations\": " << numFailedNewtonIterations
+           << ", \"numLinearIterations\": " << numLinearIterations
+           << ", \"numSavedLinearIterations\": " << numSavedLinearIterations
+           << ", \"setupTime\": " << setupTime
+           << ", \"executionTime\": " << executionTime
+           << ", \"linearizeTime\": " << linearizeTime
+           << ", \"solveTime\": " << solveTime
+           << ", \"linearSolverSetupTime\": " << linearSolverSetupTime
+           << ", \"linearSolverIterationTime\": " << linearSolverIterationTime
+           << ", \"overlapSyncTime\": " << overlapSyncTime
+           << ", \"updateTime\": " << updateTime
+           << ", \"prePostProcessTime\": " << prePostProcessTime
+           << ", \"writeTime\": " << writeTime
+           << ", \"overheadTime\": " << overheadTime()
+           << ", \"localCpuTime\": " << localCpuTime
+           << ", \"globalCpuTime\": " << globalCpuTime
+           << ", \"outputBytes\": " << outputBytes
+           << ", \"outputIoTime\": " << outputIoTime;
+
+        os << ", \"peakRss\": [";
+        for (size_t i = 0; i < peakRss.size(); ++i)
+            os << ((i > 0) ? ", " : "") << peakRss[i];
+        os << "]";
+
+        os << ", \"loadImbalance\": {";
+        const auto& stats = loadImbalance.statistics();
+        for (size_t i = 0; i < stats.size(); ++i) {
+            if (i > 0)
+                os << ", ";
+            // the phase names are indented in the human-readable report
+            std::string name = stats[i].name;
+            name.erase(0, name.find_first_not_of(' '));
+            os << "\"" << name << "\": {"
+               << "\"min\": " << stats[i].min
+               << ", \"avg\": " << stats[i].avg
+               << ", \"max\": " << stats[i].max
+               << ", \"imbalance\": " << stats[i].imbalance()
+               << "}";
+        }
+        os << "}";
+
+        if (!perfCounters.empty()) {
+            os << ", \"perfCounters\": {";
+            for (size_t i = 0; i < perfCounters.size(); ++i) {
+                const auto& stats = perfCounters[i];
+                if (i > 0)
+                    os << ", ";
+                os << "\"" << stats.name << "\": {"
+                   << "\"numCalls\": " << stats.numCalls
+                   << ", \"time\": " << stats.realTime
+                   << ", \"cycles\": " << stats.counts[PerfCounters::cyclesEvent]
+                   << ", \"instructions\": " << stats.counts[PerfCounters::instructionsEvent]
+                   << ", \"llcMisses\": " << stats.counts[PerfCounters::llcMissesEvent]
+                   << ", \"ipc\": " << stats.ipc()
+                   << ", \"dramBytes\": " << stats.dramBytes()
+                   << ", \"dramBandwidth\": " << stats.dramBandwidth()
+                   << ", \"bytesPerDof\": " << stats.bytesPerDof(numDof/numProcesses)
+                   << "}";
+            }
+            os << "}";
+        }
+    }
+
+    /*!
+     * \brief Write the receipt as a JSON object.
+     */
+    void writeJson(std::ostream& os) const
+    {
+        os << "{";
+        writeJsonMembers(os);
+        os << "}\n";
+    }
+
+    /*!
+     * \brief Write the receipt as a JSON object to a file.
+     */
+    void writeJson(const std::string& fileName) const
+    {
+        std::ofstream os(fileName);
+        if (!os)
+            throw std::runtime_error("Could not open file '"+fileName+"' for writing the timing receipt");
+        writeJson(os);
+    }
+};
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,941 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::VtkAppendedRawWriter
+ */
+#ifndef EWOMS_VTK_APPENDED_RAW_WRITER_HH
+#define EWOMS_VTK_APPENDED_RAW_WRITER_HH
+
+#include <ewoms/io/baseoutputwriter.hh>
+#include <ewoms/io/outputbufferlimiter.hh>
+#include <ewoms/io/vtkfilenames.hh>
+#include <ewoms/parallel/tasklets.hh>
+#include <ewoms/common/timer.hh>
+
+#include <dune/common/version.hh>
+#include <dune/grid/common/mcmgmapper.hh>
+#include <dune/grid/common/gridenums.hh>
+#include <dune/grid/io/file/vtk/common.hh>
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief Writes VTK unstructured grid files which store the data of all fields in a
+ *        single appended section of raw binary data.
+ *
+ * Compared to the formats supported by Dune::VTKWriter, this avoids the overhead of
+ * ASCII and base64 encoding. If eWoms was compiled with zlib support, each data array
+ * can optionally be compressed using the block format of VTK's vtkZLibDataCompressor
+ * and the arrays are compressed concurrently by a configurable number of threads.
+ *
+ * The values of all attached buffers are copied (and converted to single precision)
+ * when they are attached. Besides making writing the data asynchronously trivial, this
+ * means that no MPI communication is required for writing a time step: the meta file
+ * for parallel runs (.pvtu) is written by the first process because the names of the
+ * pieces of the other processes are known in advance.
+ *
+ * Like the VtkMultiWriter, this class keeps a .pvd file for the complete simulation up
+ * to date.
+ */
+template <class GridView>
+class VtkAppendedRawWriter : public BaseOutputWriter
+{
+    enum { dim = GridView::dimension };
+    enum { dimWorld = GridView::dimensionworld };
+
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView> VertexMapper;
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView> ElementMapper;
+#else
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView, Dune::MCMGElementLayout> ElementMapper;
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView, Dune::MCMGVertexLayout> VertexMapper;
+#endif
+
+    // a single data array of a VTU file
+    struct DataArray
+    {
+        std::string name;
+        std::string type;
+        unsigned numComponents;
+
+        // the values of the array in the native byte order
+        std::vector<char> rawData;
+
+        // the data as it is written to the appended section of the file, i.e., including
+        // the header and potentially compressed
+        std::vector<char> encodedData;
+    };
+    typedef std::shared_ptr<DataArray> DataArrayPtr;
+
+    // the geometry of the process' part of the grid. objects of this class are shared
+    // between the writer and the write tasklets and are not modified after they were
+    // created (except for encoding the arrays, which is only done by the thread which
+    // does the writing).
+    struct Geometry
+    {
+        size_t numPoints;
+        size_t numCells;
+
+        // the element indices of the written cells in the order they are written
+        std::vector<unsigned> cellElementIndices;
+
+        DataArrayPtr points;
+        DataArrayPtr connectivity;
+        DataArrayPtr offsets;
+        DataArrayPtr types;
+
+        bool isEncoded;
+    };
+    typedef std::shared_ptr<Geometry> GeometryPtr;
+
+    // everything which is required to write a single time step
+    struct TimeStepData
+    {
+        double time;
+        int writerNum;
+        GeometryPtr geometry;
+        std::vector<DataArrayPtr> pointData;
+        std::vector<DataArrayPtr> cellData;
+
+        // the memory occupied by the field data
+        size_t numBytes;
+    };
+    typedef std::shared_ptr<TimeStepData> TimeStepDataPtr;
+
+    class EncodeArrayTasklet : public TaskletInterface
+    {
+    public:
+        EncodeArrayTasklet(DataArray& array, int compressionLevel)
+            : array_(array)
+            , compressionLevel_(compressionLevel)
+        { }
+
+        void run() final
+        { VtkAppendedRawWriter::encode_(array_, compressionLevel_); }
+
+    private:
+        DataArray& array_;
+        int compressionLevel_;
+    };
+
+    class WriteDataTasklet : public TaskletInterface
+    {
+    public:
+        WriteDataTasklet(VtkAppendedRawWriter& writer, TimeStepDataPtr data)
+            : writer_(writer)
+            , data_(data)
+        { }
+
+        void run() final
+        {
+            writer_.writeTimeStep_(*data_);
+
+            // free the buffers before a new time step may be started
+            size_t numBytes = data_->numBytes;
+            data_.reset();
+            writer_.bufferLimiter_.release(numBytes);
+        }
+
+    private:
+        VtkAppendedRawWriter& writer_;
+        TimeStepDataPtr data_;
+    };
+
+public:
+    typedef BaseOutputWriter::Scalar Scalar;
+    typedef BaseOutputWriter::Vector Vector;
+    typedef BaseOutputWriter::Tensor Tensor;
+    typedef BaseOutputWriter::ScalarBuffer ScalarBuffer;
+    typedef BaseOutputWriter::VectorBuffer VectorBuffer;
+    typedef BaseOutputWriter::TensorBuffer TensorBuffer;
+
+    /*!
+     * \brief Create a writer.
+     *
+     * \param asyncWriting Write the files using a separate thread
+     * \param gridView The grid view for which the output is written
+     * \param outputDir The directory to which the files are written
+     * \param simName The prefix of the written files
+     * \param multiFileName The name of the .pvd file (default: $outputDir/$simName.pvd)
+     * \param compressionLevel The zlib compression level for the data arrays. 0 means
+     *                         that the data is not compressed
+     * \param numCompressionThreads The number of threads used to compress the arrays
+     * \param numBufferSets The maximum number of time steps for which the data may be
+     *                      kept in memory at the same time (see OutputBufferLimiter)
+     * \param maxBufferBytes The maximum number of bytes which may be occupied by the
+     *                       data of the time steps which wait to be written
+     */
+    VtkAppendedRawWriter(bool asyncWriting,
+                         const GridView& gridView,
+                         const std::string& outputDir,
+                         const std::string& simName = "",
+                         std::string multiFileName = "",
+                         int compressionLevel = 0,
+                         unsigned numCompressionThreads = 1,
+                         unsigned numBufferSets = 2,
+                         size_t maxBufferBytes = std::numeric_limits<size_t>::max())
+        : gridView_(gridView)
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+        , elementMapper_(gridView, Dune::mcmgElementLayout())
+        , vertexMapper_(gridView, Dune::mcmgVertexLayout())
+#else
+        , elementMapper_(gridView)
+        , vertexMapper_(gridView)
+#endif
+        , compressionLevel_(std::max(0, std::min(9, compressionLevel)))
+        , curWriterNum_(0)
+        , numBytesWritten_(0)
+        , bufferLimiter_(numBufferSets, maxBufferBytes)
+        , taskletRunner_(/*numThreads=*/asyncWriting?1:0)
+        , compressionRunner_(/*numThreads=*/(numCompressionThreads > 1)?numCompressionThreads:0)
+    {
+        outputDir_ = outputDir;
+        if (outputDir == "")
+            outputDir_ = ".";
+
+        simName_ = (simName.empty()) ? "sim" : simName;
+        multiFileName_ = multiFileName;
+        if (multiFileName_.empty())
+            multiFileName_ = outputDir_+"/"+simName_+".pvd";
+
+        commRank_ = gridView.comm().rank();
+        commSize_ = gridView.comm().size();
+
+#if !HAVE_ZLIB
+        if (compressionLevel_ > 0) {
+            if (commRank_ == 0)
+                std::cerr << "Warning: eWoms was compiled without zlib support. "
+                          << "VTK output will not be compressed.\n";
+            compressionLevel_ = 0;
+        }
+#endif
+    }
+
+    ~VtkAppendedRawWriter()
+    {
+        taskletRunner_.barrier();
+
+        if (commRank_ == 0 && multiFile_.is_open())
+            multiFile_.close();
+    }
+
+    /*!
+     * \brief Returns the number of the current VTK file.
+     */
+    int curWriterNum() const
+    { return curWriterNum_; }
+
+    /*!
+     * \brief Updates the internal data structures after mesh
+     *        refinement.
+     *
+     * If the grid changes between two calls of beginWrite(), this
+     * method _must_ be called before the second beginWrite()!
+     */
+    void gridChanged()
+    {
+        elementMapper_.update();
+        vertexMapper_.update();
+
+        // the geometry is still referenced by the pending write tasklets, so we only
+        // drop our reference to it.
+        geometry_.reset();
+    }
+
+    /*!
+     * \brief Wait until all data which was passed to the writer has been written to
+     *        disk.
+     */
+    void flush()
+    { taskletRunner_.barrier(); }
+
+    /*!
+     * \brief Returns the number of bytes which were written to disk by the local
+     *        process so far.
+     *
+     * To get accurate results, flush() must have been called before.
+     */
+    size_t numBytesWritten() const
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        return numBytesWritten_;
+    }
+
+    /*!
+     * \brief Returns the timer which measures the time spent on encoding and writing
+     *        the files.
+     *
+     * To get accurate results, flush() must have been called before.
+     */
+    Timer ioTimer() const
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        return ioTimer_;
+    }
+
+    /*!
+     * \brief Returns the maximum memory which was occupied by the buffers of the
+     *        output at the same time [bytes].
+     */
+    size_t peakBufferBytes() const
+    { return bufferLimiter_.peakPendingBytes(); }
+
+    /*!
+     * \copydoc BaseOutputWriter::acceptsGridFields
+     */
+    bool acceptsGridFields() const final
+    { return true; }
+
+    /*!
+     * \brief Called whenever a new time step must be written.
+     *
+     * This method only blocks if the data of too many time steps waits to be written.
+     */
+    void beginWrite(double t) final
+    {
+        bufferLimiter_.waitForFreeSlot();
+
+        if (!geometry_)
+            updateGeometry_();
+
+        curData_ = std::make_shared<TimeStepData>();
+        curData_->time = t;
+        curData_->writerNum = curWriterNum_;
+        curData_->geometry = geometry_;
+        curData_->numBytes = 0;
+
+        ++curWriterNum_;
+    }
+
+    /*!
+     * \brief Add a vertex centered scalar field to the output.
+     *
+     * The values are copied, i.e., the buffer may be modified or deleted as soon as
+     * this method returns.
+     */
+    void attachScalarVertexData(ScalarBuffer& buf, std::string name) final
+    {
+        assert(buf.size() == vertexMapper_.size());
+
+        std::vector<float> values(buf.size());
+        for (size_t i = 0; i < buf.size(); ++i)
+            values[i] = static_cast<float>(buf[i]);
+
+        curData_->pointData.push_back(makeArray_(name, "Float32", /*numComponents=*/1, values));
+    }
+
+    /*!
+     * \brief Add an element centered scalar quantity to the output.
+     *
+     * The values are copied, i.e., the buffer may be modified or deleted as soon as
+     * this method returns.
+     */
+    void attachScalarElementData(ScalarBuffer& buf, std::string name) final
+    {
+        assert(buf.size() == elementMapper_.size());
+
+        const auto& cellElementIndices = geometry_->cellElementIndices;
+        std::vector<float> values(cellElementIndices.size());
+        for (size_t i = 0; i < cellElementIndices.size(); ++i)
+            values[i] = static_cast<float>(buf[cellElementIndices[i]]);
+
+        curData_->cellData.push_back(makeArray_(name, "Float32", /*numComponents=*/1, values));
+    }
+
+    /*!
+     * \brief Add a vertex centered vector field to the output.
+     *
+     * The values are copied, i.e., the buffer may be modified or deleted as soon as
+     * this method returns.
+     */
+    void attachVectorVertexData(VectorBuffer& buf, std::string name) final
+    {
+        assert(buf.size() == vertexMapper_.size());
+
+        unsigned numComponents = buf.empty() ? 1 : static_cast<unsigned>(buf[0].size());
+        unsigned numVtkComponents = vtkNumComponents_(numComponents);
+        std::vector<float> values(buf.size()*numVtkComponents, 0.0);
+        for (size_t i = 0; i < buf.size(); ++i)
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                values[i*numVtkComponents + compIdx] = static_cast<float>(buf[i][compIdx]);
+
+        curData_->pointData.push_back(makeArray_(name, "Float32", numVtkComponents, values));
+    }
+
+    /*!
+     * \brief Add an element centered vector quantity to the output.
+     *
+     * The values are copied, i.e., the buffer may be modified or deleted as soon as
+     * this method returns.
+     */
+    void attachVectorElementData(VectorBuffer& buf, std::string name) final
+    {
+        assert(buf.size() == elementMapper_.size());
+
+        const auto& cellElementIndices = geometry_->cellElementIndices;
+        unsigned numComponents = buf.empty() ? 1 : static_cast<unsigned>(buf[0].size());
+        unsigned numVtkComponents = vtkNumComponents_(numComponents);
+        std::vector<float> values(cellElementIndices.size()*numVtkComponents, 0.0);
+        for (size_t i = 0; i < cellElementIndices.size(); ++i) {
+            const auto& value = buf[cellElementIndices[i]];
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                values[i*numVtkComponents + compIdx] = static_cast<float>(value[compIdx]);
+        }
+
+        curData_->cellData.push_back(makeArray_(name, "Float32", numVtkComponents, values));
+    }
+
+    /*!
+     * \brief Add a vertex centered tensor field to the output.
+     *
+     * Each column of the tensors is written as a separate vector field.
+     */
+    void attachTensorVertexData(TensorBuffer& buf, std::string name) final
+    {
+        assert(buf.size() == vertexMapper_.size());
+        if (buf.empty())
+            return;
+
+        unsigned numRows = static_cast<unsigned>(buf[0].N());
+        unsigned numVtkComponents = vtkNumComponents_(numRows);
+        for (unsigned colIdx = 0; colIdx < buf[0].M(); ++colIdx) {
+            std::vector<float> values(buf.size()*numVtkComponents, 0.0);
+            for (size_t i = 0; i < buf.size(); ++i)
+                for (unsigned rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                    values[i*numVtkComponents + rowIdx] = static_cast<float>(buf[i][rowIdx][colIdx]);
+
+            std::ostringstream oss;
+            oss << name <<  "[" << colIdx << "]";
+            curData_->pointData.push_back(makeArray_(oss.str(), "Float32", numVtkComponents, values));
+        }
+    }
+
+    /*!
+     * \brief Add an element centered tensor field to the output.
+     *
+     * Each column of the tensors is written as a separate vector field.
+     */
+    void attachTensorElementData(TensorBuffer& buf, std::string name) final
+    {
+        assert(buf.size() == elementMapper_.size());
+        if (buf.empty())
+            return;
+
+        const auto& cellElementIndices = geometry_->cellElementIndices;
+        unsigned numRows = static_cast<unsigned>(buf[0].N());
+        unsigned numVtkComponents = vtkNumComponents_(numRows);
+        for (unsigned colIdx = 0; colIdx < buf[0].M(); ++colIdx) {
+            std::vector<float> values(cellElementIndices.size()*numVtkComponents, 0.0);
+            for (size_t i = 0; i < cellElementIndices.size(); ++i) {
+                const auto& value = buf[cellElementIndices[i]];
+                for (unsigned rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                    values[i*numVtkComponents + rowIdx] = static_cast<float>(value[rowIdx][colIdx]);
+            }
+
+            std::ostringstream oss;
+            oss << name <<  "[" << colIdx << "]";
+            curData_->cellData.push_back(makeArray_(oss.str(), "Float32", numVtkComponents, values));
+        }
+    }
+
+    /*!
+     * \brief Finalizes the current time step.
+     *
+     * This means that everything will be written to disk, except if
+     * the onlyDiscard argument is true. In this case the attached data is
+     * discarded without writing anything.
+     */
+    void endWrite(bool onlyDiscard = false) final
+    {
+        if (!onlyDiscard) {
+            for (const auto& array : curData_->pointData)
+                curData_->numBytes += array->rawData.size();
+            for (const auto& array : curData_->cellData)
+                curData_->numBytes += array->rawData.size();
+
+            bufferLimiter_.acquire(curData_->numBytes);
+            auto tasklet = std::make_shared<WriteDataTasklet>(*this, curData_);
+            taskletRunner_.dispatch(tasklet);
+        }
+        else
+            --curWriterNum_;
+
+        curData_.reset();
+    }
+
+    /*!
+     * \brief Write the writer's state to a restart file.
+     */
+    template <class Restarter>
+    void serialize(Restarter& res)
+    {
+        // make sure that the meta file is not modified behind our back
+        taskletRunner_.barrier();
+
+        res.serializeSectionBegin("VtkAppendedRawWriter");
+        res.serializeStream() << curWriterNum_ << "\n";
+
+        if (commRank_ == 0) {
+            std::streamsize fileLen = 0;
+            std::streamoff filePos = 0;
+            if (multiFile_.is_open()) {
+                // write the meta file into the restart file
+                filePos = multiFile_.tellp();
+                multiFile_.seekp(0, std::ios::end);
+                fileLen = multiFile_.tellp();
+                multiFile_.seekp(filePos);
+            }
+
+            res.serializeStream() << fileLen << "  " << filePos << "\n";
+
+            if (fileLen > 0) {
+                std::ifstream multiFileIn(multiFileName_.c_str());
+                std::vector<char> tmp(static_cast<size_t>(fileLen));
+                multiFileIn.read(tmp.data(), fileLen);
+                res.serializeStream().write(tmp.data(), fileLen);
+            }
+        }
+
+        res.serializeSectionEnd();
+    }
+
+    /*!
+     * \brief Read the writer's state from a restart file.
+     */
+    template <class Restarter>
+    void deserialize(Restarter& res)
+    {
+        taskletRunner_.barrier();
+
+        res.deserializeSectionBegin("VtkAppendedRawWriter");
+        res.deserializeStream() >> curWriterNum_;
+
+        if (commRank_ == 0) {
+            std::string dummy;
+            std::getline(res.deserializeStream(), dummy);
+
+            // recreate the meta file from the restart file
+            std::streamoff filePos;
+            std::streamsize fileLen;
+            res.deserializeStream() >> fileLen >> filePos;
+            std::getline(res.deserializeStream(), dummy);
+            if (multiFile_.is_open())
+                multiFile_.close();
+
+            if (fileLen > 0) {
+                multiFile_.open(multiFileName_.c_str());
+
+                std::vector<char> tmp(static_cast<size_t>(fileLen));
+                res.deserializeStream().read(tmp.data(), fileLen);
+                multiFile_.write(tmp.data(), fileLen);
+            }
+
+            multiFile_.seekp(filePos);
+        }
+        else {
+            std::string tmp;
+            std::getline(res.deserializeStream(), tmp);
+        }
+        res.deserializeSectionEnd();
+    }
+
+private:
+    // Dune::VTKWriter writes two-dimensional vectors as three-dimensional ones. This
+    // is required by some post processing tools, so we do the same.
+    static unsigned vtkNumComponents_(unsigned numComponents)
+    { return (numComponents > 1 && numComponents < 3) ? 3 : numComponents; }
+
+    static const char* byteOrder_()
+    {
+        const std::uint16_t probe = 1;
+        return (*reinterpret_cast<const unsigned char*>(&probe) == 1) ? "LittleEndian" : "BigEndian";
+    }
+
+    template <class T>
+    static DataArrayPtr makeArray_(const std::string& name,
+                                   const std::string& type,
+                                   unsigned numComponents,
+                                   const std::vector<T>& values)
+    {
+        auto array = std::make_shared<DataArray>();
+        array->name = name;
+        array->type = type;
+        array->numComponents = numComponents;
+
+        const char* begin = reinterpret_cast<const char*>(values.data());
+        array->rawData.assign(begin, begin + values.size()*sizeof(T));
+
+        return array;
+    }
+
+    static void appendBytes_(std::vector<char>& dest, const void* src, size_t numBytes)
+    {
+        const char* begin = reinterpret_cast<const char*>(src);
+        dest.insert(dest.end(), begin, begin + numBytes);
+    }
+
+    // convert the raw data of an array to the representation which is written to the
+    // appended data section of the file
+    static void encode_(DataArray& array, int compressionLevel)
+    {
+        const std::vector<char>& raw = array.rawData;
+        std::vector<char>& encoded = array.encodedData;
+        std::uint64_t numBytes = raw.size();
+
+        encoded.clear();
+
+#if HAVE_ZLIB
+        if (compressionLevel > 0) {
+            // use the block format of vtkZLibDataCompressor: the header consists of the
+            // number of blocks, the uncompressed size of a block, the uncompressed size
+            // of the last block if it is partial (else 0) and the compressed size of
+            // each block. the block size is the same as the one used by VTK.
+            const std::uint64_t blockSize = 32*1024;
+            std::uint64_t numBlocks = (numBytes + blockSize - 1)/blockSize;
+
+            std::vector<std::uint64_t> header(3 + numBlocks);
+            header[0] = numBlocks;
+            header[1] = blockSize;
+            header[2] = numBytes % blockSize;
+
+            std::vector<char> compressedData;
+            std::vector<Bytef> blockBuffer(compressBound(static_cast<uLong>(blockSize)));
+            for (std::uint64_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx) {
+                std::uint64_t offset = blockIdx*blockSize;
+                uLong srcLen = static_cast<uLong>(std::min(blockSize, numBytes - offset));
+                uLongf destLen = static_cast<uLongf>(blockBuffer.size());
+                int ret = compress2(blockBuffer.data(),
+                                    &destLen,
+                                    reinterpret_cast<const Bytef*>(raw.data() + offset),
+                                    srcLen,
+                                    compressionLevel);
+                if (ret != Z_OK)
+                    throw std::runtime_error("Compressing the VTK data array '"+array.name+"' failed");
+
+                header[3 + blockIdx] = destLen;
+                appendBytes_(compressedData, blockBuffer.data(), destLen);
+            }
+
+            encoded.reserve(header.size()*sizeof(std::uint64_t) + compressedData.size());
+            appendBytes_(encoded, header.data(), header.size()*sizeof(std::uint64_t));
+            encoded.insert(encoded.end(), compressedData.begin(), compressedData.end());
+            return;
+        }
+#endif
+
+        encoded.reserve(sizeof(numBytes) + raw.size());
+        appendBytes_(encoded, &numBytes, sizeof(numBytes));
+        encoded.insert(encoded.end(), raw.begin(), raw.end());
+    }
+
+    // extract the local part of the grid in a form which can directly be written to
+    // the VTU file
+    void updateGeometry_()
+    {
+        auto geom = std::make_shared<Geometry>();
+        geom->isEncoded = false;
+
+        // all vertices of the grid view. vertices which are not used by any interior
+        // element are not a problem for VTK.
+        geom->numPoints = vertexMapper_.size();
+        std::vector<float> coords(3*geom->numPoints, 0.0);
+        auto vIt = gridView_.template begin<dim>();
+        const auto& vEndIt = gridView_.template end<dim>();
+        for (; vIt != vEndIt; ++vIt) {
+            size_t vertexIdx = static_cast<size_t>(vertexMapper_.index(*vIt));
+            const auto& pos = vIt->geometry().corner(0);
+            for (unsigned k = 0; k < dimWorld; ++k)
+                coords[3*vertexIdx + k] = static_cast<float>(pos[k]);
+        }
+
+        // the interior elements
+        std::vector<std::int32_t> connectivity;
+        std::vector<std::int32_t> offsets;
+        std::vector<std::uint8_t> types;
+        auto elemIt = gridView_.template begin</*codim=*/0, Dune::Interior_Partition>();
+        const auto& elemEndIt = gridView_.template end</*codim=*/0, Dune::Interior_Partition>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const auto& elem = *elemIt;
+            const Dune::GeometryType& geomType = elem.type();
+
+            geom->cellElementIndices.push_back(static_cast<unsigned>(elementMapper_.index(elem)));
+
+            int numCorners = static_cast<int>(elem.subEntities(dim));
+            for (int cornerIdx = 0; cornerIdx < numCorners; ++cornerIdx) {
+                int duneCornerIdx = Dune::VTK::renumber(geomType, cornerIdx);
+                connectivity.push_back(static_cast<std::int32_t>(vertexMapper_.subIndex(elem, duneCornerIdx, dim)));
+            }
+            offsets.push_back(static_cast<std::int32_t>(connectivity.size()));
+            types.push_back(static_cast<std::uint8_t>(Dune::VTK::geometryType(geomType)));
+        }
+        geom->numCells = types.size();
+
+        geom->points = makeArray_("Coordinates", "Float32", /*numComponents=*/3, coords);
+        geom->connectivity = makeArray_("connectivity", "Int32", /*numComponents=*/1, connectivity);
+        geom->offsets = makeArray_("offsets", "Int32", /*numComponents=*/1, offsets);
+        geom->types = makeArray_("types", "UInt8", /*numComponents=*/1, types);
+
+        geometry_ = geom;
+    }
+
+    std::string baseFileName_(int writerNum) const
+    {
+        std::ostringstream oss;
+        oss << simName_ << "-" << std::setw(5) << std::setfill('0') << writerNum;
+        return oss.str();
+    }
+
+    // the name of the file which is written by a given process
+    std::string pieceFileName_(int writerNum, int rank) const
+    { return VtkFileNames::pieceFileName(baseFileName_(writerNum), "vtu", commSize_, rank); }
+
+    std::string parallelFileName_(int writerNum) const
+    { return VtkFileNames::parallelFileName(baseFileName_(writerNum), "vtu", commSize_); }
+
+    // this method is run by the thread which does the writing
+    void writeTimeStep_(TimeStepData& data)
+    {
+        // the statistics are only folded into the ones of the writer once the files
+        // are written because they may be queried concurrently
+        Timer writeTimer("write VTK files");
+        writeTimer.start();
+        size_t numBytesWritten = 0;
+
+        Geometry& geom = *data.geometry;
+
+        std::vector<DataArray*> arrays;
+        for (const auto& array : data.pointData)
+            arrays.push_back(array.get());
+        for (const auto& array : data.cellData)
+            arrays.push_back(array.get());
+
+        std::vector<DataArray*> geometryArrays =
+            { geom.points.get(), geom.connectivity.get(), geom.offsets.get(), geom.types.get() };
+
+        // encode the arrays. if compression is enabled, this is where most of the time
+        // is spent, so it is distributed to the compression threads. the geometry only
+        // needs to be encoded once for each grid.
+        for (DataArray* array : arrays)
+            compressionRunner_.dispatch(std::make_shared<EncodeArrayTasklet>(*array, compressionLevel_));
+        if (!geom.isEncoded)
+            for (DataArray* array : geometryArrays)
+                compressionRunner_.dispatch(std::make_shared<EncodeArrayTasklet>(*array, compressionLevel_));
+        compressionRunner_.barrier();
+        geom.isEncoded = true;
+
+        // write the piece of the local process
+        std::string vtuFileName = pieceFileName_(data.writerNum, commRank_);
+        std::ofstream vtuFile((outputDir_ + "/" + vtuFileName).c_str(), std::ios::binary);
+        writeVtu_(vtuFile, data);
+        numBytesWritten += static_cast<size_t>(vtuFile.tellp());
+        vtuFile.close();
+
+        std::string fileName = vtuFileName;
+        if (commSize_ > 1) {
+            fileName = parallelFileName_(data.writerNum);
+            if (commRank_ == 0) {
+                std::ofstream pvtuFile((outputDir_ + "/" + fileName).c_str());
+                writePvtu_(pvtuFile, data);
+                numBytesWritten += static_cast<size_t>(pvtuFile.tellp());
+            }
+        }
+
+        if (commRank_ == 0) {
+            if (!multiFile_.is_open())
+                startMultiFile_();
+
+            multiFile_.precision(16);
+            multiFile_ << "   <DataSet timestep=\"" << data.time << "\" file=\""
+                       << fileName << "\"/>\n";
+
+            // temporarily write the closing XML mumbo-jumbo to the mashup file so that
+            // the data set can be loaded even if the simulation is aborted (or not yet
+            // finished)
+            finishMultiFile_();
+        }
+
+        writeTimer.stop();
+
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        ioTimer_ += writeTimer;
+        numBytesWritten_ += numBytesWritten;
+    }
+
+    void writeDataArrayHeader_(std::ostream& os, const DataArray& array, std::uint64_t& offset) const
+    {
+        os << "    <DataArray type=\"" << array.type << "\""
+           << " Name=\"" << array.name << "\""
+           << " NumberOfComponents=\"" << array.numComponents << "\""
+           << " format=\"appended\""
+           << " offset=\"" << offset << "\"/>\n";
+        offset += array.encodedData.size();
+    }
+
+    void writeVtu_(std::ostream& os, const TimeStepData& data) const
+    {
+        const Geometry& geom = *data.geometry;
+        std::uint64_t offset = 0;
+
+        os << "<?xml version=\"1.0\"?>\n"
+           << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\""
+           << " byte_order=\"" << byteOrder_() << "\" header_type=\"UInt64\"";
+        if (compressionLevel_ > 0)
+            os << " compressor=\"vtkZLibDataCompressor\"";
+        os << ">\n"
+           << " <UnstructuredGrid>\n"
+           << "  <Piece NumberOfPoints=\"" << geom.numPoints << "\""
+           << " NumberOfCells=\"" << geom.numCells << "\">\n";
+
+        // the order of the headers must be the same as the one of the arrays in the
+        // appended section below
+        os << "   <PointData>\n";
+        for (const auto& array : data.pointData)
+            writeDataArrayHeader_(os, *array, offset);
+        os << "   </PointData>\n"
+           << "   <CellData>\n";
+        for (const auto& array : data.cellData)
+            writeDataArrayHeader_(os, *array, offset);
+        os << "   </CellData>\n"
+           << "   <Points>\n";
+        writeDataArrayHeader_(os, *geom.points, offset);
+        os << "   </Points>\n"
+           << "   <Cells>\n";
+        writeDataArrayHeader_(os, *geom.connectivity, offset);
+        writeDataArrayHeader_(os, *geom.offsets, offset);
+        writeDataArrayHeader_(os, *geom.types, offset);
+        os << "   </Cells>\n"
+           << "  </Piece>\n"
+           << " </UnstructuredGrid>\n"
+           << " <AppendedData encoding=\"raw\">\n"
+           << "_";
+
+        for (const auto& array : data.pointData)
+            os.write(array->encodedData.data(), static_cast<std::streamsize>(array->encodedData.size()));
+        for (const auto& array : data.cellData)
+            os.write(array->encodedData.data(), static_cast<std::streamsize>(array->encodedData.size()));
+        for (const auto* array : { geom.points.get(), geom.connectivity.get(), geom.offsets.get(), geom.types.get() })
+            os.write(array->encodedData.data(), static_cast<std::streamsize>(array->encodedData.size()));
+
+        os << "\n"
+           << " </AppendedData>\n"
+           << "</VTKFile>\n";
+    }
+
+    void writePvtu_(std::ostream& os, const TimeStepData& data) const
+    {
+        os << "<?xml version=\"1.0\"?>\n"
+           << "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\""
+           << " byte_order=\"" << byteOrder_() << "\" header_type=\"UInt64\"";
+        if (compressionLevel_ > 0)
+            os << " compressor=\"vtkZLibDataCompressor\"";
+        os << ">\n"
+           << " <PUnstructuredGrid GhostLevel=\"0\">\n"
+           << "  <PPointData>\n";
+        for (const auto& array : data.pointData)
+            os << "   <PDataArray type=\"" << array->type << "\" Name=\"" << array->name << "\""
+               << " NumberOfComponents=\"" << array->numComponents << "\"/>\n";
+        os << "  </PPointData>\n"
+           << "  <PCellData>\n";
+        for (const auto& array : data.cellData)
+            os << "   <PDataArray type=\"" << array->type << "\" Name=\"" << array->name << "\""
+               << " NumberOfComponents=\"" << array->numComponents << "\"/>\n";
+        os << "  </PCellData>\n"
+           << "  <PPoints>\n"
+           << "   <PDataArray type=\"Float32\" Name=\"Coordinates\" NumberOfComponents=\"3\"/>\n"
+           << "  </PPoints>\n";
+        for (int rank = 0; rank < commSize_; ++rank)
+            os << "  <Piece Source=\"" << pieceFileName_(data.writerNum, rank) << "\"/>\n";
+        os << " </PUnstructuredGrid>\n"
+           << "</VTKFile>\n";
+    }
+
+    void startMultiFile_()
+    {
+        // generate one meta vtk-file holding the individual time steps
+        multiFile_.open(multiFileName_.c_str());
+        multiFile_ << "<?xml version=\"1.0\"?>\n"
+                      "<VTKFile type=\"Collection\"\n"
+                      "         version=\"0.1\"\n"
+                      "         byte_order=\"" << byteOrder_() << "\">\n"
+                      " <Collection>\n";
+    }
+
+    void finishMultiFile_()
+    {
+        // make sure that we always have a working meta file
+        std::ofstream::pos_type pos = multiFile_.tellp();
+        multiFile_ << " </Collection>\n"
+                      "</VTKFile>\n";
+        multiFile_.seekp(pos);
+        multiFile_.flush();
+    }
+
+    const GridView gridView_;
+    ElementMapper elementMapper_;
+    VertexMapper vertexMapper_;
+
+    std::string outputDir_;
+    std::string simName_;
+    std::ofstream multiFile_;
+    std::string multiFileName_;
+
+    int commSize_; // number of processes in the communicator
+    int commRank_; // rank of the current process in the communicator
+
+    int compressionLevel_;
+
+    GeometryPtr geometry_;
+    TimeStepDataPtr curData_;
+    int curWriterNum_;
+
+    // the I/O statistics are updated by the writer thread
+    mutable std::mutex statisticsMutex_;
+    Timer ioTimer_;
+    size_t numBytesWritten_;
+
+    OutputBufferLimiter bufferLimiter_;
+    TaskletRunner taskletRunner_;
+    TaskletRunner compressionRunner_;
+};
+} // namespace Ewoms
+
+#endif
@@ -178,8 +178,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter)
+        if (!baseWriter.acceptsGridFields())
             return;
 
         if (!enableEnergy)
@@ -199,28 +198,28 @@ public:
     }
 
 private:
-    static bool rockInternalEnergyOutput_()
+    bool rockInternalEnergyOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteRockInternalEnergy);
-        return val;
+        return val && this->fieldSelected_("volumetric internal energy rock");
     }
 
-    static bool totalThermalConductivityOutput_()
+    bool totalThermalConductivityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteTotalThermalConductivity);
-        return val;
+        return val && this->fieldSelected_("total thermal conductivity");
     }
 
-    static bool fluidInternalEnergiesOutput_()
+    bool fluidInternalEnergiesOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFluidInternalEnergies);
-        return val;
+        return val && this->fieldSelected_("internal energy_%s");
     }
 
-    static bool fluidEnthalpiesOutput_()
+    bool fluidEnthalpiesOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFluidEnthalpies);
-        return val;
+        return val && this->fieldSelected_("enthalpy_%s");
     }
 
     ScalarBuffer rockInternalEnergy_;
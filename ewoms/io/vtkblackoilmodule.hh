@@ -272,8 +272,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter)
+        if (!baseWriter.acceptsGridFields())
             return;
 
         if (gasDissolutionFactorOutput_())
@@ -304,70 +303,70 @@ public:
     }
 
 private:
-    static bool gasDissolutionFactorOutput_()
+    bool gasDissolutionFactorOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteGasDissolutionFactor);
-        return val;
+        return val && this->fieldSelected_("R_s");
     }
 
-    static bool oilVaporizationFactorOutput_()
+    bool oilVaporizationFactorOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteOilVaporizationFactor);
-        return val;
+        return val && this->fieldSelected_("R_v");
     }
 
-    static bool oilFormationVolumeFactorOutput_()
+    bool oilFormationVolumeFactorOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteOilFormationVolumeFactor);
-        return val;
+        return val && this->fieldSelected_("B_o");
     }
 
-    static bool gasFormationVolumeFactorOutput_()
+    bool gasFormationVolumeFactorOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteGasFormationVolumeFactor);
-        return val;
+        return val && this->fieldSelected_("B_g");
     }
 
-    static bool waterFormationVolumeFactorOutput_()
+    bool waterFormationVolumeFactorOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteWaterFormationVolumeFactor);
-        return val;
+        return val && this->fieldSelected_("B_w");
     }
 
-    static bool oilSaturationPressureOutput_()
+    bool oilSaturationPressureOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteOilSaturationPressure);
-        return val;
+        return val && this->fieldSelected_("p_o,sat");
     }
 
-    static bool gasSaturationPressureOutput_()
+    bool gasSaturationPressureOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteGasSaturationPressure);
-        return val;
+        return val && this->fieldSelected_("p_g,sat");
     }
 
-    static bool saturatedOilGasDissolutionFactorOutput_()
+    bool saturatedOilGasDissolutionFactorOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteSaturatedOilGasDissolutionFactor);
-        return val;
+        return val && this->fieldSelected_("R_s,sat");
     }
 
-    static bool saturatedGasOilVaporizationFactorOutput_()
+    bool saturatedGasOilVaporizationFactorOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteSaturatedGasOilVaporizationFactor);
-        return val;
+        return val && this->fieldSelected_("R_v,sat");
     }
 
-    static bool saturationRatiosOutput_()
+    bool saturationRatiosOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteSaturationRatios);
-        return val;
+        return val && this->fieldSelected_("saturation ratio_%s");
     }
 
-    static bool primaryVarsMeaningOutput_()
+    bool primaryVarsMeaningOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePrimaryVarsMeaning);
-        return val;
+        return val && this->fieldSelected_("primary vars meaning");
     }
 
     ScalarBuffer gasDissolutionFactor_;
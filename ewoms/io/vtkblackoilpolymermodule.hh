@@ -196,8 +196,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter)
+        if (!baseWriter.acceptsGridFields())
             return;
 
         if (!enablePolymer)
@@ -223,40 +222,40 @@ public:
     }
 
 private:
-    static bool polymerConcentrationOutput_()
+    bool polymerConcentrationOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePolymerConcentration);
-        return val;
+        return val && this->fieldSelected_("polymer concentration");
     }
 
-    static bool polymerDeadPoreVolumeOutput_()
+    bool polymerDeadPoreVolumeOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePolymerDeadPoreVolume);
-        return val;
+        return val && this->fieldSelected_("dead pore volume fraction");
     }
 
-    static bool polymerRockDensityOutput_()
+    bool polymerRockDensityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePolymerRockDensity);
-        return val;
+        return val && this->fieldSelected_("polymer rock density");
     }
 
-    static bool polymerAdsorptionOutput_()
+    bool polymerAdsorptionOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePolymerAdsorption);
-        return val;
+        return val && this->fieldSelected_("polymer adsorption");
     }
 
-    static bool polymerViscosityCorrectionOutput_()
+    bool polymerViscosityCorrectionOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePolymerViscosityCorrection);
-        return val;
+        return val && this->fieldSelected_("polymer viscosity correction");
     }
 
-    static bool waterViscosityCorrectionOutput_()
+    bool waterViscosityCorrectionOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePolymerViscosityCorrection);
-        return val;
+        return val && this->fieldSelected_("water viscosity correction");
     }
 
     ScalarBuffer polymerConcentration_;
@@ -175,8 +175,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter)
+        if (!baseWriter.acceptsGridFields())
             return;
 
         if (!enableSolvent)
@@ -196,28 +195,28 @@ public:
     }
 
 private:
-    static bool solventSaturationOutput_()
+    bool solventSaturationOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteSolventSaturation);
-        return val;
+        return val && this->fieldSelected_("saturation_solvent");
     }
 
-    static bool solventDensityOutput_()
+    bool solventDensityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteSolventDensity);
-        return val;
+        return val && this->fieldSelected_("density_solvent");
     }
 
-    static bool solventViscosityOutput_()
+    bool solventViscosityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteSolventViscosity);
-        return val;
+        return val && this->fieldSelected_("viscosity_solvent");
     }
 
-    static bool solventMobilityOutput_()
+    bool solventMobilityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteSolventMobility);
-        return val;
+        return val && this->fieldSelected_("mobility_solvent");
     }
 
     ScalarBuffer solventSaturation_;
@@ -215,8 +215,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!baseWriter.acceptsGridFields()) {
             return;
         }
 
@@ -238,46 +237,46 @@ public:
     }
 
 private:
-    static bool massFracOutput_()
+    bool massFracOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteMassFractions);
-        return val;
+        return val && this->fieldSelected_("massFrac_%s^%s");
     }
 
-    static bool moleFracOutput_()
+    bool moleFracOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteMoleFractions);
-        return val;
+        return val && this->fieldSelected_("moleFrac_%s^%s");
     }
 
-    static bool totalMassFracOutput_()
+    bool totalMassFracOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteTotalMassFractions);
-        return val;
+        return val && this->fieldSelected_("totalMassFrac^%s");
     }
 
-    static bool totalMoleFracOutput_()
+    bool totalMoleFracOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteTotalMoleFractions);
-        return val;
+        return val && this->fieldSelected_("totalMoleFrac^%s");
     }
 
-    static bool molarityOutput_()
+    bool molarityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteMolarities);
-        return val;
+        return val && this->fieldSelected_("molarity_%s^%s");
     }
 
-    static bool fugacityOutput_()
+    bool fugacityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFugacities);
-        return val;
+        return val && this->fieldSelected_("fugacity^%s");
     }
 
-    static bool fugacityCoeffOutput_()
+    bool fugacityCoeffOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFugacityCoeffs);
-        return val;
+        return val && this->fieldSelected_("fugacityCoeff_%s^%s");
     }
 
     PhaseComponentBuffer moleFrac_;
@@ -159,8 +159,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!baseWriter.acceptsGridFields()) {
             return;
         }
 
@@ -176,22 +175,22 @@ public:
     }
 
 private:
-    static bool tortuosityOutput_()
+    bool tortuosityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteTortuosities);
-        return val;
+        return val && this->fieldSelected_("tortuosity");
     }
 
-    static bool diffusionCoefficientOutput_()
+    bool diffusionCoefficientOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteDiffusionCoefficients);
-        return val;
+        return val && this->fieldSelected_("diffusionCoefficient");
     }
 
-    static bool effectiveDiffusionCoefficientOutput_()
+    bool effectiveDiffusionCoefficientOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteEffectiveDiffusionCoefficients);
-        return val;
+        return val && this->fieldSelected_("effectiveDiffusionCoefficient");
     }
 
     PhaseBuffer tortuosity_;
@@ -260,8 +260,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!baseWriter.acceptsGridFields()) {
             return;
         }
 
@@ -302,46 +301,46 @@ public:
     }
 
 private:
-    static bool saturationOutput_()
+    bool saturationOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFractureSaturations);
-        return val;
+        return val && this->fieldSelected_("fractureSaturation_%s");
     }
 
-    static bool mobilityOutput_()
+    bool mobilityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFractureMobilities);
-        return val;
+        return val && this->fieldSelected_("fractureMobility_%s");
     }
 
-    static bool relativePermeabilityOutput_()
+    bool relativePermeabilityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFractureRelativePermeabilities);
-        return val;
+        return val && this->fieldSelected_("fractureRelativePerm_%s");
     }
 
-    static bool porosityOutput_()
+    bool porosityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFracturePorosity);
-        return val;
+        return val && this->fieldSelected_("fracturePorosity");
     }
 
-    static bool intrinsicPermeabilityOutput_()
+    bool intrinsicPermeabilityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFractureIntrinsicPermeabilities);
-        return val;
+        return val && this->fieldSelected_("fractureIntrinsicPerm");
     }
 
-    static bool volumeFractionOutput_()
+    bool volumeFractionOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFractureVolumeFraction);
-        return val;
+        return val && this->fieldSelected_("fractureVolumeFraction");
     }
 
-    static bool velocityOutput_()
+    bool velocityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFractureFilterVelocities);
-        return val;
+        return val && this->fieldSelected_("fractureFilterVelocity_%s");
     }
 
     PhaseBuffer fractureSaturation_;
@@ -165,8 +165,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!baseWriter.acceptsGridFields()) {
             return;
         }
 
@@ -182,28 +181,28 @@ public:
     }
 
 private:
-    static bool solidInternalEnergyOutput_()
+    bool solidInternalEnergyOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteSolidInternalEnergy);
-        return val;
+        return val && this->fieldSelected_("internalEnergySolid");
     }
 
-    static bool thermalConductivityOutput_()
+    bool thermalConductivityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteThermalConductivity);
-        return val;
+        return val && this->fieldSelected_("thermalConductivity");
     }
 
-    static bool enthalpyOutput_()
+    bool enthalpyOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteEnthalpies);
-        return val;
+        return val && this->fieldSelected_("enthalpy_%s");
     }
 
-    static bool internalEnergyOutput_()
+    bool internalEnergyOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteInternalEnergies);
-        return val;
+        return val && this->fieldSelected_("internalEnergy_%s");
     }
 
     PhaseBuffer enthalpy_;
@@ -0,0 +1,89 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::VtkFileNames
+ */
+#ifndef EWOMS_VTK_FILE_NAMES_HH
+#define EWOMS_VTK_FILE_NAMES_HH
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace Ewoms {
+/*!
+ * \brief The names of the files which make up a parallel VTK data set.
+ *
+ * In the parallel case, every process writes its own piece and the first process
+ * writes a header file which references all pieces. These names correspond to the
+ * ones which are used by Dune::VTKWriter::pwrite(), so all VTK writers of eWoms
+ * produce files which are named consistently.
+ */
+class VtkFileNames
+{
+public:
+    /*!
+     * \brief Returns the name of the piece which is written by a given process.
+     *
+     * For sequential runs, this is just the base name plus the extension.
+     *
+     * \param baseName The name of the data set without any extension
+     * \param extension The extension of the piece files, i.e., "vtu" or "vtp"
+     * \param commSize The number of processes which write the data set
+     * \param rank The rank of the process which writes the piece
+     */
+    static std::string pieceFileName(const std::string& baseName,
+                                     const std::string& extension,
+                                     int commSize,
+                                     int rank)
+    {
+        std::ostringstream oss;
+        if (commSize > 1)
+            oss << "s" << std::setw(4) << std::setfill('0') << commSize << "-"
+                << "p" << std::setw(4) << std::setfill('0') << rank << "-";
+        oss << baseName << "." << extension;
+        return oss.str();
+    }
+
+    /*!
+     * \brief Returns the name of the header file of a parallel data set.
+     *
+     * \param baseName The name of the data set without any extension
+     * \param extension The extension of the piece files, i.e., "vtu" or "vtp"
+     * \param commSize The number of processes which write the data set
+     */
+    static std::string parallelFileName(const std::string& baseName,
+                                        const std::string& extension,
+                                        int commSize)
+    {
+        std::ostringstream oss;
+        oss << "s" << std::setw(4) << std::setfill('0') << commSize << "-"
+            << baseName << ".p" << extension;
+        return oss.str();
+    }
+};
+} // namespace Ewoms
+
+#endif
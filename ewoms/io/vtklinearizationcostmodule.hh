@@ -0,0 +1,158 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::VtkLinearizationCostModule
+ */
+#ifndef EWOMS_VTK_LINEARIZATION_COST_MODULE_HH
+#define EWOMS_VTK_LINEARIZATION_COST_MODULE_HH
+
+#include <ewoms/io/baseoutputmodule.hh>
+#include <ewoms/io/vtkmultiwriter.hh>
+
+#include <ewoms/common/parametersystem.hh>
+#include <ewoms/common/propertysystem.hh>
+
+BEGIN_PROPERTIES
+
+// forward declaration of the required property tags
+NEW_PROP_TAG(EnableVtkOutput);
+NEW_PROP_TAG(VtkOutputFormat);
+NEW_PROP_TAG(EnableLinearizationCostMap);
+
+END_PROPERTIES
+
+namespace Ewoms {
+
+/*!
+ * \ingroup Vtk
+ *
+ * \brief VTK output module for the computational cost of linearizing each element
+ *
+ * This module writes the wall clock time in microseconds and the number of inner
+ * iterations (e.g., of the Forchheimer velocity or of flash calculations) which were
+ * needed to linearize each element during the last time step. The data is only
+ * available if the EnableLinearizationCostMap parameter is set.
+ */
+template<class TypeTag>
+class VtkLinearizationCostModule : public BaseOutputModule<TypeTag>
+{
+    typedef BaseOutputModule<TypeTag> ParentType;
+
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
+    typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
+
+    static const int vtkFormat = GET_PROP_VALUE(TypeTag, VtkOutputFormat);
+    typedef Ewoms::VtkMultiWriter<GridView, vtkFormat> VtkMultiWriter;
+
+    typedef typename ParentType::ScalarBuffer ScalarBuffer;
+
+public:
+    VtkLinearizationCostModule(const Simulator& simulator)
+        : ParentType(simulator)
+    { }
+
+    /*!
+     * \brief Register all run-time parameters for the Vtk output module.
+     */
+    static void registerParameters()
+    { }
+
+    /*!
+     * \brief Allocate memory for the scalar fields we would like to
+     *        write to the VTK file.
+     */
+    void allocBuffers()
+    {
+        if (linearizationCostOutput_())
+            this->resizeScalarBuffer_(linearizationCost_,
+                                      /*bufferType=*/ParentType::ElementBuffer);
+        if (innerIterationsOutput_())
+            this->resizeScalarBuffer_(innerIterations_,
+                                      /*bufferType=*/ParentType::ElementBuffer);
+    }
+
+    /*!
+     * \brief Modify the internal buffers according to the intensive quantities relevant for
+     *        an element
+     */
+    void processElement(const ElementContext& elemCtx)
+    {
+        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput))
+            return;
+
+        const auto& linearizer = elemCtx.model().linearizer();
+        const auto& elementMapper = elemCtx.model().elementMapper();
+        unsigned elemIdx = static_cast<unsigned>(elementMapper.index(elemCtx.element()));
+
+        // the cost map is empty if no linearization took place yet
+        const auto& cost = linearizer.elementLinearizationCost();
+        if (linearizationCostOutput_() && !linearizationCost_.empty() && elemIdx < cost.size())
+            linearizationCost_[elemIdx] = cost[elemIdx];
+
+        const auto& innerIterations = linearizer.elementInnerIterations();
+        if (innerIterationsOutput_() && !innerIterations_.empty() && elemIdx < innerIterations.size())
+            innerIterations_[elemIdx] = innerIterations[elemIdx];
+    }
+
+    /*!
+     * \brief Add all buffers to the VTK output writer.
+     */
+    void commitBuffers(BaseOutputWriter& baseWriter)
+    {
+        if (!baseWriter.acceptsGridFields()) {
+            return;
+        }
+
+        if (linearizationCostOutput_())
+            this->commitScalarBuffer_(baseWriter,
+                                      "linearization cost",
+                                      linearizationCost_,
+                                      /*bufferType=*/ParentType::ElementBuffer);
+        if (innerIterationsOutput_())
+            this->commitScalarBuffer_(baseWriter,
+                                      "inner iterations",
+                                      innerIterations_,
+                                      /*bufferType=*/ParentType::ElementBuffer);
+    }
+
+private:
+    bool linearizationCostOutput_() const
+    {
+        static bool val = EWOMS_GET_PARAM(TypeTag, bool, EnableLinearizationCostMap);
+        return val && this->fieldSelected_("linearization cost");
+    }
+    bool innerIterationsOutput_() const
+    {
+        static bool val = EWOMS_GET_PARAM(TypeTag, bool, EnableLinearizationCostMap);
+        return val && this->fieldSelected_("inner iterations");
+    }
+
+    ScalarBuffer linearizationCost_;
+    ScalarBuffer innerIterations_;
+};
+
+} // namespace Ewoms
+
+#endif
@@ -311,8 +311,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter)
+        if (!baseWriter.acceptsGridFields())
             return;
 
         if (extrusionFactorOutput_())
@@ -386,76 +385,76 @@ public:
     }
 
 private:
-    static bool extrusionFactorOutput_()
+    bool extrusionFactorOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteExtrusionFactor);
-        return val;
+        return val && this->fieldSelected_("extrusionFactor");
     }
 
-    static bool pressureOutput_()
+    bool pressureOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePressures);
-        return val;
+        return val && this->fieldSelected_("pressure_%s");
     }
 
-    static bool densityOutput_()
+    bool densityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteDensities);
-        return val;
+        return val && this->fieldSelected_("density_%s");
     }
 
-    static bool saturationOutput_()
+    bool saturationOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteSaturations);
-        return val;
+        return val && this->fieldSelected_("saturation_%s");
     }
 
-    static bool mobilityOutput_()
+    bool mobilityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteMobilities);
-        return val;
+        return val && this->fieldSelected_("mobility_%s");
     }
 
-    static bool relativePermeabilityOutput_()
+    bool relativePermeabilityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteRelativePermeabilities);
-        return val;
+        return val && this->fieldSelected_("relativePerm_%s");
     }
 
-    static bool viscosityOutput_()
+    bool viscosityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteViscosities);
-        return val;
+        return val && this->fieldSelected_("viscosity_%s");
     }
 
-    static bool averageMolarMassOutput_()
+    bool averageMolarMassOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteAverageMolarMasses);
-        return val;
+        return val && this->fieldSelected_("averageMolarMass_%s");
     }
 
-    static bool porosityOutput_()
+    bool porosityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePorosity);
-        return val;
+        return val && this->fieldSelected_("porosity");
     }
 
-    static bool intrinsicPermeabilityOutput_()
+    bool intrinsicPermeabilityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteIntrinsicPermeabilities);
-        return val;
+        return val && this->fieldSelected_("intrinsicPerm");
     }
 
-    static bool velocityOutput_()
+    bool velocityOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteFilterVelocities);
-        return val;
+        return val && this->fieldSelected_("filterVelocity_%s");
     }
 
-    static bool potentialGradientOutput_()
+    bool potentialGradientOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePotentialGradients);
-        return val;
+        return val && this->fieldSelected_("gradP_%s");
     }
 
     ScalarBuffer extrusionFactor_;
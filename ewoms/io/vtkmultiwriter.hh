@@ -33,7 +33,10 @@
 #include "vtktensorfunction.hh"
 
 #include <ewoms/io/baseoutputwriter.hh>
+#include <ewoms/io/outputbufferlimiter.hh>
+#include <ewoms/io/vtkfilenames.hh>
 #include <ewoms/parallel/tasklets.hh>
+#include <ewoms/common/timer.hh>
 
 #include <opm/material/common/Valgrind.hpp>
 #include <opm/material/common/Unused.hpp>
@@ -47,11 +50,15 @@
 #endif
 
 #include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <limits>
 #include <sstream>
 #include <fstream>
 
+#include <sys/stat.h>
+
 namespace Ewoms {
 /*!
  * \brief Simplifies writing multi-file VTK datasets.
@@ -59,39 +66,95 @@ namespace Ewoms {
  * This class automatically keeps the meta file up to date and
  * simplifies writing datasets consisting of multiple files. (i.e.
  * multiple time steps or grid refinements within a time step.)
+ *
+ * The data of each file is copied into a separate set of buffers when it is attached
+ * to the writer. This allows to extract the fields for the next file while the
+ * previous ones are still written asynchronously. The number of buffer sets which can
+ * exist at the same time and the memory which they may occupy are limited, see
+ * Ewoms::OutputBufferLimiter.
  */
 template <class GridView, int vtkFormat>
 class VtkMultiWriter : public BaseOutputWriter
 {
+    // all data which is required to write a single VTK file. As long as the file has
+    // not been written, it is exclusively accessed by the thread which does the writing.
+    struct BufferSet
+    {
+        std::unique_ptr<Dune::VTKWriter<GridView> > writer;
+        double time;
+        std::string outFileName;
+
+        std::list<ScalarBuffer> scalarBuffers;
+        std::list<VectorBuffer> vectorBuffers;
+        std::list<TensorBuffer> tensorBuffers;
+        size_t numBytes;
+    };
+    typedef std::shared_ptr<BufferSet> BufferSetPtr;
+
     class WriteDataTasklet : public TaskletInterface
     {
     public:
-        WriteDataTasklet(VtkMultiWriter& multiWriter)
+        WriteDataTasklet(VtkMultiWriter& multiWriter, BufferSetPtr bufferSet)
             : multiWriter_(multiWriter)
+            , bufferSet_(bufferSet)
         { }
 
         void run() final
         {
+            // the statistics are only folded into the ones of the writer once the
+            // files are written because they may be queried concurrently
+            Timer writeTimer("write VTK files");
+            writeTimer.start();
+
+            BufferSet& bufferSet = *bufferSet_;
+
             std::string fileName;
             // write the actual data as vtu or vtp (plus the pieces file in the parallel case)
             if (multiWriter_.commSize_ > 1)
-                fileName = multiWriter_.curWriter_->pwrite(/*name=*/multiWriter_.curOutFileName_,
-                                                           /*path=*/multiWriter_.outputDir_,
-                                                           /*extendPath=*/"",
-                                                           static_cast<Dune::VTK::OutputType>(vtkFormat));
+                fileName = bufferSet.writer->pwrite(/*name=*/bufferSet.outFileName,
+                                                    /*path=*/multiWriter_.outputDir_,
+                                                    /*extendPath=*/"",
+                                                    static_cast<Dune::VTK::OutputType>(vtkFormat));
             else
-                fileName = multiWriter_.curWriter_->write(/*name=*/multiWriter_.outputDir_ + "/" + multiWriter_.curOutFileName_,
-                                                          static_cast<Dune::VTK::OutputType>(vtkFormat));
-
-            // determine name to write into the multi-file for the
-            // current time step
-            multiWriter_.multiFile_.precision(16);
-            multiWriter_.multiFile_ << "   <DataSet timestep=\"" << multiWriter_.curTime_ << "\" file=\""
-                                    << fileName << "\"/>\n";
+                fileName = bufferSet.writer->write(/*name=*/multiWriter_.outputDir_ + "/" + bufferSet.outFileName,
+                                                   static_cast<Dune::VTK::OutputType>(vtkFormat));
+
+            size_t numBytesWritten = fileSize_(fileName);
+            if (multiWriter_.commSize_ > 1)
+                numBytesWritten += fileSize_(multiWriter_.pieceFileName_(bufferSet.outFileName));
+
+            // add the file to the multi-file. since there is at most a single thread
+            // which writes the files, they are added in the order in which they were
+            // passed to the writer.
+            if (multiWriter_.commRank_ == 0) {
+                if (!multiWriter_.multiFile_.is_open())
+                    multiWriter_.startMultiFile_(multiWriter_.multiFileName_);
+
+                multiWriter_.multiFile_.precision(16);
+                multiWriter_.multiFile_ << "   <DataSet timestep=\"" << bufferSet.time << "\" file=\""
+                                        << fileName << "\"/>\n";
+
+                // temporarily write the closing XML mumbo-jumbo to the mashup
+                // file so that the data set can be loaded even if the
+                // simulation is aborted (or not yet finished)
+                multiWriter_.finishMultiFile_();
+            }
+
+            // free the buffers before a new buffer set may be allocated
+            size_t numBytes = bufferSet.numBytes;
+            bufferSet_.reset();
+            multiWriter_.bufferLimiter_.release(numBytes);
+
+            writeTimer.stop();
+
+            std::lock_guard<std::mutex> lock(multiWriter_.statisticsMutex_);
+            multiWriter_.ioTimer_ += writeTimer;
+            multiWriter_.numBytesWritten_ += numBytesWritten;
         }
 
     private:
         VtkMultiWriter& multiWriter_;
+        BufferSetPtr bufferSet_;
     };
 
     enum { dim = GridView::dimension };
@@ -119,11 +182,27 @@ public:
     typedef typename VtkWriter::VTKFunctionPtr FunctionPtr;
 #endif
 
+    /*!
+     * \brief Create a writer.
+     *
+     * \param asyncWriting Write the files using a separate thread
+     * \param gridView The grid view for which the output is written
+     * \param outputDir The directory to which the files are written
+     * \param simName The prefix of the written files
+     * \param multiFileName The name of the .pvd file (default: $outputDir/$simName.pvd)
+     * \param numBufferSets The maximum number of buffer sets which may exist at the
+     *                      same time. 1 means that a new file can only be started after
+     *                      the previous one has been written
+     * \param maxBufferBytes The maximum number of bytes which may be occupied by the
+     *                       buffer sets which wait to be written
+     */
     VtkMultiWriter(bool asyncWriting,
                    const GridView& gridView,
                    const std::string& outputDir,
                    const std::string& simName = "",
-                   std::string multiFileName = "")
+                   std::string multiFileName = "",
+                   unsigned numBufferSets = 2,
+                   size_t maxBufferBytes = std::numeric_limits<size_t>::max())
         : gridView_(gridView)
 #if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
         , elementMapper_(gridView, Dune::mcmgElementLayout())
@@ -132,8 +211,9 @@ public:
         , elementMapper_(gridView)
         , vertexMapper_(gridView)
 #endif
-        , curWriter_(nullptr)
         , curWriterNum_(0)
+        , numBytesWritten_(0)
+        , bufferLimiter_(numBufferSets, maxBufferBytes)
         , taskletRunner_(/*numThreads=*/asyncWriting?1:0)
     {
         outputDir_ = outputDir;
@@ -152,11 +232,11 @@ public:
     ~VtkMultiWriter()
     {
         taskletRunner_.barrier();
-        releaseBuffers_();
-        finishMultiFile_();
 
-        if (commRank_ == 0)
+        if (commRank_ == 0 && multiFile_.is_open()) {
+            finishMultiFile_();
             multiFile_.close();
+        }
     }
 
     /*!
@@ -165,6 +245,50 @@ public:
     int curWriterNum() const
     { return curWriterNum_; }
 
+    /*!
+     * \brief Wait until all data which was passed to the writer has been written to
+     *        disk.
+     */
+    void flush()
+    { taskletRunner_.barrier(); }
+
+    /*!
+     * \brief Returns the number of bytes which were written to disk by the local
+     *        process so far.
+     *
+     * To get accurate results, flush() must have been called before.
+     */
+    size_t numBytesWritten() const
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        return numBytesWritten_;
+    }
+
+    /*!
+     * \brief Returns the timer which measures the time spent on encoding and writing
+     *        the files.
+     *
+     * To get accurate results, flush() must have been called before.
+     */
+    Timer ioTimer() const
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        return ioTimer_;
+    }
+
+    /*!
+     * \brief Returns the maximum memory which was occupied by the buffers of the
+     *        output at the same time [bytes].
+     */
+    size_t peakBufferBytes() const
+    { return bufferLimiter_.peakPendingBytes(); }
+
+    /*!
+     * \copydoc BaseOutputWriter::acceptsGridFields
+     */
+    bool acceptsGridFields() const
+    { return true; }
+
     /*!
      * \brief Updates the internal data structures after mesh
      *        refinement.
@@ -174,28 +298,28 @@ public:
      */
     void gridChanged()
     {
+        // the pending files still use the mappers
+        taskletRunner_.barrier();
+
         elementMapper_.update();
         vertexMapper_.update();
     }
 
     /*!
      * \brief Called whenever a new time step must be written.
+     *
+     * This method only blocks if the maximum number of buffer sets is already in use
+     * or if the pending buffer sets occupy too much memory.
      */
     void beginWrite(double t)
     {
-        if (!multiFile_.is_open()) {
-            startMultiFile_(multiFileName_);
-        }
-
-        // make sure that all previous output has been written and no other thread
-        // accesses the memory used as the target for the extracted quantities
-        taskletRunner_.barrier();
-        releaseBuffers_();
+        bufferLimiter_.waitForFreeSlot();
 
-        curTime_ = t;
-        curOutFileName_ = fileName_();
-
-        curWriter_ = new VtkWriter(gridView_, Dune::VTK::conforming);
+        curBufferSet_ = std::make_shared<BufferSet>();
+        curBufferSet_->time = t;
+        curBufferSet_->outFileName = fileName_();
+        curBufferSet_->numBytes = 0;
+        curBufferSet_->writer.reset(new VtkWriter(gridView_, Dune::VTK::conforming));
         ++curWriterNum_;
     }
 
@@ -207,9 +331,9 @@ public:
      */
     ScalarBuffer *allocateManagedScalarBuffer(size_t numEntities)
     {
-        ScalarBuffer *buf = new ScalarBuffer(numEntities);
-        managedScalarBuffers_.push_back(buf);
-        return buf;
+        curBufferSet_->scalarBuffers.push_back(ScalarBuffer(numEntities));
+        curBufferSet_->numBytes += bufferBytes_(curBufferSet_->scalarBuffers.back());
+        return &curBufferSet_->scalarBuffers.back();
     }
 
     /*!
@@ -220,12 +344,13 @@ public:
      */
     VectorBuffer *allocateManagedVectorBuffer(size_t numOuter, size_t numInner)
     {
-        VectorBuffer *buf = new VectorBuffer(numOuter);
+        curBufferSet_->vectorBuffers.push_back(VectorBuffer(numOuter));
+        VectorBuffer& buf = curBufferSet_->vectorBuffers.back();
         for (size_t i = 0; i < numOuter; ++ i)
-            (*buf)[i].resize(numInner);
+            buf[i].resize(numInner);
 
-        managedVectorBuffers_.push_back(buf);
-        return buf;
+        curBufferSet_->numBytes += bufferBytes_(buf);
+        return &buf;
     }
 
     /*!
@@ -237,24 +362,21 @@ public:
      * anywhere after calling this method. After the data is written
      * to disk, it will be deleted automatically.
      *
-     * If the buffer is not managed by the MultiWriter, the buffer
-     * must exist at least until the call to endWrite()
-     * finishes.
-     *
-     * In both cases, modifying the buffer between the call to this
-     * method and endWrite() results in _undefined behavior_.
+     * If the buffer is not managed by the MultiWriter, its content is
+     * copied, i.e., the buffer may be modified as soon as this method
+     * returns.
      */
     void attachScalarVertexData(ScalarBuffer& buf, std::string name)
     {
-        sanitizeScalarBuffer_(buf);
+        const ScalarBuffer& storedBuf = storeBuffer_(curBufferSet_->scalarBuffers, buf);
 
         typedef Ewoms::VtkScalarFunction<GridView, VertexMapper> VtkFn;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
                                     vertexMapper_,
-                                    buf,
+                                    storedBuf,
                                     /*codim=*/dim));
-        curWriter_->addVertexData(fnPtr);
+        curBufferSet_->writer->addVertexData(fnPtr);
     }
 
     /*!
@@ -265,24 +387,21 @@ public:
      * anywhere after calling this method. After the data is written
      * to disk, it will be deleted automatically.
      *
-     * If the buffer is not managed by the MultiWriter, the buffer
-     * must exist at least until the call to endWrite()
-     * finishes.
-     *
-     * In both cases, modifying the buffer between the call to this
-     * method and endWrite() results in _undefined behaviour_.
+     * If the buffer is not managed by the MultiWriter, its content is
+     * copied, i.e., the buffer may be modified as soon as this method
+     * returns.
      */
     void attachScalarElementData(ScalarBuffer& buf, std::string name)
     {
-        sanitizeScalarBuffer_(buf);
+        const ScalarBuffer& storedBuf = storeBuffer_(curBufferSet_->scalarBuffers, buf);
 
         typedef Ewoms::VtkScalarFunction<GridView, ElementMapper> VtkFn;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
                                     elementMapper_,
-                                    buf,
+                                    storedBuf,
                                     /*codim=*/0));
-        curWriter_->addCellData(fnPtr);
+        curBufferSet_->writer->addCellData(fnPtr);
     }
 
     /*!
@@ -294,24 +413,21 @@ public:
      * anywhere after calling this method. After the data is written
      * to disk, it will be deleted automatically.
      *
-     * If the buffer is not managed by the MultiWriter, the buffer
-     * must exist at least until the call to endWrite()
-     * finishes.
-     *
-     * In both cases, modifying the buffer between the call to this
-     * method and endWrite() results in _undefined behavior_.
+     * If the buffer is not managed by the MultiWriter, its content is
+     * copied, i.e., the buffer may be modified as soon as this method
+     * returns.
      */
     void attachVectorVertexData(VectorBuffer& buf, std::string name)
     {
-        sanitizeVectorBuffer_(buf);
+        const VectorBuffer& storedBuf = storeBuffer_(curBufferSet_->vectorBuffers, buf);
 
         typedef Ewoms::VtkVectorFunction<GridView, VertexMapper> VtkFn;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
                                     vertexMapper_,
-                                    buf,
+                                    storedBuf,
                                     /*codim=*/dim));
-        curWriter_->addVertexData(fnPtr);
+        curBufferSet_->writer->addVertexData(fnPtr);
     }
 
     /*!
@@ -321,17 +437,18 @@ public:
     {
         typedef Ewoms::VtkTensorFunction<GridView, VertexMapper> VtkFn;
 
-        for (unsigned colIdx = 0; colIdx < buf[0].N(); ++colIdx) {
+        const TensorBuffer& storedBuf = storeBuffer_(curBufferSet_->tensorBuffers, buf);
+        for (unsigned colIdx = 0; colIdx < storedBuf[0].N(); ++colIdx) {
             std::ostringstream oss;
             oss << name <<  "[" << colIdx << "]";
 
             FunctionPtr fnPtr(new VtkFn(oss.str(),
                                         gridView_,
                                         vertexMapper_,
-                                        buf,
+                                        storedBuf,
                                         /*codim=*/dim,
                                         colIdx));
-            curWriter_->addVertexData(fnPtr);
+            curBufferSet_->writer->addVertexData(fnPtr);
         }
     }
 
@@ -343,24 +460,21 @@ public:
      * anywhere after calling this method. After the data is written
      * to disk, it will be deleted automatically.
      *
-     * If the buffer is not managed by the MultiWriter, the buffer
-     * must exist at least until the call to endWrite()
-     * finishes.
-     *
-     * In both cases, modifying the buffer between the call to this
-     * method and endWrite() results in _undefined behaviour_.
+     * If the buffer is not managed by the MultiWriter, its content is
+     * copied, i.e., the buffer may be modified as soon as this method
+     * returns.
      */
     void attachVectorElementData(VectorBuffer& buf, std::string name)
     {
-        sanitizeVectorBuffer_(buf);
+        const VectorBuffer& storedBuf = storeBuffer_(curBufferSet_->vectorBuffers, buf);
 
         typedef Ewoms::VtkVectorFunction<GridView, ElementMapper> VtkFn;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
                                     elementMapper_,
-                                    buf,
+                                    storedBuf,
                                     /*codim=*/0));
-        curWriter_->addCellData(fnPtr);
+        curBufferSet_->writer->addCellData(fnPtr);
     }
 
     /*!
@@ -370,17 +484,18 @@ public:
     {
         typedef Ewoms::VtkTensorFunction<GridView, ElementMapper> VtkFn;
 
-        for (unsigned colIdx = 0; colIdx < buf[0].N(); ++colIdx) {
+        const TensorBuffer& storedBuf = storeBuffer_(curBufferSet_->tensorBuffers, buf);
+        for (unsigned colIdx = 0; colIdx < storedBuf[0].N(); ++colIdx) {
             std::ostringstream oss;
             oss << name <<  "[" << colIdx << "]";
 
             FunctionPtr fnPtr(new VtkFn(oss.str(),
                                         gridView_,
                                         elementMapper_,
-                                        buf,
+                                        storedBuf,
                                         /*codim=*/0,
                                         colIdx));
-            curWriter_->addCellData(fnPtr);
+            curBufferSet_->writer->addCellData(fnPtr);
         }
     }
 
@@ -394,16 +509,14 @@ public:
     void endWrite(bool onlyDiscard = false)
     {
         if (!onlyDiscard) {
-            auto tasklet = std::make_shared<WriteDataTasklet>(*this);
+            bufferLimiter_.acquire(curBufferSet_->numBytes);
+            auto tasklet = std::make_shared<WriteDataTasklet>(*this, curBufferSet_);
             taskletRunner_.dispatch(tasklet);
         }
         else
             --curWriterNum_;
 
-        // temporarily write the closing XML mumbo-jumbo to the mashup
-        // file so that the data set can be loaded even if the
-        // simulation is aborted (or not yet finished)
-        finishMultiFile_();
+        curBufferSet_.reset();
     }
 
     /*!
@@ -412,6 +525,9 @@ public:
     template <class Restarter>
     void serialize(Restarter& res)
     {
+        // make sure that the meta file is not modified behind our back
+        taskletRunner_.barrier();
+
         res.serializeSectionBegin("VTKMultiWriter");
         res.serializeStream() << curWriterNum_ << "\n";
 
@@ -446,6 +562,8 @@ public:
     template <class Restarter>
     void deserialize(Restarter& res)
     {
+        taskletRunner_.barrier();
+
         res.deserializeSectionBegin("VTKMultiWriter");
         res.deserializeStream() >> curWriterNum_;
 
@@ -492,6 +610,22 @@ private:
     std::string fileSuffix_()
     { return (GridView::dimension == 1) ? "vtp" : "vtu"; }
 
+    // the name of the file which is written by the local process in the parallel
+    // case
+    std::string pieceFileName_(const std::string& outFileName) const
+    {
+        const std::string suffix = (GridView::dimension == 1) ? "vtp" : "vtu";
+        return outputDir_ + "/" + VtkFileNames::pieceFileName(outFileName, suffix, commSize_, commRank_);
+    }
+
+    static size_t fileSize_(const std::string& fileName)
+    {
+        struct stat fileStat;
+        if (stat(fileName.c_str(), &fileStat) != 0)
+            return 0;
+        return static_cast<size_t>(fileStat.st_size);
+    }
+
     void startMultiFile_(const std::string& multiFileName)
     {
         // only the first process writes to the multi-file
@@ -520,32 +654,34 @@ private:
         }
     }
 
-    // make sure the field is well defined if running under valgrind
-    // and make sure that all values can be displayed by paraview
-    void sanitizeScalarBuffer_(ScalarBuffer& b OPM_UNUSED)
+    // copy a buffer into the current buffer set unless it is already owned by it
+    template <class Buffer>
+    const Buffer& storeBuffer_(std::list<Buffer>& storedBuffers, const Buffer& buf)
     {
-        // nothing to do: this is done by VtkScalarFunction
+        for (const auto& storedBuf : storedBuffers)
+            if (&storedBuf == &buf)
+                return buf;
+
+        storedBuffers.push_back(buf);
+        curBufferSet_->numBytes += bufferBytes_(buf);
+        return storedBuffers.back();
     }
 
-    void sanitizeVectorBuffer_(VectorBuffer& b OPM_UNUSED)
+    static size_t bufferBytes_(const ScalarBuffer& buf)
+    { return buf.size()*sizeof(Scalar); }
+
+    static size_t bufferBytes_(const VectorBuffer& buf)
     {
-        // nothing to do: this is done by VtkVectorFunction
+        if (buf.empty())
+            return 0;
+        return buf.size()*(sizeof(Vector) + buf[0].size()*sizeof(Scalar));
     }
 
-    // release the memory occupied by all buffer objects managed by the multi-writer
-    void releaseBuffers_()
+    static size_t bufferBytes_(const TensorBuffer& buf)
     {
-        // discard managed objects and the current VTK writer
-        delete curWriter_;
-        curWriter_ = nullptr;
-        while (managedScalarBuffers_.begin() != managedScalarBuffers_.end()) {
-            delete managedScalarBuffers_.front();
-            managedScalarBuffers_.pop_front();
-        }
-        while (managedVectorBuffers_.begin() != managedVectorBuffers_.end()) {
-            delete managedVectorBuffers_.front();
-            managedVectorBuffers_.pop_front();
-        }
+        if (buf.empty())
+            return 0;
+        return buf.size()*(sizeof(Tensor) + buf[0].N()*(sizeof(Vector) + buf[0].M()*sizeof(Scalar)));
     }
 
     const GridView gridView_;
@@ -560,14 +696,15 @@ private:
     int commSize_; // number of processes in the communicator
     int commRank_; // rank of the current process in the communicator
 
-    VtkWriter *curWriter_;
-    double curTime_;
-    std::string curOutFileName_;
+    BufferSetPtr curBufferSet_;
     int curWriterNum_;
 
-    std::list<ScalarBuffer *> managedScalarBuffers_;
-    std::list<VectorBuffer *> managedVectorBuffers_;
+    // the I/O statistics are updated by the writer thread
+    mutable std::mutex statisticsMutex_;
+    Timer ioTimer_;
+    size_t numBytesWritten_;
 
+    OutputBufferLimiter bufferLimiter_;
     TaskletRunner taskletRunner_;
 };
 } // namespace Ewoms
@@ -117,8 +117,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!baseWriter.acceptsGridFields()) {
             return;
         }
 
@@ -127,10 +126,10 @@ public:
     }
 
 private:
-    static bool phasePresenceOutput_()
+    bool phasePresenceOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePhasePresence);
-        return val;
+        return val && this->fieldSelected_("phase presence");
     }
 
     ScalarBuffer phasePresence_;
@@ -142,8 +142,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!baseWriter.acceptsGridFields()) {
             return;
         }
 
@@ -159,20 +158,20 @@ public:
     }
 
 private:
-    static bool primaryVarsOutput_()
+    bool primaryVarsOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWritePrimaryVars);
-        return val;
+        return val && this->fieldSelected_("PV_%s");
     }
-    static bool processRankOutput_()
+    bool processRankOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteProcessRank);
-        return val;
+        return val && this->fieldSelected_("process rank");
     }
-    static bool dofIndexOutput_()
+    bool dofIndexOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteDofIndex);
-        return val;
+        return val && this->fieldSelected_("DOF index");
     }
 
     EqBuffer primaryVars_;
@@ -123,8 +123,7 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!baseWriter.acceptsGridFields()) {
             return;
         }
 
@@ -133,10 +132,10 @@ public:
     }
 
 private:
-    static bool temperatureOutput_()
+    bool temperatureOutput_() const
     {
         static bool val = EWOMS_GET_PARAM(TypeTag, bool, VtkWriteTemperature);
-        return val;
+        return val && this->fieldSelected_("temperature");
     }
 
     ScalarBuffer temperature_;
@@ -32,6 +32,7 @@
 #include "globalindices.hh"
 
 #include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/memoryregistry.hh>
 
 #include <algorithm>
 #include <limits>
@@ -373,6 +374,28 @@ public:
         return mapInternalToExternal_(internalIdx);
     }
 
+    /*!
+     * \brief Returns an estimate of the memory used by the index structures of the
+     *        overlap [bytes].
+     *
+     * This includes the foreign overlap and the global indices.
+     */
+    size_t memoryUsage() const
+    {
+        size_t result =
+            foreignOverlap_.memoryUsage()
+            + globalIndices_.memoryUsage()
+            + treeMemoryUsage(domesticOverlapWithPeer_)
+            + vectorMemoryUsage(domesticOverlapByIndex_)
+            + vectorMemoryUsage(borderDistance_)
+            + vectorMemoryUsage(masterRank_);
+        for (const auto& rankEntry : domesticOverlapWithPeer_)
+            result += vectorMemoryUsage(rankEntry.second);
+        for (const auto& peerMap : domesticOverlapByIndex_)
+            result += treeMemoryUsage(peerMap);
+        return result;
+    }
+
 protected:
     void buildDomesticOverlap_()
     {
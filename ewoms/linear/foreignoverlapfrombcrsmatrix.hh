@@ -31,6 +31,7 @@
 #include "blacklist.hh"
 
 #include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/memoryregistry.hh>
 
 #include <opm/material/common/Unused.hpp>
 
@@ -343,6 +344,25 @@ public:
         }
     }
 
+    /*!
+     * \brief Returns an estimate of the memory used by the index structures [bytes].
+     */
+    size_t memoryUsage() const
+    {
+        size_t result =
+            vectorMemoryUsage(nativeToLocalIndices_)
+            + vectorMemoryUsage(localToNativeIndices_)
+            + vectorMemoryUsage(masterRank_)
+            + treeMemoryUsage(localBorderIndices_)
+            + vectorMemoryUsage(foreignOverlapByLocalIndex_)
+            + treeMemoryUsage(foreignOverlapByRank_);
+        for (const auto& peerMap : foreignOverlapByLocalIndex_)
+            result += treeMemoryUsage(peerMap);
+        for (const auto& rankEntry : foreignOverlapByRank_)
+            result += vectorMemoryUsage(rankEntry.second);
+        return result;
+    }
+
 protected:
     // extend the foreign overlaps by 'overlapSize' levels. this uses
     // a greedy algorithm which extends the region by one level and
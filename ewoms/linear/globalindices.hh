@@ -44,6 +44,8 @@
 
 #include "overlaptypes.hh"
 
+#include <ewoms/common/memoryregistry.hh>
+
 namespace Ewoms {
 namespace Linear {
 /*!
@@ -198,6 +200,12 @@ public:
         std::cout << "\n" << std::flush;
     }
 
+    /*!
+     * \brief Returns an estimate of the memory used by the index mappings [bytes].
+     */
+    size_t memoryUsage() const
+    { return treeMemoryUsage(globalToDomestic_) + treeMemoryUsage(domesticToGlobal_); }
+
 protected:
     // retrieve the offset for the indices where we are master in the
     // global index list
@@ -74,6 +74,7 @@ namespace Linear {
         typedef ISTL_PREC_TYPE<IstlMatrix, OverlappingVector,                   \
                                OverlappingVector> SequentialPreconditioner;     \
         PreconditionerWrapper##PREC_NAME()                                      \
+            : seqPreCond_(nullptr)                                              \
         {}                                                                      \
                                                                                 \
         static void registerParameters()                                        \
@@ -97,7 +98,10 @@ namespace Linear {
         { return *seqPreCond_; }                                                \
                                                                                 \
         void cleanup()                                                          \
-        { delete seqPreCond_; }                                                 \
+        {                                                                       \
+            delete seqPreCond_;                                                 \
+            seqPreCond_ = nullptr;                                              \
+        }                                                                       \
                                                                                 \
     private:                                                                    \
         SequentialPreconditioner *seqPreCond_;                                  \
@@ -117,6 +121,7 @@ namespace Linear {
         typedef ISTL_PREC_TYPE<OverlappingMatrix, OverlappingVector,            \
                                OverlappingVector> SequentialPreconditioner;     \
         PreconditionerWrapper##PREC_NAME()                                      \
+            : seqPreCond_(nullptr)                                              \
         {}                                                                      \
                                                                                 \
         static void registerParameters()                                        \
@@ -138,7 +143,10 @@ namespace Linear {
         { return *seqPreCond_; }                                                \
                                                                                 \
         void cleanup()                                                          \
-        { delete seqPreCond_; }                                                 \
+        {                                                                       \
+            delete seqPreCond_;                                                 \
+            seqPreCond_ = nullptr;                                              \
+        }                                                                       \
                                                                                 \
     private:                                                                    \
         SequentialPreconditioner *seqPreCond_;                                  \
@@ -168,6 +176,7 @@ public:
            SequentialPreconditioner;
 
     PreconditionerWrapperILU()
+        : seqPreCond_(nullptr)
     {}
 
     static void registerParameters()
@@ -188,7 +197,10 @@ public:
     { return *seqPreCond_; }
 
     void cleanup()
-    { delete seqPreCond_; }
+    {
+        delete seqPreCond_;
+        seqPreCond_ = nullptr;
+    }
 
 private:
     SequentialPreconditioner *seqPreCond_;
@@ -0,0 +1,171 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::Linear::LinearSolverBackendBase
+ */
+#ifndef EWOMS_LINEAR_SOLVER_BACKEND_BASE_HH
+#define EWOMS_LINEAR_SOLVER_BACKEND_BASE_HH
+
+#include <ewoms/common/timer.hh>
+
+#include <opm/material/common/Unused.hpp>
+
+#include <cstddef>
+
+namespace Ewoms {
+namespace Linear {
+/*!
+ * \ingroup Linear
+ *
+ * \brief Provides default implementations of the optional methods of linear solver
+ *        backends.
+ *
+ * Every backend which is used as the LinearSolverBackend property must provide the
+ * following methods:
+ * \code
+ * static void registerParameters();
+ * void eraseMatrix();
+ * void prepare(const SparseMatrixAdapter& M, const Vector& b);
+ * void setResidual(const Vector& b);
+ * void getResidual(Vector& b) const;
+ * void setMatrix(const SparseMatrixAdapter& M);
+ * bool solve(Vector& x);
+ * \endcode
+ *
+ * Additionally, the Newton method and the discretizations use the methods of this
+ * class, which a backend may override. These are:
+ *
+ * - setReusePreconditioner(): only called if the NewtonEnableJacobianReuse parameter
+ *   is set. The default ignores the request, i.e., the preconditioner is set up anew.
+ * - setRelativeTolerance(), relativeTolerance() and fixedRelativeTolerance(): only
+ *   called if the NewtonEnableEisenstatWalker parameter is set. By default, the
+ *   tolerance is not adapted, which is also what direct solvers do.
+ * - iterations(): used for the statistics of the Newton method. The default reports
+ *   zero iterations.
+ * - resetTimers(), overlapSyncTimer(), setupTimer() and iterationTimer(): used for
+ *   the timing statistics of the simulation. The default timers are never started.
+ *
+ * Backends which do not derive from this class must implement all of these methods.
+ */
+template <class Scalar>
+class LinearSolverBackendBase
+{
+public:
+    /*!
+     * \param setupRegion The name of the profiling region of the setup timer. This
+     *                    must be a string literal.
+     * \param iterationRegion The name of the profiling region of the iteration timer.
+     *                        This must be a string literal.
+     */
+    LinearSolverBackendBase(const char* setupRegion = nullptr,
+                            const char* iterationRegion = nullptr)
+        : setupTimer_(setupRegion)
+        , iterationTimer_(iterationRegion)
+    { }
+
+    /*!
+     * \brief Specify whether the next calls to solve() may use the preconditioner of
+     *        the previous one.
+     *
+     * By default, this is a no-op.
+     */
+    void setReusePreconditioner(bool yesno OPM_UNUSED)
+    { }
+
+    /*!
+     * \brief Set the residual reduction which is required by the next calls to solve().
+     *
+     * By default, this is a no-op.
+     */
+    void setRelativeTolerance(Scalar value OPM_UNUSED)
+    { }
+
+    /*!
+     * \brief Returns the residual reduction which is required by the next calls to
+     *        solve().
+     *
+     * By default, this is zero, i.e., the backend does not have a tolerance which can
+     * be adapted.
+     */
+    Scalar relativeTolerance() const
+    { return 0.0; }
+
+    /*!
+     * \brief Returns the residual reduction which is required if no tolerance has been
+     *        set using setRelativeTolerance().
+     *
+     * By default, this is zero, i.e., the backend is a direct solver or does not have a
+     * tolerance which can be adapted.
+     */
+    Scalar fixedRelativeTolerance() const
+    { return 0.0; }
+
+    /*!
+     * \brief Return number of iterations used during last solve.
+     *
+     * By default, this is zero, i.e., the number is not known.
+     */
+    size_t iterations() const
+    { return 0; }
+
+    /*!
+     * \brief Reset the timers of the linear solver.
+     */
+    void resetTimers()
+    {
+        overlapSyncTimer_.halt();
+        setupTimer_.halt();
+        iterationTimer_.halt();
+    }
+
+    /*!
+     * \brief Returns the timer for synchronizing the linear system with the peer
+     *        processes.
+     */
+    const Ewoms::Timer& overlapSyncTimer() const
+    { return overlapSyncTimer_; }
+
+    /*!
+     * \brief Returns the timer for setting up the solver, e.g., the preconditioner.
+     */
+    const Ewoms::Timer& setupTimer() const
+    { return setupTimer_; }
+
+    /*!
+     * \brief Returns the timer for the actual solution of the linear system.
+     */
+    const Ewoms::Timer& iterationTimer() const
+    { return iterationTimer_; }
+
+protected:
+    Ewoms::Timer overlapSyncTimer_;
+    Ewoms::Timer setupTimer_;
+    Ewoms::Timer iterationTimer_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
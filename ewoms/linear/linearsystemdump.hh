@@ -0,0 +1,277 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::Linear::LinearSystemDump
+ */
+#ifndef EWOMS_LINEAR_SYSTEM_DUMP_HH
+#define EWOMS_LINEAR_SYSTEM_DUMP_HH
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+namespace Linear {
+/*!
+ * \ingroup Linear
+ *
+ * \brief The rows of a linear system of equations which are owned by a single process
+ *        in a compact binary format.
+ *
+ * This allows to capture the linear systems of production runs and to benchmark linear
+ * solvers on them offline. The rows and columns are identified by their global indices,
+ * so the system of a parallel run can be assembled from the files of all processes.
+ *
+ * The file consists of the magic string "EWOMSLS1", the block size (uint32), the number
+ * of rows (uint64), the number of non-zero blocks (uint64), the global indices of the
+ * rows (int64), the offsets of the rows' first blocks (uint64, one more than the number
+ * of rows), the global indices of the columns of the blocks (int64), the entries of the
+ * blocks in row-major order (double) and the right-hand side (double). All data is
+ * stored in the byte order of the writing machine.
+ */
+class LinearSystemDump
+{
+    static const char* magic_()
+    { return "EWOMSLS1"; }
+
+public:
+    LinearSystemDump()
+        : blockSize_(0)
+    { rowOffsets_.push_back(0); }
+
+    /*!
+     * \brief Write the rows of an overlapping linear system of equations which are
+     *        owned by the local process to a file.
+     *
+     * The matrix and the vector are indexed by the domestic indices of the overlap.
+     */
+    template <class Matrix, class Vector, class Overlap>
+    static void write(const std::string& fileName,
+                      const Matrix& A,
+                      const Vector& b,
+                      const Overlap& overlap)
+    {
+        typedef typename Matrix::block_type MatrixBlock;
+        static const unsigned blockSize = MatrixBlock::rows;
+
+        LinearSystemDump dump;
+        dump.blockSize_ = blockSize;
+        for (unsigned rowIdx = 0; rowIdx < A.N(); ++rowIdx) {
+            if (!overlap.iAmMasterOf(static_cast<int>(rowIdx)))
+                continue;
+
+            dump.rowIndices_.push_back(overlap.domesticToGlobal(static_cast<int>(rowIdx)));
+
+            auto colIt = A[rowIdx].begin();
+            const auto& colEndIt = A[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt) {
+                dump.colIndices_.push_back(overlap.domesticToGlobal(static_cast<int>(colIt.index())));
+                for (unsigned i = 0; i < blockSize; ++i)
+                    for (unsigned j = 0; j < blockSize; ++j)
+                        dump.values_.push_back(static_cast<double>((*colIt)[i][j]));
+            }
+            dump.rowOffsets_.push_back(dump.colIndices_.size());
+
+            for (unsigned i = 0; i < blockSize; ++i)
+                dump.rhs_.push_back(static_cast<double>(b[rowIdx][i]));
+        }
+
+        dump.write(fileName);
+    }
+
+    /*!
+     * \brief Write the linear system to a file.
+     */
+    void write(const std::string& fileName) const
+    {
+        std::ofstream os(fileName, std::ios::binary);
+        if (!os)
+            throw std::runtime_error("Could not open file '"+fileName+"' for writing");
+
+        os.write(magic_(), 8);
+        write_(os, static_cast<std::uint32_t>(blockSize_));
+        write_(os, static_cast<std::uint64_t>(rowIndices_.size()));
+        write_(os, static_cast<std::uint64_t>(colIndices_.size()));
+        writeVector_(os, rowIndices_);
+        writeVector_(os, rowOffsets_);
+        writeVector_(os, colIndices_);
+        writeVector_(os, values_);
+        writeVector_(os, rhs_);
+
+        if (!os)
+            throw std::runtime_error("Could not write the linear system to '"+fileName+"'");
+    }
+
+    /*!
+     * \brief Read a linear system from a file.
+     */
+    void read(const std::string& fileName)
+    {
+        std::ifstream is(fileName, std::ios::binary);
+        if (!is)
+            throw std::runtime_error("Could not open file '"+fileName+"'");
+
+        char fileMagic[8];
+        is.read(fileMagic, sizeof(fileMagic));
+        if (!is || std::memcmp(fileMagic, magic_(), sizeof(fileMagic)) != 0)
+            throw std::runtime_error("File '"+fileName+"' does not contain a linear system");
+
+        std::uint32_t blockSize;
+        std::uint64_t numRows;
+        std::uint64_t numBlocks;
+        read_(is, blockSize);
+        read_(is, numRows);
+        read_(is, numBlocks);
+        blockSize_ = blockSize;
+
+        readVector_(is, rowIndices_, numRows);
+        readVector_(is, rowOffsets_, numRows + 1);
+        readVector_(is, colIndices_, numBlocks);
+        readVector_(is, values_, numBlocks*blockSize*blockSize);
+        readVector_(is, rhs_, numRows*blockSize);
+
+        if (!is)
+            throw std::runtime_error("Linear system file '"+fileName+"' is truncated");
+    }
+
+    /*!
+     * \brief Assemble the global linear system from the parts of all processes.
+     *
+     * The matrix and the vector are resized and their structure is created from scratch.
+     */
+    template <class BlockMatrix, class BlockVector>
+    static void assemble(const std::vector<LinearSystemDump>& parts,
+                         BlockMatrix& A,
+                         BlockVector& b)
+    {
+        typedef typename BlockMatrix::block_type MatrixBlock;
+        static const unsigned blockSize = MatrixBlock::rows;
+
+        // determine the size of the system and the sparsity pattern
+        std::int64_t numRows = 0;
+        for (const auto& part : parts) {
+            if (part.blockSize_ != blockSize)
+                throw std::runtime_error("The block size of the linear system does not match");
+            for (std::int64_t rowIdx : part.rowIndices_)
+                numRows = std::max(numRows, rowIdx + 1);
+        }
+
+        std::vector<std::set<std::int64_t> > sparsityPattern(static_cast<size_t>(numRows));
+        for (const auto& part : parts)
+            for (size_t i = 0; i < part.rowIndices_.size(); ++i)
+                for (auto k = part.rowOffsets_[i]; k < part.rowOffsets_[i + 1]; ++k)
+                    sparsityPattern[static_cast<size_t>(part.rowIndices_[i])].insert(part.colIndices_[k]);
+
+        A.setSize(static_cast<size_t>(numRows), static_cast<size_t>(numRows));
+        A.setBuildMode(BlockMatrix::random);
+        for (size_t rowIdx = 0; rowIdx < sparsityPattern.size(); ++rowIdx)
+            A.setrowsize(rowIdx, sparsityPattern[rowIdx].size());
+        A.endrowsizes();
+        for (size_t rowIdx = 0; rowIdx < sparsityPattern.size(); ++rowIdx)
+            for (std::int64_t colIdx : sparsityPattern[rowIdx])
+                A.addindex(rowIdx, static_cast<size_t>(colIdx));
+        A.endindices();
+
+        // copy the entries
+        A = 0.0;
+        b.resize(static_cast<size_t>(numRows));
+        b = 0.0;
+        for (const auto& part : parts) {
+            for (size_t i = 0; i < part.rowIndices_.size(); ++i) {
+                size_t rowIdx = static_cast<size_t>(part.rowIndices_[i]);
+                for (unsigned j = 0; j < blockSize; ++j)
+                    b[rowIdx][j] = part.rhs_[i*blockSize + j];
+
+                for (auto k = part.rowOffsets_[i]; k < part.rowOffsets_[i + 1]; ++k) {
+                    auto& block = A[rowIdx][static_cast<size_t>(part.colIndices_[k])];
+                    const double* values = &part.values_[k*blockSize*blockSize];
+                    for (unsigned j1 = 0; j1 < blockSize; ++j1)
+                        for (unsigned j2 = 0; j2 < blockSize; ++j2)
+                            block[j1][j2] = values[j1*blockSize + j2];
+                }
+            }
+        }
+    }
+
+    /*!
+     * \brief Returns the size of the matrix blocks.
+     */
+    unsigned blockSize() const
+    { return blockSize_; }
+
+    /*!
+     * \brief Returns the number of rows stored in the dump.
+     */
+    size_t numRows() const
+    { return rowIndices_.size(); }
+
+    /*!
+     * \brief Returns the number of non-zero blocks stored in the dump.
+     */
+    size_t numBlocks() const
+    { return colIndices_.size(); }
+
+private:
+    template <class T>
+    static void write_(std::ostream& os, const T& value)
+    { os.write(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+    template <class T>
+    static void read_(std::istream& is, T& value)
+    { is.read(reinterpret_cast<char*>(&value), sizeof(value)); }
+
+    template <class T>
+    static void writeVector_(std::ostream& os, const std::vector<T>& values)
+    {
+        if (!values.empty())
+            os.write(reinterpret_cast<const char*>(values.data()),
+                     static_cast<std::streamsize>(values.size()*sizeof(T)));
+    }
+
+    template <class T>
+    static void readVector_(std::istream& is, std::vector<T>& values, std::uint64_t size)
+    {
+        values.resize(static_cast<size_t>(size));
+        if (!values.empty())
+            is.read(reinterpret_cast<char*>(values.data()),
+                    static_cast<std::streamsize>(values.size()*sizeof(T)));
+    }
+
+    unsigned blockSize_;
+    std::vector<std::int64_t> rowIndices_;
+    std::vector<std::uint64_t> rowOffsets_;
+    std::vector<std::int64_t> colIndices_;
+    std::vector<double> values_;
+    std::vector<double> rhs_;
+};
+
+}} // namespace Linear, Ewoms
+
+#endif
@@ -182,6 +182,9 @@ protected:
         return amg_;
     }
 
+    std::shared_ptr<AMG> currentPreconditioner_()
+    { return amg_; }
+
     void cleanupPreconditioner_()
     { /* nothing to do */ }
 
@@ -192,7 +195,7 @@ protected:
         const auto& gridView = this->simulator_.gridView();
         typedef CombinedCriterion<OverlappingVector, decltype(gridView.comm())> CCC;
 
-        Scalar linearSolverTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
+        Scalar linearSolverTolerance = this->relativeTolerance();
         Scalar linearSolverAbsTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverAbsTolerance);
         if(linearSolverAbsTolerance < 0.0)
             linearSolverAbsTolerance = this->simulator_.model().newtonMethod().tolerance()/100.0;
@@ -35,8 +35,12 @@
 #include <ewoms/linear/overlappingoperator.hh>
 #include <ewoms/linear/parallelbasebackend.hh>
 #include <ewoms/linear/istlpreconditionerwrappers.hh>
+#include <ewoms/linear/linearsystemdump.hh>
 
 #include <ewoms/common/genericguard.hh>
+#include <ewoms/common/timer.hh>
+#include <ewoms/common/timerguard.hh>
+#include <ewoms/common/memoryregistry.hh>
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
 #include <ewoms/linear/matrixblock.hh>
@@ -49,6 +53,10 @@
 #include <sstream>
 #include <memory>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 BEGIN_PROPERTIES
 NEW_TYPE_TAG(ParallelBaseLinearSolver);
@@ -116,6 +124,23 @@ NEW_PROP_TAG(PreconditionerOrder);
 //! The relaxation factor of the preconditioner
 NEW_PROP_TAG(PreconditionerRelaxation);
 
+/*!
+ * \brief The prefix of the files to which the linear systems of equations are written.
+ *
+ * If this is empty, no linear systems are written. Each process writes the rows which it
+ * owns to a separate file, see Ewoms::Linear::LinearSystemDump.
+ */
+NEW_PROP_TAG(LinearSystemDumpFile);
+
+/*!
+ * \brief Specifies the linear systems which are written to disk.
+ *
+ * This is a comma separated list of "timeStepIdx:newtonIterationIdx" pairs, where '*'
+ * matches any index. If the Newton iteration is omitted, all systems of the time step
+ * are written. An empty list selects all linear systems.
+ */
+NEW_PROP_TAG(LinearSystemDumpSelection);
+
 //! Set the type of a global jacobian matrix for linear solvers that are based on
 //! dune-istl.
 SET_PROP(ParallelBaseLinearSolver, SparseMatrixAdapter)
@@ -158,6 +183,10 @@ namespace Linear {
  *            that it is computationally cheaper because it does not
  *            need to consider things which are only required for
  *            higher orders
+ *
+ * Besides the mandatory methods, this class implements all optional methods of the
+ * linear solver backend interface which is described by
+ * Ewoms::Linear::LinearSolverBackendBase.
  */
 template <class TypeTag>
 class ParallelBaseBackend
@@ -193,10 +222,37 @@ public:
         : simulator_(simulator)
         , gridSequenceNumber_( -1 )
         , lastIterations_( -1 )
+        , overlapSyncTimer_("overlap synchronization")
+        , setupTimer_("prepare preconditioner")
+        , iterationTimer_("run linear solver")
     {
         overlappingMatrix_ = nullptr;
         overlappingb_ = nullptr;
         overlappingx_ = nullptr;
+
+        keepPreconditioner_ = false;
+        reusePreconditioner_ = false;
+        preconditionerReady_ = false;
+        relativeToleranceOverride_ = -1.0;
+
+        parseDumpSelection_(EWOMS_GET_PARAM(TypeTag, std::string, LinearSystemDumpSelection));
+
+        auto& memoryRegistry = simulator.memoryRegistry();
+        memoryRegistry.add("overlapping matrix",
+                           [this]() -> size_t
+                           { return overlappingMatrix_ ? bcrsMatrixMemoryUsage(*overlappingMatrix_) : 0; });
+        memoryRegistry.add("overlapping vectors",
+                           [this]() -> size_t
+                           {
+                               if (!overlappingb_)
+                                   return 0;
+                               return
+                                   blockVectorMemoryUsage(*overlappingb_)
+                                   + blockVectorMemoryUsage(*overlappingx_);
+                           });
+        memoryRegistry.add("overlap index structures",
+                           [this]() -> size_t
+                           { return overlappingMatrix_ ? overlappingMatrix_->overlap().memoryUsage() : 0; });
     }
 
     ~ParallelBaseBackend()
@@ -217,6 +273,12 @@ public:
                              "The maximum number of iterations of the linear solver");
         EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverVerbosity,
                              "The verbosity level of the linear solver");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, LinearSystemDumpFile,
+                             "The prefix of the files to which the linear systems are "
+                             "written. If empty, no linear systems are written");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, LinearSystemDumpSelection,
+                             "A comma separated list of 'timeStepIdx:newtonIterationIdx' "
+                             "pairs which select the linear systems to be written");
 
         PreconditionerWrapper::registerParameters();
     }
@@ -271,6 +333,9 @@ public:
      */
     void setResidual(const Vector& b)
     {
+        Ewoms::TimerGuard overlapSyncTimerGuard(overlapSyncTimer_);
+        overlapSyncTimer_.start();
+
         // copy the interior values of the non-overlapping residual vector to the
         // overlapping one
         overlappingb_->assignAddBorder(b);
@@ -295,10 +360,59 @@ public:
      */
     void setMatrix(const SparseMatrixAdapter& M)
     {
+        Ewoms::TimerGuard overlapSyncTimerGuard(overlapSyncTimer_);
+        overlapSyncTimer_.start();
+
         overlappingMatrix_->assignFromNative(M.istlMatrix());
         overlappingMatrix_->syncAdd();
     }
 
+    /*!
+     * \brief Specify whether the next calls to solve() may use the preconditioner of
+     *        the previous one.
+     *
+     * This is only sensible if the matrix has not been changed using setMatrix() in
+     * the meantime, e.g. if the Newton method reuses the Jacobian of a previous
+     * iteration. Once this method has been called, the preconditioner is kept after
+     * each call to solve() so that it is available for reuse; otherwise it is
+     * released as soon as the linear system has been solved.
+     */
+    void setReusePreconditioner(bool yesno)
+    {
+        keepPreconditioner_ = true;
+        reusePreconditioner_ = yesno;
+    }
+
+    /*!
+     * \brief Set the residual reduction which is required by the next calls to solve().
+     *
+     * This is used by inexact Newton methods which adapt the accuracy of the linear
+     * solver to the progress of the non-linear iterations. If the value is not
+     * positive, the value of the LinearSolverTolerance parameter is used.
+     */
+    void setRelativeTolerance(Scalar value)
+    { relativeToleranceOverride_ = value; }
+
+    /*!
+     * \brief Returns the residual reduction which is required by the next calls to
+     *        solve().
+     */
+    Scalar relativeTolerance() const
+    {
+        if (relativeToleranceOverride_ > 0.0)
+            return relativeToleranceOverride_;
+        return fixedRelativeTolerance();
+    }
+
+    /*!
+     * \brief Returns the residual reduction which is required if no tolerance has been
+     *        set using setRelativeTolerance().
+     *
+     * This is the value of the LinearSolverTolerance parameter.
+     */
+    Scalar fixedRelativeTolerance() const
+    { return EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance); }
+
     /*!
      * \brief Actually solve the linear system of equations.
      *
@@ -313,10 +427,34 @@ public:
 
         (*overlappingx_) = 0.0;
 
-        auto parPreCond = asImp_().preparePreconditioner_();
-        auto precondCleanupFn = [this]() -> void
-                                { this->asImp_().cleanupPreconditioner_(); };
+        dumpLinearSystem_();
+
+        // if the preconditioner may be reused, it is kept until the next one is set
+        // up. else it is released after the linear system has been solved.
+        decltype(asImp_().preparePreconditioner_()) parPreCond;
+        if (reusePreconditioner_ && preconditionerReady_)
+            parPreCond = asImp_().currentPreconditioner_();
+        else {
+            Ewoms::TimerGuard setupTimerGuard(setupTimer_);
+            setupTimer_.start();
+            if (preconditionerReady_) {
+                asImp_().cleanupPreconditioner_();
+                preconditionerReady_ = false;
+            }
+            parPreCond = asImp_().preparePreconditioner_();
+            preconditionerReady_ = true;
+        }
+
+        auto precondCleanupFn =
+            [this]() -> void
+            {
+                if (!this->keepPreconditioner_) {
+                    this->asImp_().cleanupPreconditioner_();
+                    this->preconditionerReady_ = false;
+                }
+            };
         auto precondCleanupGuard = Ewoms::make_guard(precondCleanupFn);
+
         // create the parallel scalar product and the parallel operator
         ParallelScalarProduct parScalarProduct(overlappingMatrix_->overlap());
         ParallelOperator parOperator(*overlappingMatrix_);
@@ -332,7 +470,12 @@ public:
         GenericGuard<decltype(cleanupSolverFn)> solverGuard(cleanupSolverFn);
 
         // run the linear solver and have some fun
-        auto result = asImp_().runSolver_(solver);
+        decltype(asImp_().runSolver_(solver)) result;
+        {
+            Ewoms::TimerGuard iterationTimerGuard(iterationTimer_);
+            iterationTimer_.start();
+            result = asImp_().runSolver_(solver);
+        }
         // store number of iterations used
         lastIterations_ = result.second;
 
@@ -349,6 +492,35 @@ public:
     size_t iterations () const
     { return lastIterations_; }
 
+    /*!
+     * \brief Reset the timers of the linear solver.
+     */
+    void resetTimers()
+    {
+        overlapSyncTimer_.halt();
+        setupTimer_.halt();
+        iterationTimer_.halt();
+    }
+
+    /*!
+     * \brief Returns the timer for synchronizing the residual and the Jacobian matrix
+     *        with the peer processes.
+     */
+    const Ewoms::Timer& overlapSyncTimer() const
+    { return overlapSyncTimer_; }
+
+    /*!
+     * \brief Returns the timer for setting up the preconditioner.
+     */
+    const Ewoms::Timer& setupTimer() const
+    { return setupTimer_; }
+
+    /*!
+     * \brief Returns the timer for the iterations of the linear solver.
+     */
+    const Ewoms::Timer& iterationTimer() const
+    { return iterationTimer_; }
+
 protected:
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
@@ -358,6 +530,12 @@ protected:
 
     void cleanup_()
     {
+        // the preconditioner refers to the overlapping matrix. (this only releases
+        // the preconditioners of the ISTL wrappers; the ones which are managed by
+        // derived classes are set up again by the next solve() call.)
+        precWrapper_.cleanup();
+        preconditionerReady_ = false;
+
         // create the overlapping Jacobian matrix and vectors
         delete overlappingMatrix_;
         delete overlappingb_;
@@ -385,18 +563,97 @@ protected:
         // make sure that the preconditioner is also ready on all peer
         // ranks.
         preconditionerIsReady = simulator_.gridView().comm().min(preconditionerIsReady);
-        if (!preconditionerIsReady)
+        if (!preconditionerIsReady) {
+            precWrapper_.cleanup();
             throw Opm::NumericalIssue("Creating the preconditioner failed");
+        }
 
-        // create the parallel preconditioner
-        return std::make_shared<ParallelPreconditioner>(precWrapper_.get(), overlappingMatrix_->overlap());
+        return currentPreconditioner_();
     }
 
+    // create the parallel preconditioner for the sequential one which has already been
+    // set up
+    std::shared_ptr<ParallelPreconditioner> currentPreconditioner_()
+    { return std::make_shared<ParallelPreconditioner>(precWrapper_.get(), overlappingMatrix_->overlap()); }
+
     void cleanupPreconditioner_()
     {
         precWrapper_.cleanup();
     }
 
+    // write the part of the linear system owned by the local process to disk if this
+    // has been requested for the current time step and Newton iteration
+    void dumpLinearSystem_() const
+    {
+        const std::string& prefix = EWOMS_GET_PARAM(TypeTag, std::string, LinearSystemDumpFile);
+        if (prefix.empty())
+            return;
+
+        int timeStepIdx = simulator_.timeStepIndex();
+        int newtonIterIdx = static_cast<int>(simulator_.model().newtonMethod().numIterations());
+        if (!dumpSelected_(timeStepIdx, newtonIterIdx))
+            return;
+
+        const auto& overlap = overlappingMatrix_->overlap();
+        std::ostringstream oss;
+        oss << prefix
+            << "-t" << timeStepIdx
+            << "-i" << newtonIterIdx
+            << "-p" << overlap.myRank()
+            << ".linsys";
+        LinearSystemDump::write(oss.str(), *overlappingMatrix_, *overlappingb_, overlap);
+    }
+
+    bool dumpSelected_(int timeStepIdx, int newtonIterIdx) const
+    {
+        if (dumpSelection_.empty())
+            return true;
+
+        for (const auto& entry : dumpSelection_) {
+            if ((entry.first < 0 || entry.first == timeStepIdx)
+                && (entry.second < 0 || entry.second == newtonIterIdx))
+                return true;
+        }
+
+        return false;
+    }
+
+    // convert the value of the LinearSystemDumpSelection parameter to a list of
+    // (timeStepIdx, newtonIterationIdx) pairs. wildcards are represented by -1.
+    void parseDumpSelection_(const std::string& selection)
+    {
+        dumpSelection_.clear();
+        if (selection.empty())
+            return;
+
+        std::istringstream iss(selection);
+        std::string entry;
+        while (std::getline(iss, entry, ',')) {
+            size_t colonPos = entry.find(':');
+            std::string timeStepPattern = entry.substr(0, colonPos);
+            std::string iterationPattern =
+                (colonPos == std::string::npos) ? "" : entry.substr(colonPos + 1);
+
+            dumpSelection_.emplace_back(parseDumpPattern_(timeStepPattern, entry),
+                                        parseDumpPattern_(iterationPattern, entry));
+        }
+    }
+
+    static int parseDumpPattern_(const std::string& pattern, const std::string& entry)
+    {
+        if (pattern.empty() || pattern == "*")
+            return -1;
+
+        if (pattern.find_first_not_of("0123456789") != std::string::npos
+            || pattern.size() > 9)
+            throw std::invalid_argument("Invalid entry '"+entry+"' in the LinearSystemDumpSelection "
+                                        "parameter: Expected a comma separated list of "
+                                        "'timeStepIdx:newtonIterationIdx' pairs where each index "
+                                        "is either a non-negative integer or '*'");
+
+        return std::stoi(pattern);
+    }
+
     void writeOverlapToVTK_()
     {
         for (int lookedAtRank = 0;
@@ -438,11 +695,28 @@ protected:
     int gridSequenceNumber_;
     size_t lastIterations_;
 
+    Ewoms::Timer overlapSyncTimer_;
+    Ewoms::Timer setupTimer_;
+    Ewoms::Timer iterationTimer_;
+
     OverlappingMatrix *overlappingMatrix_;
     OverlappingVector *overlappingb_;
     OverlappingVector *overlappingx_;
 
     PreconditionerWrapper precWrapper_;
+
+    // specifies if the preconditioner is kept after solving, if the one of the
+    // previous solve may be used again and if there is one
+    bool keepPreconditioner_;
+    bool reusePreconditioner_;
+    bool preconditionerReady_;
+
+    // the residual reduction requested by the Newton method. if it is not positive,
+    // the LinearSolverTolerance parameter is used
+    Scalar relativeToleranceOverride_;
+
+    // the linear systems which ought to be written to disk if LinearSystemDumpFile is set
+    std::vector<std::pair<int, int> > dumpSelection_;
 };
 }} // namespace Linear, Ewoms
 
@@ -451,6 +725,10 @@ BEGIN_PROPERTIES
 //! make the linear solver shut up by default
 SET_INT_PROP(ParallelBaseLinearSolver, LinearSolverVerbosity, 0);
 
+//! do not write the linear systems of equations to disk by default
+SET_STRING_PROP(ParallelBaseLinearSolver, LinearSystemDumpFile, "");
+SET_STRING_PROP(ParallelBaseLinearSolver, LinearSystemDumpSelection, "");
+
 //! set the preconditioner relaxation parameter to 1.0 by default
 SET_SCALAR_PROP(ParallelBaseLinearSolver, PreconditionerRelaxation, 1.0);
 
@@ -125,7 +125,8 @@ protected:
     {
         return solverWrapper_.get(parOperator,
                                   parScalarProduct,
-                                  parPreCond);
+                                  parPreCond,
+                                  this->relativeTolerance());
     }
 
     void cleanupSolver_()
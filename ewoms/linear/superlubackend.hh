@@ -30,7 +30,10 @@
 #if HAVE_SUPERLU
 
 #include <ewoms/linear/istlsparsematrixbackend.hh>
+#include <ewoms/linear/linearsolverbackendbase.hh>
 #include <ewoms/common/parametersystem.hh>
+#include <ewoms/common/timer.hh>
+#include <ewoms/common/timerguard.hh>
 
 #include <opm/material/common/Unused.hpp>
 
@@ -63,7 +66,9 @@ class SuperLUSolve_;
  */
 template <class TypeTag>
 class SuperLUBackend
+    : public LinearSolverBackendBase<typename GET_PROP_TYPE(TypeTag, Scalar)>
 {
+    typedef LinearSolverBackendBase<typename GET_PROP_TYPE(TypeTag, Scalar)> ParentType;
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
     typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
     typedef typename GET_PROP_TYPE(TypeTag, SparseMatrixAdapter) SparseMatrixAdapter;
@@ -74,6 +79,7 @@ class SuperLUBackend
 
 public:
     SuperLUBackend(Simulator& simulator OPM_UNUSED)
+        : ParentType("factorize matrix", "run linear solver")
     {}
 
     static void registerParameters()
@@ -104,7 +110,19 @@ public:
     { M_ = &M; }
 
     bool solve(Vector& x)
-    { return SuperLUSolve_<Scalar, TypeTag, Matrix, Vector>::solve_(*M_, x, *b_); }
+    {
+        return SuperLUSolve_<Scalar, TypeTag, Matrix, Vector>::solve_(*M_, x, *b_,
+                                                                     this->setupTimer_,
+                                                                     this->iterationTimer_);
+    }
+
+    /*!
+     * \brief Return number of iterations used during last solve.
+     *
+     * SuperLU is a direct solver, so this is always one.
+     */
+    size_t iterations () const
+    { return 1; }
 
 private:
     const Matrix* M_;
@@ -115,14 +133,26 @@ template <class Scalar, class TypeTag, class Matrix, class Vector>
 class SuperLUSolve_
 {
 public:
-    static bool solve_(const Matrix& A, Vector& x, const Vector& b)
+    static bool solve_(const Matrix& A,
+                       Vector& x,
+                       const Vector& b,
+                       Ewoms::Timer& setupTimer,
+                       Ewoms::Timer& iterationTimer)
     {
         Vector bTmp(b);
 
         int verbosity = EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity);
         Dune::InverseOperatorResult result;
+
+        Ewoms::TimerGuard setupTimerGuard(setupTimer);
+        setupTimer.start();
         Dune::SuperLU<Matrix> solver(A, verbosity > 0);
+        setupTimer.stop();
+
+        Ewoms::TimerGuard iterationTimerGuard(iterationTimer);
+        iterationTimer.start();
         solver.apply(x, bTmp, result);
+        iterationTimer.stop();
 
         if (result.converged) {
             // make sure that the result only contains finite values.
@@ -150,7 +180,9 @@ class SuperLUSolve_<__float128, TypeTag, Matrix, Vector>
 public:
     static bool solve_(const Matrix& A,
                        Vector& x,
-                       const Vector& b)
+                       const Vector& b,
+                       Ewoms::Timer& setupTimer,
+                       Ewoms::Timer& iterationTimer)
     {
         static const int numEq = GET_PROP_VALUE(TypeTag, NumEq);
         typedef Dune::FieldVector<double, numEq> DoubleEqVector;
@@ -166,7 +198,9 @@ public:
         bool res =
             SuperLUSolve_<double, TypeTag, Matrix, Vector>::solve_(ADouble,
                                                                    xDouble,
-                                                                   bDouble);
+                                                                   bDouble,
+                                                                   setupTimer,
+                                                                   iterationTimer);
 
         // copy the result back into the quadruple precision vector.
         x = xDouble;
@@ -324,6 +324,57 @@ public:
         return oss.str();
     }
 
+    /*!
+     * \copydoc FvBaseDiscretization::primaryVarsCompatible
+     */
+    bool primaryVarsCompatible(unsigned globalDofIdx OPM_UNUSED,
+                               const PrimaryVariables& pv1,
+                               const PrimaryVariables& pv2) const
+    { return pv1.primaryVarsMeaning() == pv2.primaryVarsMeaning(); }
+
+    /*!
+     * \copydoc FvBaseDiscretization::primaryVarsAdmissible
+     */
+    bool primaryVarsAdmissible(unsigned globalDofIdx, const PrimaryVariables& pv) const
+    {
+        if (!ParentType::primaryVarsAdmissible(globalDofIdx, pv))
+            return false;
+
+        // the saturations must be within [0, 1] and the dissolution factors must not
+        // be negative
+        Scalar sumSat = 0.0;
+        if (waterEnabled) {
+            Scalar Sw = pv[Indices::waterSaturationIdx];
+            if (Sw < 0.0 || Sw > 1.0)
+                return false;
+            sumSat += Sw;
+        }
+
+        if (compositionSwitchEnabled) {
+            Scalar x = pv[Indices::compositionSwitchIdx];
+            if (x < 0.0)
+                return false;
+            if (pv.primaryVarsMeaning() == PrimaryVariables::Sw_po_Sg) {
+                if (x > 1.0)
+                    return false;
+                sumSat += x;
+            }
+        }
+
+        if (Indices::solventSaturationIdx >= 0) {
+            Scalar Ss = pv[Indices::solventSaturationIdx];
+            if (Ss < 0.0 || Ss > 1.0)
+                return false;
+            sumSat += Ss;
+        }
+
+        if (Indices::polymerConcentrationIdx >= 0
+            && pv[Indices::polymerConcentrationIdx] < 0.0)
+            return false;
+
+        return sumSat <= 1.0;
+    }
+
     /*!
      * \copydoc FvBaseDiscretization::primaryVarWeight
      */
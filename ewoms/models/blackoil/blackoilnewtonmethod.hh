@@ -121,27 +121,17 @@ protected:
     }
 
     /*!
-     * \copydoc FvBaseNewtonMethod::endIteration_
+     * \copydoc NewtonMethod::syncIteration_
      */
-    void endIteration_(SolutionVector& uCurrentIter,
-                       const SolutionVector& uLastIter)
+    void syncIteration_()
     {
-#if HAVE_MPI
-        // in the MPI enabled case we need to add up the number of DOF
-        // for which the interpretation changed over all processes.
-        int localSwitched = numPriVarsSwitched_;
-        MPI_Allreduce(&localSwitched,
-                      &numPriVarsSwitched_,
-                      /*num=*/1,
-                      MPI_INT,
-                      MPI_SUM,
-                      MPI_COMM_WORLD);
-#endif // HAVE_MPI
-
-        this->simulator_.model().newtonMethod().endIterMsg()
-            << ", num switched=" << numPriVarsSwitched_;
-
-        ParentType::endIteration_(uCurrentIter, uLastIter);
+        // add up the number of DOF for which the interpretation changed over all
+        // processes using the same reduction as the failure flags
+        unsigned switchedIdx = this->collectives_.addSum(numPriVarsSwitched_);
+        ParentType::syncIteration_();
+        numPriVarsSwitched_ = static_cast<int>(this->collectives_.sum(switchedIdx));
+
+        this->endIterMsg() << ", num switched=" << numPriVarsSwitched_;
     }
 
 public:
@@ -152,25 +142,23 @@ public:
     {
         const auto& comm = this->simulator_.gridView().comm();
 
-        int succeeded;
+        bool succeeded;
         try {
             ParentType::update_(nextSolution,
                                 currentSolution,
                                 solutionUpdate,
                                 currentResidual);
-            succeeded = 1;
+            succeeded = true;
         }
         catch (...) {
             std::cout << "Newton update threw an exception on rank "
                       << comm.rank() << "\n";
-            succeeded = 0;
+            succeeded = false;
         }
-        succeeded = comm.min(succeeded);
-
-        if (!succeeded)
-            throw Opm::NumericalIssue("A process did not succeed in adapting the primary variables");
 
-        numPriVarsSwitched_ = comm.sum(numPriVarsSwitched_);
+        // the failure and the number of switched primary variables are communicated to
+        // the peer processes by syncIteration_()
+        this->collectives_.addFailure(!succeeded, ParentType::updateFailure);
     }
 
 protected:
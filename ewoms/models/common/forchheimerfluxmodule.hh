@@ -33,6 +33,7 @@
 #include "darcyfluxmodule.hh"
 
 #include <ewoms/disc/common/fvbaseproperties.hh>
+#include <ewoms/common/inneriterationcounter.hh>
 
 #include <opm/material/common/Valgrind.hpp>
 #include <opm/material/common/Unused.hpp>
@@ -458,6 +459,7 @@ protected:
                 throw Opm::NumericalIssue("Could not determine Forchheimer velocity within "
                                             +std::to_string(newtonIter)+" iterations");
             ++newtonIter;
+            InnerIterationCounter::add();
 
             // calculate the residual and its Jacobian matrix
             gradForchheimerResid_(residual, gradResid, phaseIdx);
@@ -33,6 +33,7 @@
 
 #include <ewoms/models/common/energymodule.hh>
 #include <ewoms/models/common/diffusionmodule.hh>
+#include <ewoms/common/inneriterationcounter.hh>
 
 #include <opm/material/fluidstates/CompositionalFluidState.hpp>
 #include <opm/material/common/Valgrind.hpp>
@@ -134,6 +135,7 @@ public:
                                                  paramCache,
                                                  cTotal,
                                                  flashTolerance);
+        InnerIterationCounter::add();
 
         // calculate relative permeabilities
         MaterialLaw::relativePermeabilities(relativePermeability_,
@@ -185,6 +185,7 @@ class FlashModel
     typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
 
     typedef typename GET_PROP_TYPE(TypeTag, Indices) Indices;
+    typedef typename GET_PROP_TYPE(TypeTag, PrimaryVariables) PrimaryVariables;
 
     enum { numComponents = GET_PROP_VALUE(TypeTag, NumComponents) };
     enum { enableDiffusion = GET_PROP_VALUE(TypeTag, EnableDiffusion) };
@@ -266,6 +267,22 @@ public:
         return oss.str();
     }
 
+    /*!
+     * \copydoc FvBaseDiscretization::primaryVarsAdmissible
+     */
+    bool primaryVarsAdmissible(unsigned globalDofIdx, const PrimaryVariables& pv) const
+    {
+        if (!ParentType::primaryVarsAdmissible(globalDofIdx, pv))
+            return false;
+
+        // the total concentrations of the components must not be negative
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            if (pv[Indices::cTot0Idx + compIdx] < 0.0)
+                return false;
+
+        return true;
+    }
+
     /*!
      * \copydoc FvBaseDiscretization::primaryVarWeight
      */
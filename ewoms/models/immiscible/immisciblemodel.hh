@@ -204,6 +204,7 @@ class ImmiscibleModel
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
     typedef typename GET_PROP_TYPE(TypeTag, Indices) Indices;
     typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
+    typedef typename GET_PROP_TYPE(TypeTag, PrimaryVariables) PrimaryVariables;
 
     enum { numComponents = FluidSystem::numComponents };
 
@@ -299,6 +300,26 @@ public:
         }
     }
 
+    /*!
+     * \copydoc FvBaseDiscretization::primaryVarsAdmissible
+     */
+    bool primaryVarsAdmissible(unsigned globalDofIdx, const PrimaryVariables& pv) const
+    {
+        if (!ParentType::primaryVarsAdmissible(globalDofIdx, pv))
+            return false;
+
+        // the saturations of all phases must be within [0, 1]
+        Scalar sumSat = 0.0;
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases - 1; ++phaseIdx) {
+            Scalar S = pv[Indices::saturation0Idx + phaseIdx];
+            if (S < 0.0 || S > 1.0)
+                return false;
+            sumSat += S;
+        }
+
+        return sumSat <= 1.0;
+    }
+
     /*!
      * \copydetails FvBaseDiscretization::primaryVarWeight
      */
@@ -206,6 +206,7 @@ class NcpModel
     typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
     typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
     typedef typename GET_PROP_TYPE(TypeTag, Indices) Indices;
+    typedef typename GET_PROP_TYPE(TypeTag, PrimaryVariables) PrimaryVariables;
 
     enum { numPhases = FluidSystem::numPhases };
     enum { numComponents = FluidSystem::numComponents };
@@ -359,6 +360,30 @@ public:
         }
     }
 
+    /*!
+     * \copydoc FvBaseDiscretization::primaryVarsAdmissible
+     */
+    bool primaryVarsAdmissible(unsigned globalDofIdx, const PrimaryVariables& pv) const
+    {
+        if (!ParentType::primaryVarsAdmissible(globalDofIdx, pv))
+            return false;
+
+        // the saturations must be within [0, 1] and the fugacities must not be negative
+        Scalar sumSat = 0.0;
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases - 1; ++phaseIdx) {
+            Scalar S = pv[saturation0Idx + phaseIdx];
+            if (S < 0.0 || S > 1.0)
+                return false;
+            sumSat += S;
+        }
+
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            if (pv[fugacity0Idx + compIdx] < 0.0)
+                return false;
+
+        return sumSat <= 1.0;
+    }
+
     /*!
      * \copydoc FvBaseDiscretization::primaryVarWeight
      */
@@ -50,6 +50,7 @@
 #include <opm/material/fluidmatrixinteractions/NullMaterial.hpp>
 #include <opm/material/fluidmatrixinteractions/MaterialTraits.hpp>
 #include <opm/material/common/Exceptions.hpp>
+#include <opm/material/common/Unused.hpp>
 
 #include <iostream>
 #include <sstream>
@@ -353,6 +354,32 @@ public:
         }
     }
 
+    /*!
+     * \copydoc FvBaseDiscretization::primaryVarsCompatible
+     */
+    bool primaryVarsCompatible(unsigned globalDofIdx OPM_UNUSED,
+                               const PrimaryVariables& pv1,
+                               const PrimaryVariables& pv2) const
+    { return pv1.phasePresence() == pv2.phasePresence(); }
+
+    /*!
+     * \copydoc FvBaseDiscretization::primaryVarsAdmissible
+     */
+    bool primaryVarsAdmissible(unsigned globalDofIdx, const PrimaryVariables& pv) const
+    {
+        if (!ParentType::primaryVarsAdmissible(globalDofIdx, pv))
+            return false;
+
+        // the switching primary variables are either saturations or mole fractions
+        for (unsigned switchIdx = 0; switchIdx < numComponents - 1; ++switchIdx) {
+            Scalar x = pv[Indices::switch0Idx + switchIdx];
+            if (x < 0.0 || x > 1.0)
+                return false;
+        }
+
+        return true;
+    }
+
     /*!
      * \copydoc FvBaseDiscretization::primaryVarWeight
      */
@@ -0,0 +1,296 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::AndersonAcceleration
+ */
+#ifndef EWOMS_ANDERSON_ACCELERATION_HH
+#define EWOMS_ANDERSON_ACCELERATION_HH
+
+#include <ewoms/common/memoryregistry.hh>
+
+#include <dune/common/dynmatrix.hh>
+#include <dune/common/dynvector.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace Ewoms {
+
+/*!
+ * \ingroup Newton
+ *
+ * \brief Anderson acceleration of the updates of a Newton-type method.
+ *
+ * The Newton method is regarded as the fixed-point iteration x_(k+1) = x_k + f_k with
+ * f_k = -deltaX_k. Anderson acceleration (in the formulation of Walker and Ni, 2011)
+ * keeps the differences DeltaX_i = x_(i+1) - x_i of the last m iterates and the
+ * differences DeltaF_i = f_(i+1) - f_i of their updates, determines the coefficients
+ * gamma which minimize the weighted norm of f_k - sum_i gamma_i DeltaF_i and uses
+ * x_(k+1) = x_k + f_k - sum_i gamma_i (DeltaX_i + DeltaF_i).
+ *
+ * Blocks (i.e., degrees of freedom) which are marked as incompatible within the
+ * history are updated by the plain step and are not considered for the
+ * least-squares problem.
+ */
+template <class SolutionVector, class UpdateVector>
+class AndersonAcceleration
+{
+    typedef typename UpdateVector::field_type Scalar;
+
+public:
+    AndersonAcceleration(unsigned depth = 0)
+        : depth_(depth)
+        , hasLastIterate_(false)
+    {}
+
+    /*!
+     * \brief Set the maximum number of previous iterations which are used.
+     *
+     * This discards the history.
+     */
+    void setDepth(unsigned depth)
+    {
+        depth_ = depth;
+        clear();
+    }
+
+    /*!
+     * \brief Returns the maximum number of previous iterations which are used.
+     */
+    unsigned depth() const
+    { return depth_; }
+
+    /*!
+     * \brief Discard the history.
+     */
+    void clear()
+    {
+        deltaX_.clear();
+        deltaF_.clear();
+        lastIterate_.resize(0);
+        lastStep_.resize(0);
+        excluded_.clear();
+        hasLastIterate_ = false;
+    }
+
+    /*!
+     * \brief Returns the number of iterations which are currently stored in the history.
+     */
+    unsigned historySize() const
+    { return static_cast<unsigned>(deltaF_.size()); }
+
+    /*!
+     * \brief Returns true if a block is updated by the plain step.
+     */
+    bool isExcluded(unsigned blockIdx) const
+    { return blockIdx < excluded_.size() && excluded_[blockIdx]; }
+
+    /*!
+     * \brief Add an iterate and its plain update to the history.
+     *
+     * \param x The current iterate x_k
+     * \param deltaX The plain update of the current iterate, i.e., x_k - deltaX_k is
+     *               the next iterate of the unaccelerated method
+     * \param compatible A functor (blockIdx, xNew, xOld) -> bool which returns false
+     *                   if a block of the current iterate cannot be compared with the
+     *                   one of the previous iterate
+     */
+    template <class Compatible>
+    void push(const SolutionVector& x,
+              const UpdateVector& deltaX,
+              const Compatible& compatible)
+    {
+        if (depth_ == 0)
+            return;
+
+        // the history is started by the first iterate. this must not be decided based on
+        // the size of the vectors because they are empty on processes without degrees
+        // of freedom, and all processes must agree on the size of the history. the
+        // history is useless if the number of blocks changed.
+        if (!hasLastIterate_ || lastIterate_.size() != x.size())
+            clear();
+        else {
+            if (deltaX_.empty())
+                excluded_.assign(x.size(), 0);
+
+            UpdateVector dX(deltaX.size());
+            UpdateVector dF(deltaX.size());
+            for (unsigned blockIdx = 0; blockIdx < deltaX.size(); ++blockIdx) {
+                if (!compatible(blockIdx, x[blockIdx], lastIterate_[blockIdx]))
+                    excluded_[blockIdx] = 1;
+
+                for (unsigned k = 0; k < deltaX[blockIdx].size(); ++k) {
+                    dX[blockIdx][k] = x[blockIdx][k] - lastIterate_[blockIdx][k];
+                    // f_k = -deltaX_k and lastStep_ is f_(k-1)
+                    dF[blockIdx][k] = -deltaX[blockIdx][k] - lastStep_[blockIdx][k];
+                }
+            }
+
+            deltaX_.push_back(std::move(dX));
+            deltaF_.push_back(std::move(dF));
+            if (deltaX_.size() > depth_) {
+                deltaX_.pop_front();
+                deltaF_.pop_front();
+            }
+        }
+
+        lastIterate_ = x;
+        lastStep_ = deltaX;
+        lastStep_ *= -1.0;
+        hasLastIterate_ = true;
+    }
+
+    /*!
+     * \brief Compute the accelerated update of the most recently pushed iterate.
+     *
+     * \param result Receives the accelerated update deltaX_k' = x_k - x_(k+1)
+     * \param deltaX The plain update which was passed to the last call of push()
+     * \param weight A functor (blockIdx, k) -> Scalar which returns the weight of a
+     *               component in the least-squares problem. Components which ought to
+     *               be ignored (e.g., those which are not owned by the local process)
+     *               have a weight of zero.
+     * \param globalSum A functor (Scalar* values, int n) which sums up the values of
+     *                  all processes in place
+     *
+     * \return false if no accelerated update could be computed. Since the decision is
+     *         based on reduced quantities, all processes come to the same result.
+     */
+    template <class Weight, class GlobalSum>
+    bool accelerate(UpdateVector& result,
+                    const UpdateVector& deltaX,
+                    const Weight& weight,
+                    const GlobalSum& globalSum) const
+    {
+        unsigned m = historySize();
+        if (m == 0)
+            return false;
+
+        // assemble the normal equations of the least-squares problem. the local
+        // contributions of all processes are summed up using a single reduction.
+        std::vector<Scalar> normalEq(m*m + m, 0.0);
+        for (unsigned blockIdx = 0; blockIdx < deltaX.size(); ++blockIdx) {
+            if (excluded_[blockIdx])
+                continue;
+
+            for (unsigned k = 0; k < deltaX[blockIdx].size(); ++k) {
+                Scalar w = weight(blockIdx, k);
+                if (w == 0.0)
+                    continue;
+
+                Scalar w2 = w*w;
+                Scalar f = -deltaX[blockIdx][k];
+                for (unsigned i = 0; i < m; ++i) {
+                    Scalar dFi = deltaF_[i][blockIdx][k];
+                    for (unsigned j = 0; j <= i; ++j)
+                        normalEq[i*m + j] += w2*dFi*deltaF_[j][blockIdx][k];
+                    normalEq[m*m + i] += w2*dFi*f;
+                }
+            }
+        }
+        globalSum(normalEq.data(), static_cast<int>(normalEq.size()));
+
+        Dune::DynamicMatrix<Scalar> A(m, m);
+        Dune::DynamicVector<Scalar> b(m);
+        Dune::DynamicVector<Scalar> gamma(m);
+        Scalar maxDiag = 0.0;
+        for (unsigned i = 0; i < m; ++i) {
+            for (unsigned j = 0; j <= i; ++j)
+                A[i][j] = A[j][i] = normalEq[i*m + j];
+            b[i] = normalEq[m*m + i];
+            maxDiag = std::max(maxDiag, A[i][i]);
+        }
+        if (maxDiag <= 0.0)
+            return false;
+
+        // the differences of the updates are often almost linearly dependent, so the
+        // problem is regularized slightly
+        for (unsigned i = 0; i < m; ++i)
+            A[i][i] += 1e-10*maxDiag;
+
+        try {
+            A.solve(gamma, b);
+        }
+        catch (const Dune::FMatrixError&) {
+            return false;
+        }
+
+        // the coefficients are the same on all processes
+        for (unsigned i = 0; i < m; ++i)
+            if (!std::isfinite(gamma[i]))
+                return false;
+
+        // deltaX_k' = x_k - x_(k+1) = -f_k + sum_i gamma_i (DeltaX_i + DeltaF_i)
+        result = deltaX;
+        for (unsigned blockIdx = 0; blockIdx < result.size(); ++blockIdx) {
+            if (excluded_[blockIdx])
+                continue;
+
+            for (unsigned k = 0; k < result[blockIdx].size(); ++k) {
+                for (unsigned i = 0; i < m; ++i)
+                    result[blockIdx][k] +=
+                        gamma[i]*(deltaX_[i][blockIdx][k] + deltaF_[i][blockIdx][k]);
+            }
+        }
+
+        return true;
+    }
+
+    /*!
+     * \brief Returns the number of bytes which are occupied by the history.
+     */
+    size_t memoryUsage() const
+    {
+        size_t result =
+            blockVectorMemoryUsage(lastIterate_)
+            + blockVectorMemoryUsage(lastStep_)
+            + excluded_.capacity()*sizeof(unsigned char);
+        for (const auto& v : deltaX_)
+            result += blockVectorMemoryUsage(v);
+        for (const auto& v : deltaF_)
+            result += blockVectorMemoryUsage(v);
+        return result;
+    }
+
+private:
+    unsigned depth_;
+
+    // the differences of the last iterates and of their updates f = -deltaX, the most
+    // recent iterate and its update
+    std::deque<UpdateVector> deltaX_;
+    std::deque<UpdateVector> deltaF_;
+    SolutionVector lastIterate_;
+    UpdateVector lastStep_;
+    bool hasLastIterate_;
+
+    // the blocks which were marked incompatible since the history was started
+    std::vector<unsigned char> excluded_;
+};
+
+} // namespace Ewoms
+
+#endif
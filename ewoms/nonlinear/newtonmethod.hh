@@ -33,6 +33,7 @@
 #include <ewoms/common/parametersystem.hh>
 #include <ewoms/common/timer.hh>
 #include <ewoms/common/timerguard.hh>
+#include <ewoms/parallel/collectivecontext.hh>
 
 #include <opm/material/densead/Math.hpp>
 #include <opm/material/common/Unused.hpp>
@@ -44,8 +45,14 @@
 #include <dune/common/version.hh>
 #include <dune/common/parallel/mpihelper.hh>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <unistd.h>
 
@@ -146,6 +153,41 @@ NEW_PROP_TAG(NewtonTargetIterations);
 //! Number of maximum iterations for the Newton method.
 NEW_PROP_TAG(NewtonMaxIterations);
 
+//! Specifies whether the Jacobian of a previous iteration may be reused if the Newton
+//! method converges quickly (i.e., if the modified Newton method is used)
+NEW_PROP_TAG(NewtonEnableJacobianReuse);
+
+//! The ratio of the errors of two consecutive iterations below which the Jacobian of the
+//! previous iteration is reused
+NEW_PROP_TAG(NewtonJacobianReuseContraction);
+
+//! The maximum number of consecutive iterations which reuse the same Jacobian
+NEW_PROP_TAG(NewtonMaxJacobianReuse);
+
+//! Specifies whether the accuracy of the linear solver is adapted to the progress of
+//! the Newton method using the forcing terms of Eisenstat and Walker
+NEW_PROP_TAG(NewtonEnableEisenstatWalker);
+
+//! The factor gamma of the forcing term eta_k = gamma*(error_k/error_(k-1))^alpha
+NEW_PROP_TAG(NewtonForcingTermGamma);
+
+//! The exponent alpha of the forcing term eta_k = gamma*(error_k/error_(k-1))^alpha
+NEW_PROP_TAG(NewtonForcingTermAlpha);
+
+//! The largest residual reduction which is requested from the linear solver if the
+//! forcing terms of Eisenstat and Walker are used
+NEW_PROP_TAG(NewtonMaxForcingTerm);
+
+//! Specifies whether the length of the Newton update is determined by a backtracking
+//! line search
+NEW_PROP_TAG(NewtonEnableLineSearch);
+
+//! The maximum number of step lengths which are tried by the line search
+NEW_PROP_TAG(NewtonLineSearchMaxTrials);
+
+//! The factor by which the step length is reduced after a rejected trial
+NEW_PROP_TAG(NewtonLineSearchReduction);
+
 // set default values for the properties
 SET_TYPE_PROP(NewtonMethod, NewtonMethod, Ewoms::NewtonMethod<TypeTag>);
 SET_TYPE_PROP(NewtonMethod, NewtonConvergenceWriter, Ewoms::NullConvergenceWriter<TypeTag>);
@@ -157,6 +199,16 @@ SET_SCALAR_PROP(NewtonMethod, NewtonTolerance, 1e-8);
 SET_SCALAR_PROP(NewtonMethod, NewtonMaxError, 1e100);
 SET_INT_PROP(NewtonMethod, NewtonTargetIterations, 10);
 SET_INT_PROP(NewtonMethod, NewtonMaxIterations, 18);
+SET_BOOL_PROP(NewtonMethod, NewtonEnableJacobianReuse, false);
+SET_SCALAR_PROP(NewtonMethod, NewtonJacobianReuseContraction, 0.1);
+SET_INT_PROP(NewtonMethod, NewtonMaxJacobianReuse, 3);
+SET_BOOL_PROP(NewtonMethod, NewtonEnableEisenstatWalker, false);
+SET_SCALAR_PROP(NewtonMethod, NewtonForcingTermGamma, 0.9);
+SET_SCALAR_PROP(NewtonMethod, NewtonForcingTermAlpha, 1.618033988749895);
+SET_SCALAR_PROP(NewtonMethod, NewtonMaxForcingTerm, 0.9);
+SET_BOOL_PROP(NewtonMethod, NewtonEnableLineSearch, false);
+SET_INT_PROP(NewtonMethod, NewtonLineSearchMaxTrials, 4);
+SET_SCALAR_PROP(NewtonMethod, NewtonLineSearchReduction, 0.5);
 
 END_PROPERTIES
 
@@ -167,6 +219,11 @@ namespace Ewoms {
  *
  * This class uses static polymorphism to allow implementations to
  * implement different update/convergence strategies.
+ *
+ * The interface which is required from the linear solver backend is described by
+ * Ewoms::Linear::LinearSolverBackendBase. The optional methods for reusing the
+ * preconditioner and for adapting the tolerance are only called if the corresponding
+ * features of the Newton method are enabled.
  */
 template <class TypeTag>
 class NewtonMethod
@@ -192,9 +249,14 @@ class NewtonMethod
 public:
     NewtonMethod(Simulator& simulator)
         : simulator_(simulator)
+        , prePostProcessTimer_("Newton pre/post processing")
+        , linearizeTimer_("linearization")
+        , solveTimer_("linear solve")
+        , updateTimer_("Newton update")
         , endIterMsgStream_(std::ostringstream::out)
         , linearSolver_(simulator)
         , comm_(Dune::MPIHelper::getCommunicator())
+        , collectives_(simulator.gridView().comm())
         , convergenceWriter_(asImp_())
     {
         lastError_ = 1e100;
@@ -202,6 +264,18 @@ public:
         tolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonTolerance);
 
         numIterations_ = 0;
+        numAttemptedIterations_ = 0;
+        numFreshJacobians_ = 0;
+        numReusedJacobians_ = 0;
+        numConsecutiveJacobianReuses_ = 0;
+        jacobianReusePossible_ = false;
+        lineSearchPossible_ = false;
+
+        fixedLinearTolerance_ = 0.0;
+        forcingTerm_ = 0.0;
+        savedLinearIterations_ = 0.0;
+        totalLinearIterations_ = 0;
+        totalSavedLinearIterations_ = 0.0;
     }
 
     /*!
@@ -230,6 +304,35 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMaxError,
                              "The maximum error tolerated by the Newton "
                              "method to which does not cause an abort");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonEnableJacobianReuse,
+                             "Reuse the Jacobian of the previous iteration while "
+                             "the Newton method converges quickly");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonJacobianReuseContraction,
+                             "The ratio of the errors of two consecutive Newton "
+                             "iterations below which the Jacobian is reused");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonMaxJacobianReuse,
+                             "The maximum number of consecutive Newton iterations "
+                             "which reuse the same Jacobian");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonEnableEisenstatWalker,
+                             "Adapt the tolerance of the linear solver to the progress "
+                             "of the Newton method (inexact Newton method)");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonForcingTermGamma,
+                             "The factor of the Eisenstat-Walker forcing term");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonForcingTermAlpha,
+                             "The exponent of the Eisenstat-Walker forcing term");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMaxForcingTerm,
+                             "The largest residual reduction requested from the linear "
+                             "solver by the Eisenstat-Walker forcing terms");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonEnableLineSearch,
+                             "Determine the length of the Newton update using a "
+                             "backtracking line search (not available for models with "
+                             "auxiliary modules)");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonLineSearchMaxTrials,
+                             "The maximum number of step lengths which are tried by "
+                             "the line search of the Newton method");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonLineSearchReduction,
+                             "The factor by which the line search of the Newton "
+                             "method reduces the step length after a rejected trial");
     }
 
     /*!
@@ -289,6 +392,126 @@ public:
     void setIterationIndex(int value)
     { numIterations_ = value; }
 
+    /*!
+     * \brief Returns the number of iterations which were started by the last
+     *        invocation of the Newton method.
+     *
+     * This includes the iteration in which the Newton method failed, if it did so.
+     * Unlike numIterations(), this is not modified by a failure.
+     */
+    unsigned numAttemptedIterations() const
+    { return numAttemptedIterations_; }
+
+    /*!
+     * \brief Returns the number of Newton iterations of the last invocation of the
+     *        Newton method for which the Jacobian was assembled.
+     */
+    unsigned numFreshJacobians() const
+    { return numFreshJacobians_; }
+
+    /*!
+     * \brief Returns the number of Newton iterations of the last invocation of the
+     *        Newton method which reused the Jacobian of a previous iteration.
+     */
+    unsigned numReusedJacobians() const
+    { return numReusedJacobians_; }
+
+    /*!
+     * \brief Returns the number of iterations of the linear solver for each Newton
+     *        iteration of the last invocation of the Newton method.
+     */
+    const std::vector<unsigned>& linearIterations() const
+    { return linearIterations_; }
+
+    /*!
+     * \brief Returns the number of iterations of the linear solver of all invocations
+     *        of the Newton method.
+     */
+    unsigned long totalLinearIterations() const
+    { return totalLinearIterations_; }
+
+    /*!
+     * \brief Returns the estimated number of iterations of the linear solver which were
+     *        saved by the Eisenstat-Walker forcing terms in all invocations of the
+     *        Newton method.
+     *
+     * The estimate assumes that the linear solver converges at a constant rate, i.e.,
+     * that the number of iterations is proportional to the logarithm of the requested
+     * residual reduction.
+     */
+    Scalar estimatedSavedLinearIterations() const
+    { return totalSavedLinearIterations_; }
+
+    /*!
+     * \brief Returns the length of the update which was accepted by the line search
+     *        for each Newton iteration of the last invocation of the Newton method.
+     *
+     * If the line search is disabled, this is empty.
+     */
+    const std::vector<Scalar>& stepLengths() const
+    { return stepLengths_; }
+
+    /*!
+     * \brief Returns the contribution of a single degree of freedom to the error of the
+     *        Newton method.
+     *
+     * This is the maximum of the weighted residuals of all equations of the degree of
+     * freedom. The linearizer may call this method as soon as the residual of a degree
+     * of freedom is complete.
+     *
+     * \param globalDofIdx The global index of the degree of freedom
+     * \param residual The residual of the degree of freedom
+     */
+    Scalar dofError(unsigned globalDofIdx, const EqVector& residual) const
+    {
+        Scalar result = 0;
+        for (unsigned eqIdx = 0; eqIdx < residual.size(); ++eqIdx)
+            result = Opm::max(std::abs(residual[eqIdx] * model().eqWeight(globalDofIdx, eqIdx)), result);
+        return result;
+    }
+
+    /*!
+     * \brief Compute the maximum and the average of the weighted residual of all grid
+     *        degrees of freedom for the most recent linearization.
+     *
+     * In contrast to the error of the Newton method, the average takes all equations of
+     * all non-constraint degrees of freedom into account. This method must be called
+     * by all processes.
+     */
+    void residualStatistics(Scalar& maxResid, Scalar& avgResid) const
+    {
+        const auto& constraintsMap = model().linearizer().constraintsMap();
+        const auto& residual = model().linearizer().residual();
+
+        maxResid = 0.0;
+        Scalar sumResid = 0.0;
+        unsigned long numResid = 0;
+        for (unsigned dofIdx = 0; dofIdx < model().numGridDof(); ++dofIdx) {
+            if (model().dofTotalVolume(dofIdx) <= 0.0)
+                continue;
+            if (enableConstraints_() && constraintsMap.count(dofIdx) > 0)
+                continue;
+
+            const auto& r = residual[dofIdx];
+            for (unsigned eqIdx = 0; eqIdx < r.size(); ++eqIdx) {
+                Scalar tmp = std::abs(r[eqIdx] * model().eqWeight(dofIdx, eqIdx));
+                maxResid = std::max(maxResid, tmp);
+                sumResid += tmp;
+            }
+            numResid += r.size();
+        }
+
+        CollectiveContext collectives(simulator_.gridView().comm());
+        unsigned maxIdx = collectives.addMax(maxResid);
+        unsigned sumIdx = collectives.addSum(sumResid);
+        unsigned numIdx = collectives.addSum(static_cast<double>(numResid));
+        collectives.resolve();
+
+        maxResid = collectives.max(maxIdx);
+        Scalar globalNumResid = collectives.sum(numIdx);
+        avgResid = (globalNumResid > 0) ? collectives.sum(sumIdx)/globalNumResid : 0.0;
+    }
+
     /*!
      * \brief Return the current tolerance at which the Newton method considers itself to
      *        be converged.
@@ -325,6 +548,9 @@ public:
         linearizeTimer_.halt();
         solveTimer_.halt();
         updateTimer_.halt();
+        linearSolver_.resetTimers();
+        linearIterations_.clear();
+        stepLengths_.clear();
 
         SolutionVector& nextSolution = model().solution(/*historyIdx=*/0);
         SolutionVector currentSolution(nextSolution);
@@ -348,10 +574,16 @@ public:
             // execute the method as long as the implementation thinks
             // that we should do another iteration
             while (asImp_().proceed_()) {
+                // decide whether the Jacobian of the previous iteration is good enough.
+                // this needs to be done before beginIteration_() because that method
+                // overwrites the error of the previous iteration.
+                bool reuseJacobian = asImp_().reuseJacobian_();
+
                 // linearize the problem at the current solution
 
                 // notify the implementation that we're about to start
                 // a new iteration
+                ++ numAttemptedIterations_;
                 prePostProcessTimer_.start();
                 asImp_().beginIteration_();
                 prePostProcessTimer_.stop();
@@ -365,10 +597,24 @@ public:
                               << std::flush;
                 }
 
-                // do the actual linearization
+                // do the actual linearization. if the local process already failed, this
+                // is skipped. the failure is communicated by preSolve_().
                 linearizeTimer_.start();
-                asImp_().linearizeDomain_();
-                asImp_().linearizeAuxiliaryEquations_();
+                if (collectives_.failed()) {
+                    // the Jacobian and the residual are left untouched
+                }
+                else if (reuseJacobian) {
+                    asImp_().linearizeResidual_();
+                    ++ numReusedJacobians_;
+                    ++ numConsecutiveJacobianReuses_;
+                    endIterMsg() << ", reused Jacobian";
+                }
+                else {
+                    asImp_().linearizeDomain_();
+                    asImp_().linearizeAuxiliaryEquations_();
+                    ++ numFreshJacobians_;
+                    numConsecutiveJacobianReuses_ = 0;
+                }
                 linearizeTimer_.stop();
 
                 solveTimer_.start();
@@ -408,11 +654,17 @@ public:
 
                 solveTimer_.start();
                 // solve A x = b, where b is the residual, A is its Jacobian and x is the
-                // update of the solution
-                linearSolver_.setMatrix(jacobian);
+                // update of the solution. if the Jacobian is reused, the linear solver
+                // still holds the matrix and the preconditioner of the last fresh one.
+                if (!reuseJacobian)
+                    linearSolver_.setMatrix(jacobian);
+                if (EWOMS_GET_PARAM(TypeTag, bool, NewtonEnableJacobianReuse))
+                    linearSolver_.setReusePreconditioner(reuseJacobian);
+                asImp_().updateLinearTolerance_();
                 solutionUpdate = 0.0;
                 bool converged = linearSolver_.solve(solutionUpdate);
                 solveTimer_.stop();
+                asImp_().recordLinearIterations_(static_cast<unsigned>(linearSolver_.iterations()));
 
                 if (!converged) {
                     solveTimer_.stop();
@@ -440,6 +692,8 @@ public:
                                     residual,
                                     solutionUpdate);
                 asImp_().update_(nextSolution, currentSolution, solutionUpdate, residual);
+                if (lineSearchPossible_)
+                    asImp_().lineSearch_(nextSolution, currentSolution);
                 updateTimer_.stop();
 
                 if (asImp_().verbose_() && isatty(fileno(stdout)))
@@ -502,6 +756,17 @@ public:
                       << updateTimer_.realTimeElapsed() << "("
                       << 100 * updateTimer_.realTimeElapsed()/elapsedTot << "%)"
                       << "\n" << std::flush;
+            if (EWOMS_GET_PARAM(TypeTag, bool, NewtonEnableJacobianReuse))
+                std::cout << "Jacobians: " << numFreshJacobians_ << " fresh, "
+                          << numReusedJacobians_ << " reused\n" << std::flush;
+            if (enableEisenstatWalker_()) {
+                unsigned numLinearIterations = 0;
+                for (unsigned n : linearIterations_)
+                    numLinearIterations += n;
+                std::cout << "Linear iterations: " << numLinearIterations
+                          << ", about " << static_cast<unsigned>(savedLinearIterations_ + 0.5)
+                          << " saved by the adaptive linear tolerance\n" << std::flush;
+            }
         }
 
 
@@ -587,6 +852,21 @@ public:
     { return updateTimer_; }
 
 protected:
+    /*!
+     * \brief The phases of a Newton iteration in which a process may fail.
+     *
+     * These are used as the reasons of the failures which are recorded in the
+     * collective context. The linearizer records its failures using the default
+     * reason, i.e., linearizationFailure.
+     */
+    enum FailurePhase {
+        linearizationFailure = 0,
+        beginIterationFailure,
+        postSolveFailure,
+        updateFailure,
+        endIterationFailure
+    };
+
     /*!
      * \brief Returns true if the Newton method ought to be chatty.
      */
@@ -604,6 +884,34 @@ protected:
     void begin_(const SolutionVector& u  OPM_UNUSED)
     {
         numIterations_ = 0;
+        numAttemptedIterations_ = 0;
+        numFreshJacobians_ = 0;
+        numReusedJacobians_ = 0;
+        numConsecutiveJacobianReuses_ = 0;
+
+        // the forcing terms are not carried over from the previous time step. the
+        // configured residual reduction is retrieved from the linear solver because
+        // direct solvers do not have one.
+        forcingTerm_ = 0.0;
+        savedLinearIterations_ = 0.0;
+        fixedLinearTolerance_ = 0.0;
+        if (enableEisenstatWalker_())
+            fixedLinearTolerance_ = linearSolver_.fixedRelativeTolerance();
+
+        // the auxiliary modules write directly into the Jacobian, so it cannot be
+        // reused if any process has one. Also, the residual-only linearization which is
+        // used by the line search skips the auxiliary modules, so the errors of the
+        // trial solutions would not be comparable. Since these decisions must be the
+        // same for all processes, this needs to be communicated.
+        bool enableJacobianReuse = EWOMS_GET_PARAM(TypeTag, bool, NewtonEnableJacobianReuse);
+        bool enableLineSearch = EWOMS_GET_PARAM(TypeTag, bool, NewtonEnableLineSearch);
+        jacobianReusePossible_ = false;
+        lineSearchPossible_ = false;
+        if (enableJacobianReuse || enableLineSearch) {
+            bool noAuxiliaryModules = comm_.min(model().numAuxiliaryModules() == 0 ? 1 : 0) > 0;
+            jacobianReusePossible_ = enableJacobianReuse && noAuxiliaryModules;
+            lineSearchPossible_ = enableLineSearch && noAuxiliaryModules;
+        }
 
         if (EWOMS_GET_PARAM(TypeTag, bool, NewtonWriteConvergence))
             convergenceWriter_.beginTimeStep();
@@ -614,7 +922,8 @@ protected:
      */
     void beginIteration_()
     {
-        const auto& comm = simulator_.gridView().comm();
+        collectives_.clear();
+
         bool succeeded = true;
         try {
             problem().beginIteration();
@@ -637,10 +946,8 @@ protected:
         }
 #endif
 
-        succeeded = comm.min(succeeded);
-
-        if (!succeeded)
-            throw Opm::NumericalIssue("pre processing of the problem failed");
+        // the failure is only communicated to the peer processes by preSolve_()
+        collectives_.addFailure(!succeeded, beginIterationFailure);
 
         lastError_ = error_;
     }
@@ -651,26 +958,59 @@ protected:
      */
     void linearizeDomain_()
     {
-        model().linearizer().linearizeDomain();
+        model().linearizer().linearizeDomain(collectives_);
+    }
+
+    /*!
+     * \brief Evaluate the residual of the spatial domain but keep the Jacobian of the
+     *        previous iteration.
+     */
+    void linearizeResidual_()
+    {
+        model().linearizer().linearizeResidual(collectives_);
     }
 
     void linearizeAuxiliaryEquations_()
     {
-        model().linearizer().linearizeAuxiliaryEquations();
+        model().linearizer().linearizeAuxiliaryEquations(collectives_);
         model().linearizer().finalize();
     }
 
     void preSolve_(const SolutionVector& currentSolution  OPM_UNUSED,
                    const GlobalEqVector& currentResidual)
     {
-        const auto& constraintsMap = model().linearizer().constraintsMap();
         lastError_ = error_;
         Scalar newtonMaxError = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError);
 
-        // calculate the error as the maximum weighted tolerance of
-        // the solution's residual
-        error_ = 0;
-        for (unsigned dofIdx = 0; dofIdx < currentResidual.size(); ++dofIdx) {
+        // calculate the error as the maximum weighted tolerance of the solution's
+        // residual. this is pointless if the local process did not linearize the
+        // system because of a failure.
+        if (!collectives_.failed())
+            error_ = residualError_(currentResidual);
+
+        // take the other processes into account
+        syncLinearization_();
+
+        // make sure that the error never grows beyond the maximum
+        // allowed one
+        if (error_ > newtonMaxError)
+            throw Opm::NumericalIssue("Newton: Error "+std::to_string(double(error_))
+                                        +" is larger than maximum allowed error of "
+                                        +std::to_string(double(newtonMaxError)));
+    }
+
+    /*!
+     * \brief Returns the error of a residual on the local process.
+     *
+     * The error is the maximum of the weighted residuals of all grid degrees of
+     * freedom which are not constraint.
+     */
+    Scalar localError_(const GlobalEqVector& residual) const
+    {
+        const auto& constraintsMap = model().linearizer().constraintsMap();
+
+        Scalar result = 0;
+        for (unsigned dofIdx = 0; dofIdx < residual.size(); ++dofIdx) {
             // do not consider auxiliary DOFs for the error
             if (dofIdx >= model().numGridDof() || model().dofTotalVolume(dofIdx) <= 0.0)
                 continue;
@@ -681,20 +1021,25 @@ protected:
                     continue;
             }
 
-            const auto& r = currentResidual[dofIdx];
-            for (unsigned eqIdx = 0; eqIdx < r.size(); ++eqIdx)
-                error_ = Opm::max(std::abs(r[eqIdx] * model().eqWeight(dofIdx, eqIdx)), error_);
+            result = Opm::max(asImp_().dofError(dofIdx, residual[dofIdx]), result);
         }
 
-        // take the other processes into account
-        error_ = comm_.max(error_);
+        return result;
+    }
 
-        // make sure that the error never grows beyond the maximum
-        // allowed one
-        if (error_ > newtonMaxError)
-            throw Opm::NumericalIssue("Newton: Error "+std::to_string(double(error_))
-                                        +" is larger than maximum allowed error of "
-                                        +std::to_string(double(newtonMaxError)));
+    /*!
+     * \brief Returns the error of the residual of the most recent linearization on the
+     *        local process.
+     *
+     * If the linearizer has already determined the error while assembling the
+     * residual, this avoids another pass over all degrees of freedom.
+     */
+    Scalar residualError_(const GlobalEqVector& residual) const
+    {
+        const auto& linearizer = model().linearizer();
+        if (linearizer.hasResidualError())
+            return linearizer.residualError();
+        return asImp_().localError_(residual);
     }
 
     /*!
@@ -714,9 +1059,8 @@ protected:
                     GlobalEqVector& solutionUpdate OPM_UNUSED)
     {
         // loop over the auxiliary modules and ask them to post process the solution
-        // vector.
+        // vector. failures are communicated to the peer processes by syncIteration_()
         auto& model = simulator_.model();
-        const auto& comm = simulator_.gridView().comm();
         for (unsigned i = 0; i < model.numAuxiliaryModules(); ++i) {
             auto& auxMod = *model.auxiliaryModule(i);
 
@@ -742,10 +1086,7 @@ protected:
             }
 #endif
 
-            succeeded = comm.min(succeeded);
-
-            if (!succeeded)
-                throw Opm::NumericalIssue("post processing of an auxilary equation failed");
+            collectives_.addFailure(!succeeded, postSolveFailure);
         }
     }
 
@@ -810,6 +1151,152 @@ protected:
         }
     }
 
+    /*!
+     * \brief Shorten the update of the current iteration if it does not reduce the
+     *        error sufficiently.
+     *
+     * The step length lambda is reduced by the NewtonLineSearchReduction factor until
+     * the Armijo condition error(lambda) <= (1 - 1e-4*lambda)*error(0) is met or
+     * NewtonLineSearchMaxTrials step lengths have been tried. In the latter case, the
+     * step length with the smallest error is used. The errors of the trial solutions are
+     * determined by the residual-only path of the linearizer. Since this path does not
+     * consider the auxiliary equations, the line search is disabled if any process
+     * has auxiliary modules.
+     *
+     * \param nextSolution The solution after the full update. This is also where the
+     *                     result of the line search is stored.
+     * \param currentSolution The solution at the beginning of the current iteration
+     */
+    void lineSearch_(SolutionVector& nextSolution,
+                     const SolutionVector& currentSolution)
+    {
+        const Scalar armijoConstant = 1e-4;
+        int maxTrials = std::max(1, EWOMS_GET_PARAM(TypeTag, int, NewtonLineSearchMaxTrials));
+        Scalar reduction = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonLineSearchReduction);
+
+        fullStepSolution_ = nextSolution;
+
+        Scalar lambda = 1.0;
+        Scalar bestLambda = 1.0;
+        Scalar bestError = std::numeric_limits<Scalar>::max();
+        bool accepted = false;
+        int numTrials = 0;
+        while (numTrials < maxTrials) {
+            if (numTrials > 0) {
+                lambda *= reduction;
+                asImp_().lineSearchTrialSolution_(nextSolution,
+                                                  currentSolution,
+                                                  fullStepSolution_,
+                                                  lambda);
+            }
+            ++ numTrials;
+
+            Scalar trialError;
+            if (!asImp_().trialError_(trialError)) {
+                // the iteration already failed on some process. this is reported by
+                // syncIteration_(), so the line search is abandoned
+                nextSolution = fullStepSolution_;
+                return;
+            }
+
+            if (trialError < bestError) {
+                bestError = trialError;
+                bestLambda = lambda;
+            }
+
+            if (trialError <= (1 - armijoConstant*lambda)*error_) {
+                accepted = true;
+                break;
+            }
+        }
+
+        if (!accepted && bestLambda != lambda) {
+            lambda = bestLambda;
+            asImp_().lineSearchTrialSolution_(nextSolution,
+                                              currentSolution,
+                                              fullStepSolution_,
+                                              lambda);
+        }
+
+        stepLengths_.push_back(lambda);
+        endIterMsg() << ", step length " << lambda << " (" << numTrials << " trials"
+                     << (accepted ? "" : ", no sufficient decrease") << ")";
+    }
+
+    /*!
+     * \brief Compute the solution which corresponds to a given step length of the line
+     *        search.
+     *
+     * The trial solution is interpolated between the solution at the beginning of the
+     * iteration and the solution after the full update. Since the full update has
+     * already been limited by updatePrimaryVariables_(), the limits also hold for all
+     * trial solutions.
+     *
+     * \param trialSolution The vector which receives the trial solution
+     * \param currentSolution The solution at the beginning of the current iteration
+     * \param fullStepSolution The solution after the full update
+     * \param lambda The step length
+     */
+    void lineSearchTrialSolution_(SolutionVector& trialSolution,
+                                  const SolutionVector& currentSolution,
+                                  const SolutionVector& fullStepSolution,
+                                  Scalar lambda)
+    {
+        for (unsigned dofIdx = 0; dofIdx < trialSolution.size(); ++dofIdx) {
+            // this also copies the meaning of the primary variables (if any)
+            trialSolution[dofIdx] = fullStepSolution[dofIdx];
+            if (lambda == 1.0)
+                continue;
+
+            for (unsigned pvIdx = 0; pvIdx < trialSolution[dofIdx].size(); ++pvIdx)
+                trialSolution[dofIdx][pvIdx] =
+                    currentSolution[dofIdx][pvIdx]
+                    + lambda*(fullStepSolution[dofIdx][pvIdx] - currentSolution[dofIdx][pvIdx]);
+        }
+    }
+
+    /*!
+     * \brief Determine the global error of the current solution of the model.
+     *
+     * This only evaluates the residual without assembling the Jacobian matrix. The
+     * error of all processes is determined by a single reduction. If any process fails
+     * to evaluate the residual, the error is infinite.
+     *
+     * If a previous phase of the current iteration failed on the local process, the
+     * residual is not evaluated. The failure is then included in the reduction and
+     * false is returned on all processes.
+     *
+     * \param error Receives the global error of the current solution
+     */
+    bool trialError_(Scalar& error)
+    {
+        auto& linearizer = model().linearizer();
+        auto& residual = linearizer.residual();
+
+        CollectiveContext collectives(simulator_.gridView().comm());
+        bool iterationFailed = collectives_.failed();
+        unsigned iterationFailedIdx = collectives.addMax(iterationFailed ? 1.0 : 0.0);
+        if (!iterationFailed)
+            linearizer.linearizeResidual(collectives);
+
+        // the residuals of the degrees of freedom on the process borders need to be
+        // summed up
+        linearSolver_.setResidual(residual);
+        linearSolver_.getResidual(residual);
+
+        unsigned errorIdx = collectives.addMax(iterationFailed ? 0.0 : residualError_(residual));
+        collectives.resolve();
+
+        if (collectives.max(iterationFailedIdx) > 0.0)
+            return false;
+
+        if (collectives.failed())
+            error = std::numeric_limits<Scalar>::max();
+        else
+            error = collectives.max(errorIdx);
+        return true;
+    }
+
     /*!
      * \brief Update the primary variables for a degree of freedom which is constraint.
      */
@@ -858,7 +1345,6 @@ protected:
     {
         ++numIterations_;
 
-        const auto& comm = simulator_.gridView().comm();
         bool succeeded = true;
         try {
             problem().endIteration();
@@ -881,10 +1367,8 @@ protected:
         }
 #endif
 
-        succeeded = comm.min(succeeded);
-
-        if (!succeeded)
-            throw Opm::NumericalIssue("post processing of the problem failed");
+        collectives_.addFailure(!succeeded, endIterationFailure);
+        asImp_().syncIteration_();
 
         if (asImp_().verbose_()) {
             std::cout << "Newton iteration " << numIterations_ << ""
@@ -895,6 +1379,163 @@ protected:
         endIterMsgStream_.str("");
     }
 
+    /*!
+     * \brief Resolve the collective operations which were deferred while the system
+     *        of equations was linearized.
+     *
+     * Besides the failures of the problem's beginIteration() method and of the
+     * linearization, this determines the maximum of the error over all processes
+     * using a single reduction. If any process failed, an exception is thrown.
+     */
+    void syncLinearization_()
+    {
+        unsigned errorIdx = collectives_.addMax(error_);
+        collectives_.resolve();
+
+        if (collectives_.failed())
+            throw Opm::NumericalIssue(failureMessage_());
+
+        error_ = collectives_.max(errorIdx);
+    }
+
+    /*!
+     * \brief Resolve the collective operations which were deferred since the
+     *        linearization was synchronized.
+     *
+     * These are the failures of the auxiliary modules' postSolve() methods, of the
+     * update of the solution and of the problem's endIteration() method. Derived
+     * classes may add their own entries to the collective context before calling this
+     * method.
+     */
+    void syncIteration_()
+    {
+        collectives_.resolve();
+
+        if (collectives_.failed())
+            throw Opm::NumericalIssue(failureMessage_());
+    }
+
+    /*!
+     * \brief Returns a message which names the phases of the current iteration in
+     *        which any process failed.
+     */
+    std::string failureMessage_() const
+    {
+        static const std::pair<FailurePhase, const char*> phaseNames[] = {
+            { beginIterationFailure, "pre-processing the problem" },
+            { linearizationFailure, "linearizing the system" },
+            { postSolveFailure, "post-processing the solution of the linear system" },
+            { updateFailure, "updating the solution" },
+            { endIterationFailure, "post-processing the problem" }
+        };
+
+        std::string phases;
+        for (const auto& phase : phaseNames) {
+            if (!collectives_.failed(phase.first))
+                continue;
+            if (!phases.empty())
+                phases += ", ";
+            phases += phase.second;
+        }
+
+        return "A process did not succeed in "+phases;
+    }
+
+    /*!
+     * \brief Returns true if the next iteration should reuse the Jacobian of the
+     *        previous one.
+     *
+     * This is the case if Jacobian reuse is enabled, and the error was reduced by a
+     * large enough factor in the last iteration. Once convergence slows down, the
+     * Jacobian is assembled again. Since the errors are global quantities, all
+     * processes come to the same decision.
+     */
+    bool reuseJacobian_() const
+    {
+        if (!jacobianReusePossible_)
+            return false;
+
+        // the first iteration of a time step always needs a fresh Jacobian and the
+        // contraction rate is only known after the second one
+        if (numIterations_ < 2)
+            return false;
+
+        int maxReuse = EWOMS_GET_PARAM(TypeTag, int, NewtonMaxJacobianReuse);
+        if (static_cast<int>(numConsecutiveJacobianReuses_) >= maxReuse)
+            return false;
+
+        Scalar contraction = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonJacobianReuseContraction);
+        return error_ < contraction*lastError_;
+    }
+
+    /*!
+     * \brief Set the residual reduction which is required from the linear solver in
+     *        the current iteration.
+     *
+     * If the forcing terms of Eisenstat and Walker are enabled, the relative tolerance
+     * of the linear solver is eta_k = gamma*(error_k/error_(k-1))^alpha (choice 2 of
+     * Eisenstat and Walker, 1996), i.e., the linear systems are only solved accurately
+     * once the Newton method converges quickly. The safeguards prevent the forcing term
+     * from dropping too quickly, from exceeding the NewtonMaxForcingTerm parameter, from
+     * over-solving the last iteration (Kelley, 1995) and from being stricter than the
+     * LinearSolverTolerance parameter.
+     */
+    void updateLinearTolerance_()
+    {
+        if (!enableEisenstatWalker_() || fixedLinearTolerance_ <= 0.0)
+            return;
+
+        Scalar gamma = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonForcingTermGamma);
+        Scalar alpha = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonForcingTermAlpha);
+        Scalar etaMax = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxForcingTerm);
+
+        Scalar eta = etaMax;
+        if (numIterations_ > 0 && lastError_ > 0.0) {
+            eta = gamma*std::pow(error_/lastError_, alpha);
+
+            // if the previous forcing term was large, do not let the current one drop
+            // by more than the convergence rate of the Newton method
+            Scalar etaSafe = gamma*std::pow(forcingTerm_, alpha);
+            if (etaSafe > 0.1)
+                eta = std::max(eta, etaSafe);
+        }
+        eta = std::min(eta, etaMax);
+
+        // the linear solver does not need to reduce the error much below the Newton
+        // tolerance
+        if (error_ > 0.0)
+            eta = std::min(etaMax, std::max(eta, tolerance()/(2*error_)));
+
+        eta = std::max(eta, fixedLinearTolerance_);
+
+        forcingTerm_ = eta;
+        linearSolver_.setRelativeTolerance(eta);
+    }
+
+    /*!
+     * \brief Record the number of iterations which the linear solver needed in the
+     *        current Newton iteration.
+     */
+    void recordLinearIterations_(unsigned numLinearIterations)
+    {
+        linearIterations_.push_back(numLinearIterations);
+        totalLinearIterations_ += numLinearIterations;
+
+        if (!enableEisenstatWalker_() || fixedLinearTolerance_ <= 0.0)
+            return;
+
+        // estimate the number of iterations which would have been necessary to reach
+        // the fixed tolerance assuming that the linear solver converges at a constant
+        // rate
+        if (forcingTerm_ > fixedLinearTolerance_ && forcingTerm_ < 1.0) {
+            Scalar saved =
+                numLinearIterations
+                *(std::log(fixedLinearTolerance_)/std::log(forcingTerm_) - 1.0);
+            savedLinearIterations_ += saved;
+            totalSavedLinearIterations_ += saved;
+        }
+    }
+
     /*!
      * \brief Returns true iff another Newton iteration should be done.
      */
@@ -954,6 +1595,9 @@ protected:
     static bool enableConstraints_()
     { return GET_PROP_VALUE(TypeTag, EnableConstraints); }
 
+    static bool enableEisenstatWalker_()
+    { return EWOMS_GET_PARAM(TypeTag, bool, NewtonEnableEisenstatWalker); }
+
     Simulator& simulator_;
 
     Ewoms::Timer prePostProcessTimer_;
@@ -970,6 +1614,39 @@ protected:
     // actual number of iterations done so far
     int numIterations_;
 
+    // the number of iterations which were started by the last invocation of apply().
+    // unlike numIterations_, this is not modified if the Newton method fails.
+    unsigned numAttemptedIterations_;
+
+    // the number of iterations which assembled the Jacobian and which reused it
+    unsigned numFreshJacobians_;
+    unsigned numReusedJacobians_;
+    unsigned numConsecutiveJacobianReuses_;
+    bool jacobianReusePossible_;
+
+    // true if the line search is enabled and can be used for the current model
+    bool lineSearchPossible_;
+
+    // the number of iterations of the linear solver for each Newton iteration
+    std::vector<unsigned> linearIterations_;
+
+    // the step length accepted by the line search for each Newton iteration and the
+    // solution after the full update
+    std::vector<Scalar> stepLengths_;
+    SolutionVector fullStepSolution_;
+
+    // the residual reduction of the linear solver if the forcing terms are not used,
+    // the forcing term of the most recent iteration and the estimated number of linear
+    // iterations which were saved by the forcing terms
+    Scalar fixedLinearTolerance_;
+    Scalar forcingTerm_;
+    Scalar savedLinearIterations_;
+
+    // the number of linear iterations and the estimated savings of all invocations of
+    // the Newton method
+    unsigned long totalLinearIterations_;
+    Scalar totalSavedLinearIterations_;
+
     // the linear solver
     LinearSolverBackend linearSolver_;
 
@@ -977,6 +1654,10 @@ protected:
     // or MPI)
     CollectiveCommunication comm_;
 
+    // accumulates the flags and values which need to be communicated between the
+    // processes during a Newton iteration
+    CollectiveContext collectives_;
+
     // the object which writes the convergence behaviour of the Newton
     // method to disk
     ConvergenceWriter convergenceWriter_;
@@ -0,0 +1,305 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::CollectiveContext
+ */
+#ifndef EWOMS_COLLECTIVE_CONTEXT_HH
+#define EWOMS_COLLECTIVE_CONTEXT_HH
+
+#include <opm/material/common/Unused.hpp>
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief Defers collective reductions of scalar quantities and resolves all of them
+ *        using a single allreduce.
+ *
+ * Each process records whether it succeeded, local maxima and local summands. At a
+ * well defined synchronization point, resolve() packs all of them into a single
+ * buffer and reduces them using one MPI_Allreduce with a custom operation. Afterwards,
+ * failed() tells if any process recorded a failure and max() and sum() return the
+ * global values of the individual entries.
+ *
+ * Failures can be attributed to one of up to maxFailureReasons reasons, e.g., to the
+ * phase of an algorithm in which they occurred. This allows to report what went
+ * wrong without communicating any additional information.
+ *
+ * Adding a value after the context has been resolved implicitly starts a new batch,
+ * i.e., the indices of the entries then start from zero again.
+ */
+class CollectiveContext
+{
+public:
+    //! The maximum number of distinct reasons of failures
+    static const unsigned maxFailureReasons = 32;
+
+    /*!
+     * \brief Create a context which reduces over the processes of a communicator.
+     *
+     * \param comm The communicator, i.e., either an MPI_Comm or a collective
+     *             communication object of Dune like the one of gridView.comm(). If
+     *             the latter is not based on MPI, no communication takes place.
+     */
+    template <class Communicator>
+    explicit CollectiveContext(const Communicator& comm OPM_UNUSED_NOMPI)
+    {
+#if HAVE_MPI
+        comm_ = mpiComm_(comm, /*preferConversion=*/0);
+        reduceOp_ = MPI_OP_NULL;
+#endif
+        clear();
+    }
+
+    CollectiveContext(const CollectiveContext& other)
+    {
+#if HAVE_MPI
+        reduceOp_ = MPI_OP_NULL;
+#endif
+        *this = other;
+    }
+
+    ~CollectiveContext()
+    {
+#if HAVE_MPI
+        // the operation may only be freed as long as MPI is not yet finalized
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (reduceOp_ != MPI_OP_NULL && !finalized)
+            MPI_Op_free(&reduceOp_);
+#endif
+    }
+
+    CollectiveContext& operator=(const CollectiveContext& other)
+    {
+        if (this == &other)
+            return *this;
+
+#if HAVE_MPI
+        // the reduction operation is owned by each context, so it is not copied
+        comm_ = other.comm_;
+#endif
+        failures_ = other.failures_;
+        resolved_ = other.resolved_;
+        maxValues_ = other.maxValues_;
+        sumValues_ = other.sumValues_;
+        return *this;
+    }
+
+    /*!
+     * \brief Discard all entries.
+     */
+    void clear()
+    {
+        failures_ = 0;
+        resolved_ = false;
+        maxValues_.clear();
+        sumValues_.clear();
+    }
+
+    /*!
+     * \brief Record whether the local process succeeded.
+     *
+     * If any process records a failure, failed() will return true after the context
+     * has been resolved.
+     *
+     * \param failed Specifies whether the local process failed
+     * \param reason The reason of the failure, which must be smaller than
+     *               maxFailureReasons
+     */
+    void addFailure(bool failed = true, unsigned reason = 0)
+    {
+        assert(reason < maxFailureReasons);
+
+        startBatch_();
+        if (failed)
+            failures_ |= (1u << reason);
+    }
+
+    /*!
+     * \brief Add a value for which the maximum over all processes is required.
+     *
+     * The index of the entry is returned.
+     */
+    unsigned addMax(double value)
+    {
+        startBatch_();
+        maxValues_.push_back(value);
+        return static_cast<unsigned>(maxValues_.size() - 1);
+    }
+
+    /*!
+     * \brief Add a value for which the sum over all processes is required.
+     *
+     * The index of the entry is returned.
+     */
+    unsigned addSum(double value)
+    {
+        startBatch_();
+        sumValues_.push_back(value);
+        return static_cast<unsigned>(sumValues_.size() - 1);
+    }
+
+    /*!
+     * \brief Reduce all entries over all processes.
+     *
+     * This is a collective operation which needs to be called by all processes, and
+     * all processes need to have added the same number of maxima and summands.
+     */
+    void resolve()
+    {
+        resolved_ = true;
+
+#if HAVE_MPI
+        int numProcesses;
+        MPI_Comm_size(comm_, &numProcesses);
+        if (numProcesses == 1)
+            return;
+
+        // the layout of the buffer is [numMax, failures, maxima..., summands...]. the
+        // bit mask of the failures is combined by a bitwise or.
+        size_t numMax = maxValues_.size() + 1;
+        std::vector<double> buffer;
+        buffer.reserve(numMax + sumValues_.size() + 1);
+        buffer.push_back(static_cast<double>(numMax));
+        buffer.push_back(static_cast<double>(failures_));
+        buffer.insert(buffer.end(), maxValues_.begin(), maxValues_.end());
+        buffer.insert(buffer.end(), sumValues_.begin(), sumValues_.end());
+
+        if (reduceOp_ == MPI_OP_NULL)
+            MPI_Op_create(&reduce_, /*commute=*/1, &reduceOp_);
+
+        // the whole buffer is a single element of a contiguous data type, so the
+        // reduction operation always sees complete buffers
+        MPI_Datatype bufferType;
+        MPI_Type_contiguous(static_cast<int>(buffer.size()), MPI_DOUBLE, &bufferType);
+        MPI_Type_commit(&bufferType);
+        MPI_Allreduce(MPI_IN_PLACE, buffer.data(), /*count=*/1, bufferType, reduceOp_, comm_);
+        MPI_Type_free(&bufferType);
+
+        failures_ = static_cast<uint32_t>(buffer[1]);
+        std::copy(buffer.begin() + 2, buffer.begin() + 1 + numMax, maxValues_.begin());
+        std::copy(buffer.begin() + 1 + numMax, buffer.end(), sumValues_.begin());
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Returns true if any process recorded a failure.
+     *
+     * Before the context is resolved, this only considers the local process.
+     */
+    bool failed() const
+    { return failures_ != 0; }
+
+    /*!
+     * \brief Returns true if any process recorded a failure for a given reason.
+     *
+     * Before the context is resolved, this only considers the local process.
+     */
+    bool failed(unsigned reason) const
+    {
+        assert(reason < maxFailureReasons);
+        return (failures_ & (1u << reason)) != 0;
+    }
+
+    /*!
+     * \brief Returns the maximum of an entry over all processes.
+     */
+    double max(unsigned idx) const
+    {
+        assert(resolved_);
+        return maxValues_[idx];
+    }
+
+    /*!
+     * \brief Returns the sum of an entry over all processes.
+     */
+    double sum(unsigned idx) const
+    {
+        assert(resolved_);
+        return sumValues_[idx];
+    }
+
+private:
+    void startBatch_()
+    {
+        if (resolved_)
+            clear();
+    }
+
+#if HAVE_MPI
+    // use the MPI communicator of the argument if it can be converted to one. this is
+    // the case for MPI_Comm itself and for the MPI based collective communication of
+    // Dune. else, the communication is not based on MPI, i.e., it is sequential.
+    template <class Communicator>
+    static auto mpiComm_(const Communicator& comm, int)
+        -> decltype(static_cast<MPI_Comm>(comm))
+    { return static_cast<MPI_Comm>(comm); }
+
+    template <class Communicator>
+    static MPI_Comm mpiComm_(const Communicator&, long)
+    { return MPI_COMM_SELF; }
+
+    static void reduce_(void* in, void* inOut, int* len, MPI_Datatype* dataType)
+    {
+        int typeSize;
+        MPI_Type_size(*dataType, &typeSize);
+        size_t bufferSize = static_cast<size_t>(typeSize)/sizeof(double);
+
+        for (int i = 0; i < *len; ++i) {
+            const double* a = static_cast<const double*>(in) + i*bufferSize;
+            double* b = static_cast<double*>(inOut) + i*bufferSize;
+
+            size_t numMax = static_cast<size_t>(a[0]);
+            b[1] = static_cast<double>(static_cast<uint32_t>(a[1]) | static_cast<uint32_t>(b[1]));
+            for (size_t j = 2; j < 1 + numMax; ++j)
+                // make sure that NaNs are not swallowed
+                if (a[j] > b[j] || std::isnan(a[j]))
+                    b[j] = a[j];
+            for (size_t j = 1 + numMax; j < bufferSize; ++j)
+                b[j] += a[j];
+        }
+    }
+
+    MPI_Comm comm_;
+    MPI_Op reduceOp_;
+#endif // HAVE_MPI
+
+    uint32_t failures_; // bit mask of the reasons for which failures were recorded
+    bool resolved_;
+    std::vector<double> maxValues_;
+    std::vector<double> sumValues_;
+};
+} // namespace Ewoms
+
+#endif
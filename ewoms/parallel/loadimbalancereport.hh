@@ -0,0 +1,198 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::LoadImbalanceReport
+ */
+#ifndef EWOMS_LOAD_IMBALANCE_REPORT_HH
+#define EWOMS_LOAD_IMBALANCE_REPORT_HH
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief Reports how evenly the time spent in the phases of the solver is distributed
+ *        among the processes.
+ *
+ * Each process adds the wall clock time it spent in each phase. These are then exchanged
+ * using a single gather operation, after which the first process knows the minimum,
+ * average and maximum time of each phase, the imbalance factor (i.e., the ratio of the
+ * maximum and the average time) and the ranks of the slowest processes. Note that all
+ * processes must add the same phases in the same order.
+ */
+class LoadImbalanceReport
+{
+public:
+    /*!
+     * \brief The statistics of a single phase across all processes.
+     */
+    struct PhaseStatistics
+    {
+        std::string name;
+        double min;
+        double avg;
+        double max;
+
+        //! The ranks of the slowest processes, slowest first
+        std::vector<int> slowestRanks;
+
+        /*!
+         * \brief Returns the ratio of the maximum and the average time.
+         *
+         * A value of 1 means that the phase is perfectly balanced.
+         */
+        double imbalance() const
+        { return (avg > 0.0) ? max/avg : 1.0; }
+    };
+
+    explicit LoadImbalanceReport(unsigned numSlowestRanks = 3)
+        : numSlowestRanks_(numSlowestRanks)
+    { }
+
+    /*!
+     * \brief Add the time which the local process spent in a phase.
+     */
+    void addPhase(const std::string& name, double localTime)
+    {
+        names_.push_back(name);
+        localTimes_.push_back(localTime);
+    }
+
+    /*!
+     * \brief Collect the times of all processes on the first rank.
+     *
+     * This is a collective operation. The statistics are only available on the first
+     * rank afterwards.
+     */
+    template <class CollectiveCommunication>
+    void gather(const CollectiveCommunication& comm)
+    {
+        int numPhases = static_cast<int>(localTimes_.size());
+        int numRanks = comm.size();
+
+        std::vector<double> allTimes;
+        if (comm.rank() == 0)
+            allTimes.resize(static_cast<size_t>(numPhases*numRanks));
+        comm.gather(localTimes_.data(), allTimes.data(), numPhases, /*root=*/0);
+
+        statistics_.clear();
+        if (comm.rank() != 0)
+            return;
+
+        std::vector<int> ranks(static_cast<size_t>(numRanks));
+        for (int phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            // the times of the phase on all ranks
+            const auto& timeOf =
+                [&](int rank) -> double
+                { return allTimes[static_cast<size_t>(rank*numPhases + phaseIdx)]; };
+
+            PhaseStatistics stats;
+            stats.name = names_[static_cast<size_t>(phaseIdx)];
+            stats.min = timeOf(0);
+            stats.max = timeOf(0);
+            stats.avg = 0.0;
+            for (int rank = 0; rank < numRanks; ++rank) {
+                stats.min = std::min(stats.min, timeOf(rank));
+                stats.max = std::max(stats.max, timeOf(rank));
+                stats.avg += timeOf(rank);
+            }
+            stats.avg /= numRanks;
+
+            std::iota(ranks.begin(), ranks.end(), 0);
+            unsigned numSlowest = std::min(numSlowestRanks_, static_cast<unsigned>(numRanks));
+            std::partial_sort(ranks.begin(), ranks.begin() + numSlowest, ranks.end(),
+                              [&](int a, int b) -> bool
+                              { return timeOf(a) > timeOf(b); });
+            stats.slowestRanks.assign(ranks.begin(), ranks.begin() + numSlowest);
+
+            statistics_.push_back(stats);
+        }
+    }
+
+    /*!
+     * \brief Returns the statistics of all phases after gather() has been called.
+     *
+     * This is empty on all ranks except the first one.
+     */
+    const std::vector<PhaseStatistics>& statistics() const
+    { return statistics_; }
+
+    /*!
+     * \brief Print a table with the statistics of all phases.
+     */
+    void print(std::ostream& os) const
+    {
+        os << std::left << std::setw(24) << "Phase" << std::right
+           << std::setw(12) << "min [s]"
+           << std::setw(12) << "avg [s]"
+           << std::setw(12) << "max [s]"
+           << std::setw(10) << "max/avg"
+           << "  slowest ranks\n";
+        for (const auto& stats : statistics_) {
+            os << std::left << std::setw(24) << stats.name << std::right
+               << std::fixed << std::setprecision(3)
+               << std::setw(12) << stats.min
+               << std::setw(12) << stats.avg
+               << std::setw(12) << stats.max
+               << std::setprecision(2)
+               << std::setw(10) << stats.imbalance()
+               << " ";
+            for (int rank : stats.slowestRanks)
+                os << " " << rank;
+            os << "\n";
+        }
+        os.unsetf(std::ios_base::floatfield);
+    }
+
+    /*!
+     * \brief Print the imbalance factor and the slowest rank of each phase on a single
+     *        line.
+     */
+    void printCompact(std::ostream& os) const
+    {
+        const char* sep = "";
+        for (const auto& stats : statistics_) {
+            os << sep << stats.name << ": " << std::setprecision(3) << stats.imbalance();
+            if (!stats.slowestRanks.empty())
+                os << " (rank " << stats.slowestRanks.front() << ")";
+            sep = ", ";
+        }
+        os << "\n";
+    }
+
+private:
+    unsigned numSlowestRanks_;
+
+    std::vector<std::string> names_;
+    std::vector<double> localTimes_;
+    std::vector<PhaseStatistics> statistics_;
+};
+} // namespace Ewoms
+
+#endif
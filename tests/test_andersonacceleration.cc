@@ -0,0 +1,181 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Solves a small non-linear system of equations using an inexact Newton method
+ *        and checks that Ewoms::AndersonAcceleration reduces the error.
+ */
+#include "config.h"
+
+#include <ewoms/nonlinear/andersonacceleration.hh>
+
+#include <dune/common/fvector.hh>
+#include <dune/istl/bvector.hh>
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+static const unsigned numBlocks = 10;
+static const unsigned blockSize = 2;
+
+typedef Dune::FieldVector<double, blockSize> Block;
+typedef Dune::BlockVector<Block> Vector;
+typedef Ewoms::AndersonAcceleration<Vector, Vector> Anderson;
+
+static void check(bool condition, const std::string& message)
+{
+    if (!condition)
+        throw std::logic_error(message);
+}
+
+// the residual of a discretized reaction-diffusion problem with a cubic source term.
+// all unknowns are coupled to their neighbours in a chain.
+static double residual(const Vector& x, unsigned blockIdx, unsigned k)
+{
+    unsigned i = blockIdx*blockSize + k;
+    unsigned n = numBlocks*blockSize;
+
+    const auto value = [&x](unsigned j) -> double
+    { return x[j/blockSize][j%blockSize]; };
+
+    double result = 2.5*value(i) + 0.1*std::pow(value(i), 3) - 1.0;
+    if (i > 0)
+        result -= value(i - 1);
+    if (i + 1 < n)
+        result -= value(i + 1);
+    return result;
+}
+
+static double residualNorm(const Vector& x)
+{
+    double result = 0.0;
+    for (unsigned blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+        for (unsigned k = 0; k < blockSize; ++k)
+            result += std::pow(residual(x, blockIdx, k), 2);
+    return std::sqrt(result);
+}
+
+// the Newton update if only the diagonal of the Jacobian matrix is considered. this
+// makes the Newton method converge only linearly.
+static void inexactNewtonUpdate(Vector& deltaX, const Vector& x)
+{
+    for (unsigned blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+        for (unsigned k = 0; k < blockSize; ++k)
+            deltaX[blockIdx][k] =
+                residual(x, blockIdx, k)/(2.5 + 0.3*std::pow(x[blockIdx][k], 2));
+}
+
+// returns the norm of the residual after a given number of iterations
+static double solve(unsigned andersonDepth, unsigned numIterations)
+{
+    Anderson anderson(andersonDepth);
+
+    Vector x(numBlocks);
+    Vector deltaX(numBlocks);
+    Vector acceleratedDeltaX(numBlocks);
+    x = 0.0;
+
+    const auto compatible = [](unsigned, const Block&, const Block&) -> bool
+    { return true; };
+    const auto weight = [](unsigned, unsigned) -> double
+    { return 1.0; };
+    const auto globalSum = [](double*, int) {};
+
+    for (unsigned iterIdx = 0; iterIdx < numIterations; ++iterIdx) {
+        inexactNewtonUpdate(deltaX, x);
+        anderson.push(x, deltaX, compatible);
+        if (anderson.accelerate(acceleratedDeltaX, deltaX, weight, globalSum))
+            x -= acceleratedDeltaX;
+        else
+            x -= deltaX;
+    }
+
+    return residualNorm(x);
+}
+
+int main()
+{
+    try {
+        const unsigned numIterations = 15;
+
+        double plainError = solve(/*andersonDepth=*/0, numIterations);
+        double acceleratedError = solve(/*andersonDepth=*/5, numIterations);
+        std::cout << "residual after " << numIterations << " iterations: "
+                  << plainError << " (plain), "
+                  << acceleratedError << " (Anderson accelerated)\n";
+
+        check(std::isfinite(acceleratedError), "the accelerated iteration diverged");
+        check(acceleratedError < 1e-3*plainError,
+              "the Anderson acceleration did not reduce the error");
+
+        // blocks which are not compatible with the previous iterate must be updated
+        // by the plain step
+        Anderson anderson(/*depth=*/3);
+        Vector x(numBlocks);
+        Vector deltaX(numBlocks);
+        Vector acceleratedDeltaX(numBlocks);
+        x = 0.0;
+
+        const auto compatible = [](unsigned blockIdx, const Block&, const Block&) -> bool
+        { return blockIdx != 3; };
+        for (unsigned iterIdx = 0; iterIdx < 3; ++iterIdx) {
+            inexactNewtonUpdate(deltaX, x);
+            anderson.push(x, deltaX, compatible);
+            if (iterIdx == 0)
+                check(anderson.historySize() == 0, "wrong size of the history");
+            x -= deltaX;
+        }
+        check(anderson.historySize() == 2, "wrong size of the history");
+        check(anderson.isExcluded(3) && !anderson.isExcluded(2),
+              "wrong blocks excluded from the acceleration");
+
+        inexactNewtonUpdate(deltaX, x);
+        anderson.push(x, deltaX, compatible);
+        bool accelerated =
+            anderson.accelerate(acceleratedDeltaX, deltaX,
+                                [](unsigned, unsigned) -> double { return 1.0; },
+                                [](double*, int) {});
+        check(accelerated, "no accelerated update computed");
+        for (unsigned k = 0; k < blockSize; ++k)
+            check(acceleratedDeltaX[3][k] == deltaX[3][k],
+                  "an excluded block was accelerated");
+
+        // on a process without degrees of freedom, the history must grow like on all
+        // other processes
+        Anderson emptyAnderson(/*depth=*/3);
+        Vector empty(0);
+        emptyAnderson.push(empty, empty, compatible);
+        check(emptyAnderson.historySize() == 0, "wrong size of the history of an empty vector");
+        emptyAnderson.push(empty, empty, compatible);
+        check(emptyAnderson.historySize() == 1, "wrong size of the history of an empty vector");
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Writes a few time steps using Ewoms::TimeSeriesWriter and reads them back
+ *        using Ewoms::TimeSeriesReader.
+ */
+#include "config.h"
+
+#include <ewoms/io/timeserieswriter.hh>
+#include <ewoms/io/timeseriesreader.hh>
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// a minimal replacement for Ewoms::Restart which keeps the data in memory
+class MemoryRestarter
+{
+public:
+    void serializeSectionBegin(const std::string&) {}
+    void serializeSectionEnd() {}
+    std::ostream& serializeStream() { return stream_; }
+
+    void deserializeSectionBegin(const std::string&) {}
+    void deserializeSectionEnd() {}
+    std::istream& deserializeStream() { return stream_; }
+
+private:
+    std::stringstream stream_;
+};
+
+static void check(bool condition, const std::string& message)
+{
+    if (!condition)
+        throw std::logic_error(message);
+}
+
+static double scalarValue(unsigned stepIdx, size_t entityIdx)
+{ return 1000.0*stepIdx + static_cast<double>(entityIdx) + 0.25; }
+
+static double vectorValue(unsigned stepIdx, size_t entityIdx, unsigned compIdx)
+{ return -100.0*stepIdx + 10.0*static_cast<double>(entityIdx) + compIdx; }
+
+static double tensorValue(unsigned stepIdx, size_t entityIdx, unsigned i, unsigned j)
+{ return 1e-3*stepIdx + static_cast<double>(entityIdx) + 0.1*i + 0.01*j; }
+
+static const size_t numVertices = 7;
+static const size_t numElements = 5;
+
+// write a time step. the vector field is omitted for odd time steps
+static void writeTimeStep(Ewoms::TimeSeriesWriter& writer, unsigned stepIdx, bool discard = false)
+{
+    typedef Ewoms::BaseOutputWriter BOW;
+
+    writer.beginWrite(10.0*stepIdx);
+
+    BOW::ScalarBuffer pressure(numVertices);
+    for (size_t i = 0; i < numVertices; ++i)
+        pressure[i] = scalarValue(stepIdx, i);
+    writer.attachScalarVertexData(pressure, "pressure");
+
+    if (stepIdx%2 == 0) {
+        BOW::VectorBuffer velocity(numElements, BOW::Vector(2));
+        for (size_t i = 0; i < numElements; ++i)
+            for (unsigned k = 0; k < 2; ++k)
+                velocity[i][k] = vectorValue(stepIdx, i, k);
+        writer.attachVectorElementData(velocity, "velocity");
+    }
+
+    BOW::TensorBuffer permeability(numElements, BOW::Tensor(2, 3));
+    for (size_t i = 0; i < numElements; ++i)
+        for (unsigned k = 0; k < 2; ++k)
+            for (unsigned l = 0; l < 3; ++l)
+                permeability[i][k][l] = tensorValue(stepIdx, i, k, l);
+    writer.attachTensorElementData(permeability, "permeability");
+
+    writer.endWrite(/*onlyDiscard=*/discard);
+}
+
+static void checkFile(const std::string& fileName, unsigned numSteps)
+{
+    Ewoms::TimeSeriesReader reader(fileName);
+
+    check(reader.numTimeSteps() == numSteps, "wrong number of time steps");
+    check(reader.numFields() == 3, "wrong number of fields");
+
+    int pressureIdx = reader.fieldIndex("pressure");
+    int velocityIdx = reader.fieldIndex("velocity");
+    int permeabilityIdx = reader.fieldIndex("permeability");
+    check(pressureIdx >= 0 && velocityIdx >= 0 && permeabilityIdx >= 0, "missing field");
+    check(reader.fieldIndex("temperature") == -1, "non-existing field was found");
+
+    check(reader.field(pressureIdx).kind == Ewoms::TimeSeriesFormat::VertexEntity,
+          "wrong entity kind of a scalar field");
+    check(reader.field(pressureIdx).numComponents == 1, "wrong number of components of a scalar field");
+    check(reader.field(velocityIdx).kind == Ewoms::TimeSeriesFormat::ElementEntity,
+          "wrong entity kind of a vector field");
+    check(reader.field(velocityIdx).numComponents == 2, "wrong number of components of a vector field");
+    check(reader.field(permeabilityIdx).numComponents == 6, "wrong number of components of a tensor field");
+
+    for (unsigned stepIdx = 0; stepIdx < numSteps; ++stepIdx) {
+        check(reader.time(stepIdx) == 10.0*stepIdx, "wrong time of a time step");
+
+        check(reader.numEntities(pressureIdx, stepIdx) == numVertices, "wrong number of vertices");
+        const double* pressure = reader.data(pressureIdx, stepIdx);
+        for (size_t i = 0; i < numVertices; ++i)
+            check(pressure[i] == scalarValue(stepIdx, i), "wrong value of a scalar field");
+
+        if (stepIdx%2 == 0) {
+            check(reader.hasData(velocityIdx, stepIdx), "missing vector field");
+            const double* velocity = reader.data(velocityIdx, stepIdx);
+            for (size_t i = 0; i < numElements; ++i)
+                for (unsigned k = 0; k < 2; ++k)
+                    check(velocity[i*2 + k] == vectorValue(stepIdx, i, k), "wrong value of a vector field");
+        }
+        else
+            check(!reader.hasData(velocityIdx, stepIdx) && !reader.data(velocityIdx, stepIdx),
+                  "vector field exists although it was not written");
+
+        const double* permeability = reader.data(permeabilityIdx, stepIdx);
+        for (size_t i = 0; i < numElements; ++i)
+            for (unsigned k = 0; k < 2; ++k)
+                for (unsigned l = 0; l < 3; ++l)
+                    check(permeability[i*6 + k*3 + l] == tensorValue(stepIdx, i, k, l),
+                          "wrong value of a tensor field");
+    }
+
+    // time history of a single entity
+    const auto& history = reader.timeHistory(static_cast<size_t>(velocityIdx), /*entityIdx=*/3, /*compIdx=*/1);
+    check(history.size() == numSteps, "wrong length of the time history");
+    for (unsigned stepIdx = 0; stepIdx < numSteps; ++stepIdx) {
+        if (stepIdx%2 == 0)
+            check(history[stepIdx] == vectorValue(stepIdx, 3, 1), "wrong value in the time history");
+        else
+            check(std::isnan(history[stepIdx]), "time history does not indicate missing data");
+    }
+}
+
+int main()
+{
+    try {
+        std::string fileName = Ewoms::TimeSeriesWriter::fileName(".", "test_timeseries", 0, 1);
+
+        MemoryRestarter restarter;
+        {
+            Ewoms::TimeSeriesWriter writer(".", "test_timeseries");
+            writeTimeStep(writer, 0);
+            writeTimeStep(writer, 1);
+            writeTimeStep(writer, 2);
+            writeTimeStep(writer, 3, /*discard=*/true);
+            check(writer.numTimeSteps() == 3, "wrong number of time steps written");
+
+            // the file can be read while it is still being written
+            checkFile(fileName, 3);
+
+            writer.serialize(restarter);
+
+            writeTimeStep(writer, 3);
+            writeTimeStep(writer, 4);
+            checkFile(fileName, 5);
+        }
+
+        // restart after the third time step: the time steps written afterwards must be
+        // replaced
+        {
+            Ewoms::TimeSeriesWriter writer(".", "test_timeseries");
+            writer.deserialize(restarter);
+            check(writer.numTimeSteps() == 3, "wrong number of time steps after restart");
+            checkFile(fileName, 3);
+
+            writeTimeStep(writer, 3);
+            checkFile(fileName, 4);
+        }
+
+        std::remove(fileName.c_str());
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Prints the contents of a time series file written by Ewoms::TimeSeriesWriter.
+ */
+#include <ewoms/io/timeseriesreader.hh>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace {
+void printUsage(const char* progName)
+{
+    std::cout << "Prints the contents of a time series (.ets) file\n"
+              << "\n"
+              << "Usage: " << progName << " FILENAME [FIELD [ENTITY_INDEX [COMPONENT_INDEX]]]\n"
+              << "\n"
+              << "If only the file name is given, the time steps and fields of the file are listed.\n"
+              << "Otherwise the time history of a single component of the field for the given\n"
+              << "entity is printed as comma separated values.\n";
+}
+
+void printSummary(const Ewoms::TimeSeriesReader& reader)
+{
+    std::cout << "Time steps: " << reader.numTimeSteps() << "\n";
+    for (size_t stepIdx = 0; stepIdx < reader.numTimeSteps(); ++stepIdx)
+        std::cout << "  " << stepIdx << ": t=" << reader.time(stepIdx) << "\n";
+
+    std::cout << "Fields: " << reader.numFields() << "\n";
+    for (size_t fieldIdx = 0; fieldIdx < reader.numFields(); ++fieldIdx) {
+        const auto& field = reader.field(fieldIdx);
+        size_t numSteps = 0;
+        size_t numEntities = 0;
+        for (size_t stepIdx = 0; stepIdx < reader.numTimeSteps(); ++stepIdx) {
+            if (reader.hasData(fieldIdx, stepIdx)) {
+                ++numSteps;
+                numEntities = reader.numEntities(fieldIdx, stepIdx);
+            }
+        }
+
+        std::cout << "  " << field.name
+                  << " (" << (field.kind == Ewoms::TimeSeriesFormat::VertexEntity ? "vertex" : "element")
+                  << ", " << field.numComponents << " components"
+                  << ", " << numEntities << " entities"
+                  << ", written in " << numSteps << " time steps)\n";
+    }
+}
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 5) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        Ewoms::TimeSeriesReader reader(argv[1]);
+
+        if (argc == 2) {
+            printSummary(reader);
+            return 0;
+        }
+
+        int fieldIdx = reader.fieldIndex(argv[2]);
+        if (fieldIdx < 0) {
+            std::cerr << "Field '" << argv[2] << "' does not exist in file '" << argv[1] << "'\n";
+            return 1;
+        }
+
+        size_t entityIdx = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 0;
+        unsigned compIdx = (argc > 4) ? static_cast<unsigned>(std::strtoul(argv[4], nullptr, 10)) : 0;
+
+        const auto& history = reader.timeHistory(static_cast<size_t>(fieldIdx), entityIdx, compIdx);
+        std::cout << std::setprecision(std::numeric_limits<double>::digits10 + 2);
+        std::cout << "time," << argv[2] << "\n";
+        for (size_t stepIdx = 0; stepIdx < history.size(); ++stepIdx)
+            std::cout << reader.time(stepIdx) << "," << history[stepIdx] << "\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}